@@ -0,0 +1,144 @@
+"""Thin ctypes bindings over the C interface of the attack (`src/aes_single_fault_attack.h`).
+
+States are passed as any 16 bytes buffer (`bytes`, `bytearray`, `memoryview`, numpy `uint8` arrays, ...).
+Candidate keys are returned as a `(n, 16)` numpy `uint8` array when numpy is available, as a list of
+`bytes` otherwise.
+
+The shared library is looked up in `$AES_SINGLE_FAULT_ATTACK_LIB`, then next to this file, then in the
+repository root.
+"""
+
+import ctypes
+import os
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+STATE_SIZE = 16
+LIBRARY_NAME = "libaes-single-fault-attack.so"
+
+INITIAL_KEY = 0
+LAST_ROUND_KEY = 1
+
+ENGINE_SWEEP = 0
+ENGINE_JOIN = 1
+ENGINE_AUTO = 2
+
+
+class _Options(ctypes.Structure):
+    _fields_ = [
+        ("threads", ctypes.c_int),
+        ("plaintext", ctypes.c_void_p),
+        ("key_kind", ctypes.c_int),
+        ("engine", ctypes.c_int),
+    ]
+
+
+class AttackError(RuntimeError):
+    pass
+
+
+def _load_library():
+    here = os.path.dirname(os.path.abspath(__file__))
+    candidates = [
+        os.environ.get("AES_SINGLE_FAULT_ATTACK_LIB"),
+        os.path.join(here, LIBRARY_NAME),
+        os.path.join(here, os.pardir, LIBRARY_NAME),
+    ]
+
+    for path in candidates:
+        if path and os.path.exists(path):
+            return ctypes.CDLL(path)
+
+    raise OSError(f"cannot find {LIBRARY_NAME}, set AES_SINGLE_FAULT_ATTACK_LIB")
+
+
+_lib = _load_library()
+
+_lib.asfa_init_options.argtypes = [ctypes.POINTER(_Options)]
+_lib.asfa_init_options.restype = None
+_lib.asfa_attack.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_uint, ctypes.POINTER(_Options), ctypes.POINTER(ctypes.c_void_p)]
+_lib.asfa_attack.restype = ctypes.c_int
+_lib.asfa_result_size.argtypes = [ctypes.c_void_p]
+_lib.asfa_result_size.restype = ctypes.c_size_t
+_lib.asfa_result_copy.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t]
+_lib.asfa_result_copy.restype = ctypes.c_size_t
+_lib.asfa_free_result.argtypes = [ctypes.c_void_p]
+_lib.asfa_free_result.restype = None
+_lib.asfa_status_string.argtypes = [ctypes.c_int]
+_lib.asfa_status_string.restype = ctypes.c_char_p
+
+
+def _state(buffer, name):
+    data = bytes(memoryview(buffer).cast("B"))
+    if len(data) != STATE_SIZE:
+        raise ValueError(f"{name} must be {STATE_SIZE} bytes long, got {len(data)}")
+    return data
+
+
+def _keys(raw, count):
+    if np is not None:
+        return np.frombuffer(raw, dtype=np.uint8, count=count * STATE_SIZE).reshape(count, STATE_SIZE).copy()
+    return [bytes(raw[i * STATE_SIZE:(i + 1) * STATE_SIZE]) for i in range(count)]
+
+
+def attack(regular, faulted, fault_position, plaintext=None, threads=0, key_kind=INITIAL_KEY, engine=ENGINE_AUTO):
+    """Run the attack on one capture and return the candidate keys."""
+    regular = _state(regular, "regular")
+    faulted = _state(faulted, "faulted")
+
+    options = _Options()
+    _lib.asfa_init_options(ctypes.byref(options))
+    options.threads = threads
+    options.key_kind = key_kind
+    options.engine = engine
+
+    plaintext_buffer = None
+    if plaintext is not None:
+        plaintext_buffer = ctypes.create_string_buffer(_state(plaintext, "plaintext"), STATE_SIZE)
+        options.plaintext = ctypes.cast(plaintext_buffer, ctypes.c_void_p)
+
+    result = ctypes.c_void_p()
+    status = _lib.asfa_attack(regular, faulted, int(fault_position), ctypes.byref(options), ctypes.byref(result))
+    if status != 0:
+        raise AttackError(_lib.asfa_status_string(status).decode())
+
+    try:
+        count = _lib.asfa_result_size(result)
+        raw = ctypes.create_string_buffer(count * STATE_SIZE)
+        _lib.asfa_result_copy(result, raw, count)
+        return _keys(raw.raw, count)
+    finally:
+        _lib.asfa_free_result(result)
+
+
+def attack_batch(regular, faulted, fault_positions, plaintexts=None, threads=0, key_kind=INITIAL_KEY, engine=ENGINE_AUTO):
+    """Run the attack on every capture of a batch.
+
+    `regular` and `faulted` hold `n` states back to back (e.g. `(n, 16)` uint8 arrays),
+    `fault_positions` holds `n` integers and `plaintexts`, if given, `n` states.
+    Return a list with the candidate keys of each capture.
+    """
+    regular = bytes(memoryview(regular).cast("B"))
+    faulted = bytes(memoryview(faulted).cast("B"))
+    fault_positions = [int(p) for p in fault_positions]
+
+    count = len(fault_positions)
+    if len(regular) != count * STATE_SIZE or len(faulted) != count * STATE_SIZE:
+        raise ValueError("regular and faulted must hold one state per fault position")
+
+    if plaintexts is not None:
+        plaintexts = bytes(memoryview(plaintexts).cast("B"))
+        if len(plaintexts) != count * STATE_SIZE:
+            raise ValueError("plaintexts must hold one state per fault position")
+
+    def chunk(data, i):
+        return data[i * STATE_SIZE:(i + 1) * STATE_SIZE]
+
+    return [
+        attack(chunk(regular, i), chunk(faulted, i), fault_positions[i],
+               None if plaintexts is None else chunk(plaintexts, i), threads, key_kind, engine)
+        for i in range(count)
+    ]
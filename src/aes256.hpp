@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+#include "reductions.hpp"
+
+using namespace std;
+
+/**
+ * AES-256 recovery from faults injected in two different rounds.
+ *
+ * The last two round keys of AES-256 are independent, so a fault at the round 12 entry, the counterpart of the
+ * AES-128 round 8 one, only goes through the first stage: the second stage would need K13 to check the round 13
+ * equations. Its first stage pins K14 down to 2^32 candidates; a second round 12 fault, or hints, to a single one.
+ *
+ * With K14 known, the last round peels off: InvMixColumns of the round 13 output is
+ *
+ *      SR(SB(S13)) xor InvMixColumns(K13)
+ *
+ * i.e. an AES-128 style last round of key L = InvMixColumns(K13). A fault at the round 11 entry then goes through the
+ * unchanged first stage and the second stage sweep, the round 12 key standing for the round 9 one: K12 is linear in K14
+ * apart from SubWord(RotWord(K13[3])) xor RCON, and K13[3] is linear in L (`key_relation`). Each phase thus stays
+ * around 2^32 work rather than 2^64.
+ */
+namespace aes256 {
+    using Key = array<u8, 32>;
+
+    /**
+     * @brief A faulted encryption: regular and faulted ciphertexts, and the fault position at the entry of its round.
+     */
+    struct Capture {
+        FlatState regular;
+        FlatState faulted;
+        size_t fault_position;
+    };
+
+    // each of them costs a 2^32 sweep
+    constexpr size_t MAX_LAST_ROUND_KEYS = 16;
+
+    /**
+     * @brief Round 14 key antidiagonal values consistent with every round 12 fault of `round12` and with `hints`.
+     */
+    inline array<vector<Row>, 4> last_round_key_rows(vector<Capture> const& round12, KeyHints const& hints) {
+        array<vector<Row>, 4> rows;
+
+        for (size_t c = 0; c < round12.size(); ++c) {
+            auto const& capture = round12[c];
+            auto stage1_results = first_stage::reduction(capture.regular, capture.faulted, capture.fault_position, hints);
+
+            for (size_t d = 0; d < 4; ++d) {
+                auto& found = stage1_results[d];
+                sort(found.begin(), found.end());
+                found.erase(unique(found.begin(), found.end()), found.end());
+
+                if (c == 0) {
+                    rows[d] = move(found);
+                } else {
+                    vector<Row> common;
+                    set_intersection(rows[d].begin(), rows[d].end(), found.begin(), found.end(), back_inserter(common));
+                    rows[d] = move(common);
+                }
+            }
+        }
+
+        return rows;
+    }
+
+    /**
+     * @brief Round 14 key candidates of the round 12 faults `round12`.
+     *
+     * @return false, `error` telling why, if more than `MAX_LAST_ROUND_KEYS` candidates are left
+     */
+    inline bool last_round_keys(vector<Capture> const& round12, KeyHints const& hints, vector<FlatState>& keys, string& error) {
+        auto rows = last_round_key_rows(round12, hints);
+
+        double count = 1;
+        for (auto const& r : rows) count *= r.size();
+
+        if (count > MAX_LAST_ROUND_KEYS) {
+            error = to_string((uint64_t) count) + " round 14 key candidates left, more round 12 faults or hints are needed";
+            return false;
+        }
+
+        keys.clear();
+        for (auto const& ad1 : rows[0])
+            for (auto const& ad2 : rows[1])
+                for (auto const& ad3 : rows[2])
+                    for (auto const& ad4 : rows[3])
+                        keys.push_back(second_stage::make_key(ad1, ad2, ad3, ad4));
+
+        return true;
+    }
+
+    inline __m128i mix_columns(__m128i x) {
+        // ShiftRows and SubBytes commute, `aesenc` undoes the `aesdeclast` ones
+        return _mm_aesenc_si128(_mm_aesdeclast_si128(x, _mm_setzero_si128()), _mm_setzero_si128());
+    }
+
+    /**
+     * @brief InvMixColumns of the round 13 output state of ciphertext `Y` under round 14 key `k14`.
+     */
+    inline FlatState peel_last_round(FlatState const& Y, __m128i k14) {
+        return unload(_mm_aesimc_si128(_mm_aesdeclast_si128(_mm_xor_si128(load(Y), k14), _mm_setzero_si128())));
+    }
+
+    /**
+     * @brief Contribution of a first stage `Row` of L = InvMixColumns(K13) to L and to K13[3] = MixColumns(L)[3].
+     */
+    inline second_stage::KeyContribution get_key_contribution(Row const& row, size_t antidiag) {
+        FlatState L {};
+        for (size_t i = 0; i < 4; ++i) L[ANTIDIAGONALS[antidiag][i]] = row[i];
+
+        second_stage::KeyContribution c;
+        c.k10   = load(L);
+        c.k9imc = _mm_setzero_si128();
+
+        auto K13 = unload(mix_columns(c.k10));
+        c.x = (uint32_t) K13[12] | (uint32_t) K13[13] << 8 | (uint32_t) K13[14] << 16 | (uint32_t) K13[15] << 24;
+
+        return c;
+    }
+
+    /**
+     * @brief Relation of the peeled cipher between L = InvMixColumns(K13) and InvMixColumns(K12), given `k14`.
+     *
+     * K12 = [K14[0] xor SubWord(RotWord(K13[3])) xor RCON, K14[1] xor K14[0], K14[2] xor K14[1], K14[3] xor K14[2]]
+     */
+    inline second_stage::KeyRelation key_relation(__m128i k14) {
+        second_stage::KeyRelation relation;
+        relation.contribution = get_key_contribution;
+        relation.offset = _mm_aesimc_si128(_mm_xor_si128(k14, _mm_slli_si128(k14, 4)));
+        relation.rcon = 0x40;
+
+        return relation;
+    }
+
+    /**
+     * @brief Round 13 key candidates, about 256, of the round 11 fault `round11` under round 14 key `K14`.
+     *
+     * @param settings kernel, threads and schedule of the second stage sweep (there is no join for AES-256)
+     */
+    inline vector<FlatState> penultimate_round_keys(Capture const& round11, FlatState const& K14, second_stage::Settings const& settings) {
+        __m128i k14 = load(K14);
+        auto Y  = peel_last_round(round11.regular, k14);
+        auto Y_ = peel_last_round(round11.faulted, k14);
+
+        auto stage1_results = first_stage::reduction(Y, Y_, round11.fault_position);
+
+        vector<FlatState> keys;
+        for (auto const& L : second_stage::reduction(Y, Y_, round11.fault_position, stage1_results, settings, nullptr, key_relation(k14)))
+            keys.push_back(unload(mix_columns(load(L))));
+
+        return keys;
+    }
+
+    inline Key get_initial_key(FlatState const& K13, FlatState const& K14) {
+        auto keys = key_schedule_from_last_round_keys(load(K13), load(K14));
+
+        Key K;
+        _mm_storeu_si128((__m128i *) K.data(), keys[0]);
+        _mm_storeu_si128((__m128i *) (K.data() + 16), keys[1]);
+
+        return K;
+    }
+
+    inline array<FlatState, 2> get_last_round_keys(Key const& K) {
+        auto keys = key_schedule_256(_mm_loadu_si128((__m128i *) K.data()), _mm_loadu_si128((__m128i *) (K.data() + 16)));
+
+        return {unload(keys[13]), unload(keys[14])};
+    }
+
+    inline FlatState decrypt(FlatState const& Y, FlatState const& K13, FlatState const& K14) {
+        auto keys = key_schedule_from_last_round_keys(load(K13), load(K14));
+
+        __m128i m = _mm_xor_si128(load(Y), keys[14]);
+        for (int i = 13; i != 0; --i) m = _mm_aesdec_si128(m, _mm_aesimc_si128(keys[i]));
+        m = _mm_aesdeclast_si128(m, keys[0]);
+
+        return unload(m);
+    }
+
+    /**
+     * @brief Recover the AES-256 key from round 12 faults `round12` and the round 11 fault `round11`.
+     *
+     * @param plaintext if not null, the plaintext of `round11.regular`, leaving the right key only
+     * @param hints known round 14 key bytes, as `allowed_bytes`
+     * @return false, `error` telling why, if the round 12 faults leave too many round 14 keys
+     */
+    inline bool attack(vector<Capture> const& round12, Capture const& round11, FlatState const* plaintext, KeyHints const& hints,
+                       second_stage::Settings const& settings, vector<Key>& keys, string& error) {
+        vector<FlatState> last_keys;
+        if (!last_round_keys(round12, hints, last_keys, error)) return false;
+
+        keys.clear();
+        for (auto const& K14 : last_keys)
+            for (auto const& K13 : penultimate_round_keys(round11, K14, settings))
+                if (plaintext == nullptr || decrypt(round11.regular, K13, K14) == *plaintext)
+                    keys.push_back(get_initial_key(K13, K14));
+
+        return true;
+    }
+}
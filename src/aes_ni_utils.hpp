@@ -1,156 +1,448 @@
-#include <wmmintrin.h>
-
-#include <array>
-
-using namespace std;
-
-using u8 = unsigned char;
-using Row = array<u8, 4>;
-using FlatState = array<u8, 16>;
-
-// -----------------------------------------------------------------------------------------------------------------------------------
-
-// Reason for using template -> `_mm_aeskeygenassist_si128` requires `rcon` to be an immediate
-template<int rcon>
-inline __m128i single_step_key_inversion(__m128i k) {
-    // K4' = K4 xor K3
-    // K3' = K3 xor K2
-    // K2' = K2 xor K1
-    // K1' = K1 xor SubWord(RotWord(K4')) xor RCON
-    __m128i i, j;
-
-    i = _mm_slli_si128(k, 4);                       // i <- [K3, K2, K1, 0]
-    k = _mm_xor_si128(k, i);                        // k <- [K4, K3, K2, K1] xor [K3, K2, K1, 0] = [K4', K3', K2', K1]
-    
-    j = _mm_aeskeygenassist_si128(k, rcon);         // l <- [SubWord(RotWord(K4')) xor RCON, .., .., ..]
-    j = _mm_srli_si128(j, 12);                      // l <- [0, 0, 0, SubWord(RotWord(K4')) xor RCON]
-    k = _mm_xor_si128(k, j);                        // k <- [K4', K3', K2', K1 xor SubWord(RotWord(K4')) xor RCON]
-
-    return k;
-}
-
-auto key_schedule_from_last_round_key(__m128i k10) {
-    array<__m128i, 11> keys;
-    
-    keys[10] = k10;
-    keys[ 9] = single_step_key_inversion<0x36>(keys[10]);
-    keys[ 8] = single_step_key_inversion<0x1b>(keys[ 9]);
-    keys[ 7] = single_step_key_inversion<0x80>(keys[ 8]);
-    keys[ 6] = single_step_key_inversion<0x40>(keys[ 7]);
-    keys[ 5] = single_step_key_inversion<0x20>(keys[ 6]);
-    keys[ 4] = single_step_key_inversion<0x10>(keys[ 5]);
-    keys[ 3] = single_step_key_inversion<0x08>(keys[ 4]);
-    keys[ 2] = single_step_key_inversion<0x04>(keys[ 3]);
-    keys[ 1] = single_step_key_inversion<0x02>(keys[ 2]);
-    keys[ 0] = single_step_key_inversion<0x01>(keys[ 1]);
-
-    return keys;
-}
-
-__m128i get_initial_key(__m128i k10) {
-    return key_schedule_from_last_round_key(k10)[0];
-}
-
-__m128i decrypt(__m128i m, __m128i k10) {
-    auto keys = key_schedule_from_last_round_key(k10);
-    
-    m  = _mm_xor_si128(m, keys[10]);
-
-    for (int i = 9; i != 0; --i) {
-        __m128i kimc = _mm_aesimc_si128(keys[i]);
-        m = _mm_aesdec_si128(m, kimc);
-    }
-
-    m = _mm_aesdeclast_si128(m, keys[0]);
-
-    return m;
-}
-
-inline bool check_partial_decryption(__m128i m, __m128i m_, __m128i k10, int fault_mask) {
-    // compute the needed keys
-    __m128i k9    = single_step_key_inversion<0x36>(k10);
-    __m128i k9imc = _mm_aesimc_si128(k9);
-    __m128i k8    = single_step_key_inversion<0x1b>(k9);
-    __m128i k8imc = _mm_aesimc_si128(k8);
-
-    // partial decryptions
-    m  = _mm_xor_si128(m , k10);
-    m  = _mm_aesdec_si128(m, k9imc);
-    m  = _mm_aesdec_si128(m, k8imc);
-
-    m_  = _mm_xor_si128(m_ , k10);
-    m_  = _mm_aesdec_si128(m_, k9imc);
-    m_  = _mm_aesdec_si128(m_, k8imc);
-
-    // assessing that the partially decrypted messages are identical apart from the injected fault location
-    bool is_valid = ((_mm_movemask_epi8(_mm_cmpeq_epi8(m, m_)) == fault_mask)); // fault_mask = 0xfffe for a fault at position (0, 0)
-    
-    return is_valid;
-}
-
-// Interface -------------------------------------------------------------------------------------------------------------------------
-
-inline __m128i load(FlatState const& X) {
-    return _mm_loadu_si128((__m128i *) X.data());
-}
-
-FlatState unload(__m128i x) {
-    FlatState X;
-
-    _mm_storeu_si128((__m128i *) X.data(), x);
-
-    return X;
-}
-
-FlatState get_initial_key(FlatState const& K10) {
-    __m128i k = load(K10);
-    k = get_initial_key(k);
-
-    FlatState K0 = unload(k);
-    
-    return K0;
-}
-
-FlatState decrypt(FlatState const& Y, FlatState const& K10) {
-    __m128i m   = load(Y);
-    __m128i k10 = load(K10);
-    __m128i p   = decrypt(m, k10);
-
-    FlatState P = unload(p);
-
-    return P;
-}
-
-int get_fault_mask(size_t fault_position) {
-    auto shift_left = [](int fault_position, int count) {
-        fault_position = (fault_position - 4*count) % 16;
-        if (fault_position < 0) fault_position += 16;
-        return (size_t)fault_position;
-    };
-
-    switch (fault_position){
-        case 0: case 4: case  8: case 12:
-            break;
-        case 1: case 5: case  9: case 13:
-            fault_position = shift_left(fault_position, 1);
-            break;
-        case 2: case 6: case 10: case 14:
-            fault_position = shift_left(fault_position, 2);
-            break;
-        case 3: case 7: case 11: case 15:
-            fault_position = shift_left(fault_position, 3);
-            break;
-    }
-
-    int fault_mask = ~(1 << fault_position) & 0b00000000000000001111111111111111;
-
-    return fault_mask;
-}
-
-inline bool check_partial_decryption(FlatState const& Y, FlatState const& Y_, FlatState const& K10, int fault_mask) {
-    __m128i y   = load(Y);
-    __m128i y_  = load(Y_);
-    __m128i k10 = load(K10);
-
-    return check_partial_decryption(y, y_, k10, fault_mask);
+#pragma once
+
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+
+#if defined(__VAES__) && defined(__AVX512F__) && defined(__AVX512BW__)
+#include <immintrin.h>
+#define AES_NI_UTILS_VAES 1   // 4 AES blocks per instruction available
+#endif
+
+#include <array>
+#include <cstdint>
+
+#include "fault_layout.hpp"
+
+using namespace std;
+
+using u8 = unsigned char;
+using Row = array<u8, 4>;
+using FlatState = array<u8, 16>;
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Ways to get SubWord(RotWord(.)) for the key schedule: `aeskeygenassist`, or `aesenclast` on the word broadcast
+ * to every column (ShiftRows then leaving it in place), which is faster on cores where `aeskeygenassist` has poor throughput.
+ */
+enum class KeyInversion { AESKEYGENASSIST, AESENCLAST };
+
+// Same step as below, `rcon` needs not be an immediate
+inline __m128i single_step_key_inversion(__m128i k, int rcon) {
+    const __m128i ROTATED_K4 = _mm_setr_epi8(13, 14, 15, 12, 13, 14, 15, 12, 13, 14, 15, 12, 13, 14, 15, 12);
+    const __m128i WORD_0     = _mm_setr_epi32(-1, 0, 0, 0);
+    __m128i j;
+
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));                         // k <- [K4', K3', K2', K1]
+
+    j = _mm_shuffle_epi8(k, ROTATED_K4);                                // j <- RotWord(K4') in every column
+    j = _mm_aesenclast_si128(j, _mm_setr_epi32(rcon, 0, 0, 0));         // j <- [.., .., .., SubWord(RotWord(K4')) xor RCON]
+    k = _mm_xor_si128(k, _mm_and_si128(j, WORD_0));
+
+    return k;
+}
+
+/**
+ * @brief Same step on 4 keys: their rotated K4' words are laid out so that one `aesenclast` substitutes them all.
+ */
+inline void single_step_key_inversion_x4(__m128i k[4], int rcon) {
+    // key i, byte r of RotWord(K4') at row r of column (i + r) % 4, where ShiftRows moves it back to column i
+    const __m128i GATHER[4] = {
+        _mm_setr_epi8(  13,   -1,   -1,   -1,   -1,   14,   -1,   -1,   -1,   -1,   15,   -1,   -1,   -1,   -1,   12),
+        _mm_setr_epi8(  -1,   -1,   -1,   12,   13,   -1,   -1,   -1,   -1,   14,   -1,   -1,   -1,   -1,   15,   -1),
+        _mm_setr_epi8(  -1,   -1,   15,   -1,   -1,   -1,   -1,   12,   13,   -1,   -1,   -1,   -1,   14,   -1,   -1),
+        _mm_setr_epi8(  -1,   14,   -1,   -1,   -1,   -1,   15,   -1,   -1,   -1,   -1,   12,   13,   -1,   -1,   -1),
+    };
+    const __m128i WORD_0 = _mm_setr_epi32(-1, 0, 0, 0);
+    __m128i j = _mm_setzero_si128();
+
+    for (int i = 0; i < 4; ++i) {
+        k[i] = _mm_xor_si128(k[i], _mm_slli_si128(k[i], 4));           // k <- [K4', K3', K2', K1]
+        j = _mm_or_si128(j, _mm_shuffle_epi8(k[i], GATHER[i]));
+    }
+
+    j = _mm_aesenclast_si128(j, _mm_set1_epi32(rcon));                  // column i <- SubWord(RotWord(K4' of key i)) xor RCON
+
+    k[0] = _mm_xor_si128(k[0], _mm_and_si128(j, WORD_0));
+    k[1] = _mm_xor_si128(k[1], _mm_and_si128(_mm_srli_si128(j,  4), WORD_0));
+    k[2] = _mm_xor_si128(k[2], _mm_and_si128(_mm_srli_si128(j,  8), WORD_0));
+    k[3] = _mm_xor_si128(k[3], _mm_srli_si128(j, 12));
+}
+
+// Reason for using template -> `_mm_aeskeygenassist_si128` requires `rcon` to be an immediate
+template<int rcon, KeyInversion method = KeyInversion::AESKEYGENASSIST>
+inline __m128i single_step_key_inversion(__m128i k) {
+    if constexpr (method == KeyInversion::AESENCLAST)
+        return single_step_key_inversion(k, rcon);
+
+    // K4' = K4 xor K3
+    // K3' = K3 xor K2
+    // K2' = K2 xor K1
+    // K1' = K1 xor SubWord(RotWord(K4')) xor RCON
+    __m128i i, j;
+
+    i = _mm_slli_si128(k, 4);                       // i <- [K3, K2, K1, 0]
+    k = _mm_xor_si128(k, i);                        // k <- [K4, K3, K2, K1] xor [K3, K2, K1, 0] = [K4', K3', K2', K1]
+    
+    j = _mm_aeskeygenassist_si128(k, rcon);         // l <- [SubWord(RotWord(K4')) xor RCON, .., .., ..]
+    j = _mm_srli_si128(j, 12);                      // l <- [0, 0, 0, SubWord(RotWord(K4')) xor RCON]
+    k = _mm_xor_si128(k, j);                        // k <- [K4', K3', K2', K1 xor SubWord(RotWord(K4')) xor RCON]
+
+    return k;
+}
+
+// Same reason as above for the template
+template<int rcon>
+inline __m128i single_step_key_expansion(__m128i k) {
+    // K1' = K1 xor SubWord(RotWord(K4)) xor RCON
+    // K2' = K2 xor K1'
+    // K3' = K3 xor K2'
+    // K4' = K4 xor K3'
+    __m128i j;
+
+    j = _mm_aeskeygenassist_si128(k, rcon);         // j <- [SubWord(RotWord(K4)) xor RCON, .., .., ..]
+    j = _mm_shuffle_epi32(j, 0xff);                 // broadcast it to the 4 words
+
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));     // k <- [K4 xor K3, K3 xor K2, K2 xor K1, K1]
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));     // prefix xors...
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));     // k <- [K4 xor K3 xor K2 xor K1, K3 xor K2 xor K1, K2 xor K1, K1]
+    k = _mm_xor_si128(k, j);
+
+    return k;
+}
+
+inline __m128i get_last_round_key(__m128i k0) {
+    k0 = single_step_key_expansion<0x01>(k0);
+    k0 = single_step_key_expansion<0x02>(k0);
+    k0 = single_step_key_expansion<0x04>(k0);
+    k0 = single_step_key_expansion<0x08>(k0);
+    k0 = single_step_key_expansion<0x10>(k0);
+    k0 = single_step_key_expansion<0x20>(k0);
+    k0 = single_step_key_expansion<0x40>(k0);
+    k0 = single_step_key_expansion<0x80>(k0);
+    k0 = single_step_key_expansion<0x1b>(k0);
+    k0 = single_step_key_expansion<0x36>(k0);
+
+    return k0;
+}
+
+template<KeyInversion method = KeyInversion::AESKEYGENASSIST>
+inline auto key_schedule_from_last_round_key(__m128i k10) {
+    array<__m128i, 11> keys;
+    
+    keys[10] = k10;
+    keys[ 9] = single_step_key_inversion<0x36, method>(keys[10]);
+    keys[ 8] = single_step_key_inversion<0x1b, method>(keys[ 9]);
+    keys[ 7] = single_step_key_inversion<0x80, method>(keys[ 8]);
+    keys[ 6] = single_step_key_inversion<0x40, method>(keys[ 7]);
+    keys[ 5] = single_step_key_inversion<0x20, method>(keys[ 6]);
+    keys[ 4] = single_step_key_inversion<0x10, method>(keys[ 5]);
+    keys[ 3] = single_step_key_inversion<0x08, method>(keys[ 4]);
+    keys[ 2] = single_step_key_inversion<0x04, method>(keys[ 3]);
+    keys[ 1] = single_step_key_inversion<0x02, method>(keys[ 2]);
+    keys[ 0] = single_step_key_inversion<0x01, method>(keys[ 1]);
+
+    return keys;
+}
+
+/**
+ * @brief Round keys of the 4 round 10 keys `k10` at once, `keys[i][r]` being round key r of key i: with `AESENCLAST`,
+ * one `aesenclast` substitutes the words of the 4 keys at each step.
+ */
+inline void key_schedules_from_last_round_key_x4(__m128i const k10[4], __m128i keys[4][11], KeyInversion method) {
+    // RCON[r] of the step from round key r to round key r - 1
+    constexpr int RCON[11] = {0, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
+
+    if (method == KeyInversion::AESENCLAST) {
+        __m128i k[4];
+        for (int i = 0; i < 4; ++i) keys[i][10] = k[i] = k10[i];
+
+        for (int r = 10; r != 0; --r) {
+            single_step_key_inversion_x4(k, RCON[r]);
+            for (int i = 0; i < 4; ++i) keys[i][r - 1] = k[i];
+        }
+    } else {
+        for (int i = 0; i < 4; ++i) {
+            auto schedule = key_schedule_from_last_round_key(k10[i]);
+            for (int r = 0; r < 11; ++r) keys[i][r] = schedule[r];
+        }
+    }
+}
+
+inline __m128i get_initial_key(__m128i k10, KeyInversion method = KeyInversion::AESKEYGENASSIST) {
+    if (method == KeyInversion::AESENCLAST) return key_schedule_from_last_round_key<KeyInversion::AESENCLAST>(k10)[0];
+
+    return key_schedule_from_last_round_key(k10)[0];
+}
+
+// AES-256 ---------------------------------------------------------------------------------------------------------------------------
+
+// AES-256 round key r from round keys r - 2 and r - 1, SubWord(RotWord(.)) xor RCON for an even r, SubWord(.) alone
+// for an odd r (`rcon` < 0). Same reason as above for the template
+template<int rcon>
+inline __m128i single_step_key_expansion_256(__m128i k, __m128i k_previous) {
+    // K1' = K1 xor SubWord(RotWord(P4)) xor RCON    (even r, SubWord(P4) for an odd r)
+    // K2' = K2 xor K1'
+    // K3' = K3 xor K2'
+    // K4' = K4 xor K3'
+    __m128i j;
+
+    if constexpr (rcon >= 0) {
+        j = _mm_aeskeygenassist_si128(k_previous, rcon);    // j <- [SubWord(RotWord(P4)) xor RCON, .., .., ..]
+        j = _mm_shuffle_epi32(j, 0xff);                     // broadcast it to the 4 words
+    } else {
+        j = _mm_aeskeygenassist_si128(k_previous, 0);       // j <- [.., SubWord(P4), .., ..]
+        j = _mm_shuffle_epi32(j, 0xaa);
+    }
+
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));         // k <- [K4 xor K3 xor K2 xor K1, K3 xor K2 xor K1, K2 xor K1, K1]
+    k = _mm_xor_si128(k, j);
+
+    return k;
+}
+
+// AES-256 round key r - 2 from round keys r and r - 1, inverting the step above
+template<int rcon>
+inline __m128i single_step_key_inversion_256(__m128i k, __m128i k_previous) {
+    __m128i j;
+
+    k = _mm_xor_si128(k, _mm_slli_si128(k, 4));         // k <- [K4 xor K3, K3 xor K2, K2 xor K1, K1]
+
+    if constexpr (rcon >= 0) {
+        j = _mm_aeskeygenassist_si128(k_previous, rcon);    // j <- [SubWord(RotWord(P4)) xor RCON, .., .., ..]
+        j = _mm_srli_si128(j, 12);                          // j <- [0, 0, 0, SubWord(RotWord(P4)) xor RCON]
+    } else {
+        j = _mm_aeskeygenassist_si128(k_previous, 0);       // j <- [.., SubWord(P4), .., ..]
+        j = _mm_srli_si128(_mm_slli_si128(j, 4), 12);       // j <- [0, 0, 0, SubWord(P4)]
+    }
+
+    return _mm_xor_si128(k, j);
+}
+
+// The 15 round keys of AES-256, in a plain array: `array<__m128i, 15>` would drop the attributes of `__m128i`
+struct KeySchedule256 {
+    __m128i keys[15];
+
+    __m128i& operator[](size_t i) { return keys[i]; }
+    __m128i const& operator[](size_t i) const { return keys[i]; }
+};
+
+// The 15 round keys of the AES-256 key whose halves are `k0` and `k1`
+inline KeySchedule256 key_schedule_256(__m128i k0, __m128i k1) {
+    KeySchedule256 keys;
+
+    keys[ 0] = k0;
+    keys[ 1] = k1;
+    keys[ 2] = single_step_key_expansion_256<0x01>(keys[ 0], keys[ 1]);
+    keys[ 3] = single_step_key_expansion_256<  -1>(keys[ 1], keys[ 2]);
+    keys[ 4] = single_step_key_expansion_256<0x02>(keys[ 2], keys[ 3]);
+    keys[ 5] = single_step_key_expansion_256<  -1>(keys[ 3], keys[ 4]);
+    keys[ 6] = single_step_key_expansion_256<0x04>(keys[ 4], keys[ 5]);
+    keys[ 7] = single_step_key_expansion_256<  -1>(keys[ 5], keys[ 6]);
+    keys[ 8] = single_step_key_expansion_256<0x08>(keys[ 6], keys[ 7]);
+    keys[ 9] = single_step_key_expansion_256<  -1>(keys[ 7], keys[ 8]);
+    keys[10] = single_step_key_expansion_256<0x10>(keys[ 8], keys[ 9]);
+    keys[11] = single_step_key_expansion_256<  -1>(keys[ 9], keys[10]);
+    keys[12] = single_step_key_expansion_256<0x20>(keys[10], keys[11]);
+    keys[13] = single_step_key_expansion_256<  -1>(keys[11], keys[12]);
+    keys[14] = single_step_key_expansion_256<0x40>(keys[12], keys[13]);
+
+    return keys;
+}
+
+// The 15 round keys of AES-256 from its last two, which are independent
+inline KeySchedule256 key_schedule_from_last_round_keys(__m128i k13, __m128i k14) {
+    KeySchedule256 keys;
+
+    keys[14] = k14;
+    keys[13] = k13;
+    keys[12] = single_step_key_inversion_256<0x40>(keys[14], keys[13]);
+    keys[11] = single_step_key_inversion_256<  -1>(keys[13], keys[12]);
+    keys[10] = single_step_key_inversion_256<0x20>(keys[12], keys[11]);
+    keys[ 9] = single_step_key_inversion_256<  -1>(keys[11], keys[10]);
+    keys[ 8] = single_step_key_inversion_256<0x10>(keys[10], keys[ 9]);
+    keys[ 7] = single_step_key_inversion_256<  -1>(keys[ 9], keys[ 8]);
+    keys[ 6] = single_step_key_inversion_256<0x08>(keys[ 8], keys[ 7]);
+    keys[ 5] = single_step_key_inversion_256<  -1>(keys[ 7], keys[ 6]);
+    keys[ 4] = single_step_key_inversion_256<0x04>(keys[ 6], keys[ 5]);
+    keys[ 3] = single_step_key_inversion_256<  -1>(keys[ 5], keys[ 4]);
+    keys[ 2] = single_step_key_inversion_256<0x02>(keys[ 4], keys[ 3]);
+    keys[ 1] = single_step_key_inversion_256<  -1>(keys[ 3], keys[ 2]);
+    keys[ 0] = single_step_key_inversion_256<0x01>(keys[ 2], keys[ 1]);
+
+    return keys;
+}
+
+inline __m128i decrypt(__m128i m, __m128i k10, KeyInversion method = KeyInversion::AESKEYGENASSIST) {
+    auto keys = (method == KeyInversion::AESENCLAST) ? key_schedule_from_last_round_key<KeyInversion::AESENCLAST>(k10)
+                                                     : key_schedule_from_last_round_key(k10);
+    
+    m  = _mm_xor_si128(m, keys[10]);
+
+    for (int i = 9; i != 0; --i) {
+        __m128i kimc = _mm_aesimc_si128(keys[i]);
+        m = _mm_aesdec_si128(m, kimc);
+    }
+
+    m = _mm_aesdeclast_si128(m, keys[0]);
+
+    return m;
+}
+
+// Decryptions `p[i]` of `m` under the round keys `keys[i]` of 4 keys, interleaved to fill the AES unit pipeline
+inline void decrypt_x4(__m128i m, __m128i const keys[4][11], __m128i p[4]) {
+    for (int i = 0; i < 4; ++i) p[i] = _mm_xor_si128(m, keys[i][10]);
+    for (int r = 9; r != 0; --r)
+        for (int i = 0; i < 4; ++i) p[i] = _mm_aesdec_si128(p[i], _mm_aesimc_si128(keys[i][r]));
+    for (int i = 0; i < 4; ++i) p[i] = _mm_aesdeclast_si128(p[i], keys[i][0]);
+}
+
+/**
+ * The partial decryptions of the candidate checks stop at the round 8 `MixColumns` input xored with InvMixColumns(K8),
+ * which only shifts both states by the same value and thus leaves the bytes where they differ unchanged: the round 8
+ * key is left out and the second `aesdec` takes a zero round key instead. Only the round 9 key has to be derived.
+ *
+ * The bytes of `checked_mask` where both states are equal must be those of `fault_mask`: all the bytes by default, the
+ * faulted one having to change, or only the unfaulted ones for faults whose bytes may or may not change.
+ */
+
+// Same as below, with the InvMixColumns image `k9imc` of the round 9 key already at hand
+inline bool check_partial_decryption(__m128i m, __m128i m_, __m128i k10, __m128i k9imc, int fault_mask, int checked_mask = 0xffff) {
+    const __m128i ZERO = _mm_setzero_si128();
+
+    // partial decryptions, up to the same round 8 key
+    m  = _mm_xor_si128(m , k10);
+    m  = _mm_aesdec_si128(m, k9imc);
+    m  = _mm_aesdec_si128(m, ZERO);
+
+    m_  = _mm_xor_si128(m_ , k10);
+    m_  = _mm_aesdec_si128(m_, k9imc);
+    m_  = _mm_aesdec_si128(m_, ZERO);
+
+    // assessing that the partially decrypted messages are identical apart from the injected fault location
+    bool is_valid = ((_mm_movemask_epi8(_mm_cmpeq_epi8(m, m_)) & checked_mask) == fault_mask); // fault_mask = 0xfffe for a fault at position (0, 0)
+    
+    return is_valid;
+}
+
+// Same as above for 4 keys at once, instructions interleaved to fill the AES unit pipeline.
+// Bit i of the result tells whether key i is valid.
+inline int check_partial_decryption_x4(__m128i m, __m128i m_, __m128i const k10[4], __m128i const k9imc[4], int fault_mask, int checked_mask = 0xffff) {
+    const __m128i ZERO = _mm_setzero_si128();
+    __m128i a[4], b[4];
+
+    for (int i = 0; i < 4; ++i) {
+        a[i] = _mm_xor_si128(m , k10[i]);
+        b[i] = _mm_xor_si128(m_, k10[i]);
+    }
+    for (int i = 0; i < 4; ++i) {
+        a[i] = _mm_aesdec_si128(a[i], k9imc[i]);
+        b[i] = _mm_aesdec_si128(b[i], k9imc[i]);
+    }
+    for (int i = 0; i < 4; ++i) {
+        a[i] = _mm_aesdec_si128(a[i], ZERO);
+        b[i] = _mm_aesdec_si128(b[i], ZERO);
+    }
+
+    int valid = 0;
+    for (int i = 0; i < 4; ++i)
+        valid |= ((_mm_movemask_epi8(_mm_cmpeq_epi8(a[i], b[i])) & checked_mask) == fault_mask) << i;
+
+    return valid;
+}
+
+#ifdef AES_NI_UTILS_VAES
+// Same as above with the 4 keys in the lanes of 512 bits registers.
+inline int check_partial_decryption_vaes(__m128i m, __m128i m_, __m128i const k10[4], __m128i const k9imc[4], int fault_mask, int checked_mask = 0xffff) {
+    __m512i keys10 = _mm512_loadu_si512(k10);
+    __m512i keys9  = _mm512_loadu_si512(k9imc);
+    __m512i zero   = _mm512_setzero_si512();
+
+    __m512i a = _mm512_xor_si512(_mm512_maskz_broadcast_i32x4(0xffff, m ), keys10);
+    __m512i b = _mm512_xor_si512(_mm512_maskz_broadcast_i32x4(0xffff, m_), keys10);
+    a = _mm512_aesdec_epi128(a, keys9);
+    b = _mm512_aesdec_epi128(b, keys9);
+    a = _mm512_aesdec_epi128(a, zero);
+    b = _mm512_aesdec_epi128(b, zero);
+
+    uint64_t equal = _mm512_cmpeq_epi8_mask(a, b);
+
+    int valid = 0;
+    for (int i = 0; i < 4; ++i)
+        valid |= (int) (((equal >> 16*i) & (uint64_t) checked_mask) == (uint64_t) fault_mask) << i;
+
+    return valid;
+}
+#endif
+
+inline bool check_partial_decryption(__m128i m, __m128i m_, __m128i k10, int fault_mask, int checked_mask = 0xffff) {
+    // compute the needed key
+    __m128i k9imc = _mm_aesimc_si128(single_step_key_inversion<0x36>(k10));
+
+    return check_partial_decryption(m, m_, k10, k9imc, fault_mask, checked_mask);
+}
+
+// Interface -------------------------------------------------------------------------------------------------------------------------
+
+inline __m128i load(FlatState const& X) {
+    return _mm_loadu_si128((__m128i *) X.data());
+}
+
+inline FlatState unload(__m128i x) {
+    FlatState X;
+
+    _mm_storeu_si128((__m128i *) X.data(), x);
+
+    return X;
+}
+
+inline FlatState get_initial_key(FlatState const& K10, KeyInversion method = KeyInversion::AESKEYGENASSIST) {
+    __m128i k = load(K10);
+    k = get_initial_key(k, method);
+
+    FlatState K0 = unload(k);
+    
+    return K0;
+}
+
+inline FlatState get_last_round_key(FlatState const& K0) {
+    __m128i k = load(K0);
+    k = get_last_round_key(k);
+
+    FlatState K10 = unload(k);
+
+    return K10;
+}
+
+inline FlatState decrypt(FlatState const& Y, FlatState const& K10, KeyInversion method = KeyInversion::AESKEYGENASSIST) {
+    __m128i m   = load(Y);
+    __m128i k10 = load(K10);
+    __m128i p   = decrypt(m, k10, method);
+
+    FlatState P = unload(p);
+
+    return P;
+}
+
+// Round 8 `MixColumns` input state of ciphertext `Y` under round 10 key `K10`
+inline FlatState partial_decryption(FlatState const& Y, FlatState const& K10) {
+    __m128i k10 = load(K10);
+    __m128i k9  = single_step_key_inversion<0x36>(k10);
+    __m128i k8  = single_step_key_inversion<0x1b>(k9);
+
+    __m128i m = _mm_xor_si128(load(Y), k10);
+    m = _mm_aesdec_si128(m, _mm_aesimc_si128(k9));
+    m = _mm_aesdec_si128(m, _mm_aesimc_si128(k8));
+
+    return unload(m);
+}
+
+inline bool check_partial_decryption(FlatState const& Y, FlatState const& Y_, FlatState const& K10, int fault_mask, int checked_mask = 0xffff) {
+    __m128i y   = load(Y);
+    __m128i y_  = load(Y_);
+    __m128i k10 = load(K10);
+
+    return check_partial_decryption(y, y_, k10, fault_mask, checked_mask);
 }
\ No newline at end of file
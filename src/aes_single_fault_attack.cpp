@@ -0,0 +1,131 @@
+#include "aes_single_fault_attack.h"
+#include "reductions.hpp"
+#include "tuning.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+using namespace std;
+
+struct asfa_result {
+    vector<FlatState> keys;
+};
+
+namespace {
+    FlatState to_state(const unsigned char* bytes) {
+        FlatState X;
+        memcpy(X.data(), bytes, X.size());
+        return X;
+    }
+
+    // loaded once, thread safe since C++11
+    second_stage::Settings const& tuned_settings() {
+        static second_stage::Settings const settings = tuning::load_or_default();
+        return settings;
+    }
+}
+
+extern "C" {
+
+void asfa_init_options(asfa_options* options) {
+    if (options == nullptr) return;
+
+    options->threads = 0;
+    options->plaintext = nullptr;
+    options->key_kind = ASFA_INITIAL_KEY;
+    options->engine = ASFA_ENGINE_AUTO;
+}
+
+asfa_status asfa_attack(const unsigned char* regular, const unsigned char* faulted, unsigned int fault_position,
+                        const asfa_options* options, asfa_result** result) {
+    if (regular == nullptr || faulted == nullptr || result == nullptr) return ASFA_INVALID_ARGUMENT;
+    if (fault_position >= 16) return ASFA_OUT_OF_RANGE;
+
+    asfa_options defaults;
+    asfa_init_options(&defaults);
+    if (options == nullptr) options = &defaults;
+
+    if (options->threads < 0) return ASFA_INVALID_ARGUMENT;
+    if (options->key_kind != ASFA_INITIAL_KEY && options->key_kind != ASFA_LAST_ROUND_KEY) return ASFA_INVALID_ARGUMENT;
+    if (options->engine != ASFA_ENGINE_SWEEP && options->engine != ASFA_ENGINE_JOIN && options->engine != ASFA_ENGINE_AUTO) return ASFA_INVALID_ARGUMENT;
+
+    *result = nullptr;
+
+    try {
+        auto Y  = to_state(regular);
+        auto Y_ = to_state(faulted);
+        auto settings = tuned_settings();
+        if (options->threads != 0) settings.threads = options->threads;
+        if (options->engine == ASFA_ENGINE_SWEEP) settings.engine = second_stage::Engine::SWEEP;
+        if (options->engine == ASFA_ENGINE_JOIN) settings.engine = second_stage::Engine::JOIN;
+
+        auto stage1_results = first_stage::reduction(Y, Y_, fault_position);
+        auto stage2_results = second_stage::run(Y, Y_, fault_position, stage1_results, settings);
+
+        auto out = new asfa_result;
+
+        if (options->plaintext != nullptr) {
+            auto X = to_state(options->plaintext);
+            for (auto const& K10 : stage2_results)
+                if (decrypt(Y, K10, settings.inversion) == X)
+                    out->keys.push_back(K10);
+        } else {
+            out->keys = move(stage2_results);
+        }
+
+        if (options->key_kind == ASFA_INITIAL_KEY)
+            for (auto& key : out->keys)
+                key = get_initial_key(key, settings.inversion);
+
+        *result = out;
+    } catch (bad_alloc const&) {
+        return ASFA_OUT_OF_MEMORY;
+    } catch (...) {
+        // nothing may cross the C boundary
+        return ASFA_INTERNAL_ERROR;
+    }
+
+    return ASFA_OK;
+}
+
+size_t asfa_result_size(const asfa_result* result) {
+    return (result == nullptr) ? 0 : result->keys.size();
+}
+
+asfa_status asfa_result_key(const asfa_result* result, size_t index, unsigned char* key) {
+    if (result == nullptr || key == nullptr) return ASFA_INVALID_ARGUMENT;
+    if (index >= result->keys.size()) return ASFA_OUT_OF_RANGE;
+
+    memcpy(key, result->keys[index].data(), ASFA_STATE_SIZE);
+
+    return ASFA_OK;
+}
+
+size_t asfa_result_copy(const asfa_result* result, unsigned char* keys, size_t capacity) {
+    if (result == nullptr || keys == nullptr) return 0;
+
+    size_t count = min(capacity, result->keys.size());
+    for (size_t i = 0; i < count; ++i)
+        memcpy(keys + i * ASFA_STATE_SIZE, result->keys[i].data(), ASFA_STATE_SIZE);
+
+    return count;
+}
+
+void asfa_free_result(asfa_result* result) {
+    delete result;
+}
+
+const char* asfa_status_string(asfa_status status) {
+    switch (status) {
+        case ASFA_OK:               return "ok";
+        case ASFA_INVALID_ARGUMENT: return "invalid argument";
+        case ASFA_OUT_OF_RANGE:     return "argument out of range";
+        case ASFA_OUT_OF_MEMORY:    return "out of memory";
+        case ASFA_INTERNAL_ERROR:   return "internal error";
+    }
+
+    return "unknown status";
+}
+
+}
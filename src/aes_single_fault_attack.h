@@ -0,0 +1,82 @@
+/*
+ * C interface of the attack, built as a shared library (see README).
+ *
+ * Every call only touches the memory it is handed, so the functions are
+ * reentrant and may be used concurrently from several threads.
+ *
+ * States (ciphertexts, plaintexts, keys) are 16 bytes buffers laid out
+ * exactly like the hex strings accepted by the command line tool.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ASFA_STATE_SIZE 16
+
+typedef enum asfa_status {
+    ASFA_OK = 0,
+    ASFA_INVALID_ARGUMENT,
+    ASFA_OUT_OF_RANGE,
+    ASFA_OUT_OF_MEMORY,
+    ASFA_INTERNAL_ERROR,    /* any other failure, e.g. threads that could not be started */
+} asfa_status;
+
+typedef enum asfa_key_kind {
+    ASFA_INITIAL_KEY = 0,   /* cipher key K0, as printed by the command line tool */
+    ASFA_LAST_ROUND_KEY,    /* round 10 key K10, as produced by the second stage */
+} asfa_key_kind;
+
+typedef enum asfa_engine {
+    ASFA_ENGINE_SWEEP = 0,  /* exhaustive 2^32 second stage */
+    ASFA_ENGINE_JOIN,       /* join on the round 8 fault equations, much faster */
+    ASFA_ENGINE_AUTO,       /* the one picked by `aes-single-fault-attack tune` on this host, sweep if never tuned */
+} asfa_engine;
+
+typedef struct asfa_options {
+    int threads;                        /* OpenMP threads used by the second stage, 0 for the tuned or default count */
+    const unsigned char* plaintext;     /* optional plaintext of the regular ciphertext, NULL if unknown */
+    asfa_key_kind key_kind;             /* which key is reported for each candidate */
+    asfa_engine engine;                 /* second stage search algorithm */
+} asfa_options;
+
+/* Opaque list of candidate keys produced by `asfa_attack`. */
+typedef struct asfa_result asfa_result;
+
+/* Fill `options` with the defaults: tuned thread count and engine, no plaintext, initial keys. */
+void asfa_init_options(asfa_options* options);
+
+/*
+ * Run the attack on a single capture.
+ *
+ * `regular` and `faulted` are the 16 bytes ciphertexts, `fault_position` is in [0, 16).
+ * `options` may be NULL to use the defaults.
+ * On success, `*result` receives a list to be released with `asfa_free_result`.
+ */
+asfa_status asfa_attack(const unsigned char* regular, const unsigned char* faulted, unsigned int fault_position,
+                        const asfa_options* options, asfa_result** result);
+
+/* Number of candidate keys held by `result`. */
+size_t asfa_result_size(const asfa_result* result);
+
+/* Copy the `index`-th candidate key into the 16 bytes buffer `key`. */
+asfa_status asfa_result_key(const asfa_result* result, size_t index, unsigned char* key);
+
+/*
+ * Copy up to `capacity` candidate keys, back to back, into `keys` (16 * `capacity` bytes).
+ * Return the number of keys copied.
+ */
+size_t asfa_result_copy(const asfa_result* result, unsigned char* keys, size_t capacity);
+
+void asfa_free_result(asfa_result* result);
+
+/* Human readable description of `status`. */
+const char* asfa_status_string(asfa_status status);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "reductions.hpp"
+
+using namespace std;
+
+/**
+ * Asynchronous attacks, for services that can't block on the search.
+ *
+ * `start` hands an attack over to an executor and returns at once an `Attack`: a future of the candidate keys,
+ * along with cooperative cancellation, progress and the priority hint given to the executor.
+ * Any executor with a `submit(function<void()>, Priority)` member fits, e.g. the `ThreadPool` below.
+ *
+ *      async_attack::ThreadPool pool(2);
+ *      auto attack = async_attack::start(pool, request, async_attack::Priority::HIGH);
+ *      ...
+ *      if (attack.ready()) keys = attack.get().keys;
+ */
+namespace async_attack {
+    enum class Priority { LOW, NORMAL, HIGH };
+
+    struct Request {
+        FlatState regular;
+        FlatState faulted;
+        vector<size_t> fault_positions;     // all sharing the same differential column
+        bool has_plaintext = false;
+        FlatState plaintext {};
+        KeyHints hints;
+        FaultModel model;
+        second_stage::Settings settings;
+        bool last_round_keys = false;       // whether to return the round 10 key candidates, leaving the third stage out
+    };
+
+    struct Result {
+        vector<FlatState> keys;             // candidate initial keys (or round 10 keys), empty if cancelled
+        bool cancelled = false;
+    };
+
+    // shared by a running attack and its `Attack` handle
+    struct State {
+        second_stage::Control control;
+        atomic<size_t> positions_done {0};
+        atomic<bool> finished {false};
+        size_t positions = 1;
+        Priority priority = Priority::NORMAL;
+    };
+
+    /**
+     * @brief Run the three stages of `request`, reporting to and polling `state`.
+     */
+    inline Result run(Request const& request, State& state) {
+        Result result;
+        auto& control = state.control;
+
+        // the first stage deltas depend on the fault row, only restricted for a known position
+        auto stage1_model = (request.fault_positions.size() == 1) ? request.model : FaultModel();
+        auto stage1_results = first_stage::reduction(request.regular, request.faulted, request.fault_positions.front(), request.hints, stage1_model);
+
+        vector<FlatState> stage2_results;
+        for (size_t fault_position : request.fault_positions) {
+            if (control.cancelled) break;
+
+            auto keys = second_stage::run(request.regular, request.faulted, fault_position, stage1_results, request.settings, request.model, &control);
+            stage2_results.insert(stage2_results.end(), keys.begin(), keys.end());
+            ++state.positions_done;
+        }
+
+        if (control.cancelled) {
+            result.cancelled = true;
+            return result;
+        }
+
+        if (request.last_round_keys)
+            result.keys = move(stage2_results);
+        else if (request.has_plaintext)
+            result.keys = third_stage::reduction(request.regular, request.plaintext, stage2_results, request.settings.inversion);
+        else
+            for (auto const& K10 : stage2_results)
+                result.keys.push_back(get_initial_key(K10, request.settings.inversion));
+
+        return result;
+    }
+
+    /**
+     * @brief Handle of an attack started by `start`.
+     */
+    class Attack {
+    public:
+        Attack(shared_ptr<State> state, future<Result> result) : state(move(state)), result(move(result)) {}
+
+        /**
+         * @brief Ask the attack to stop. It then completes, soon, with a cancelled `Result`.
+         */
+        void cancel() { state->control.cancelled = true; }
+
+        bool cancelled() const { return state->control.cancelled; }
+
+        /**
+         * @brief Fraction of the search done, in [0, 1].
+         */
+        double progress() const {
+            if (state->finished) return 1.0;
+
+            size_t done = state->positions_done;
+            double current = (done < state->positions) ? state->control.progress() : 0.0;
+
+            return (done + current) / state->positions;
+        }
+
+        Priority priority() const { return state->priority; }
+
+        bool ready() const { return result.wait_for(chrono::seconds(0)) == future_status::ready; }
+        void wait() const { result.wait(); }
+        Result get() { return result.get(); }
+
+        // the underlying future, to be waited on along with others
+        future<Result>& get_future() { return result; }
+
+    private:
+        shared_ptr<State> state;
+        future<Result> result;
+    };
+
+    /**
+     * @brief Start `request` on `executor` with the priority hint `priority`.
+     *
+     * A request without fault position is not run, its future holding an `invalid_argument` right away, and
+     * an attack failing (e.g. on `bad_alloc`) hands its exception over to the future as well.
+     */
+    template<typename Executor>
+    Attack start(Executor& executor, Request request, Priority priority = Priority::NORMAL) {
+        auto state = make_shared<State>();
+        state->positions = request.fault_positions.size();
+        state->priority = priority;
+
+        auto result = make_shared<promise<Result>>();
+        Attack attack(state, result->get_future());
+
+        if (request.fault_positions.empty()) {
+            state->positions = 1;
+            state->finished = true;
+            result->set_exception(make_exception_ptr(invalid_argument("attack request without fault position")));
+            return attack;
+        }
+
+        executor.submit([state, result, request = move(request)] {
+            try {
+                Result out;
+                if (state->control.cancelled)
+                    out.cancelled = true;
+                else
+                    out = run(request, *state);
+
+                state->finished = true;
+                result->set_value(move(out));
+            } catch (...) {
+                // the pool thread must outlive the attack
+                state->finished = true;
+                result->set_exception(current_exception());
+            }
+        }, priority);
+
+        return attack;
+    }
+
+    /**
+     * @brief Fixed size pool of threads running the submitted tasks by decreasing priority, in submission order within a priority.
+     *
+     * Destroying the pool waits for the tasks already submitted.
+     */
+    class ThreadPool {
+    public:
+        explicit ThreadPool(size_t workers = 1) {
+            for (size_t i = 0; i < workers; ++i)
+                threads.emplace_back([this] { work(); });
+        }
+
+        ~ThreadPool() {
+            {
+                lock_guard<mutex> lock(queue_mutex);
+                stopping = true;
+            }
+            available.notify_all();
+
+            for (auto& thread : threads) thread.join();
+        }
+
+        ThreadPool(ThreadPool const&) = delete;
+        ThreadPool& operator=(ThreadPool const&) = delete;
+
+        void submit(function<void()> task, Priority priority = Priority::NORMAL) {
+            {
+                lock_guard<mutex> lock(queue_mutex);
+                tasks.push({priority, next_sequence++, move(task)});
+            }
+            available.notify_one();
+        }
+
+    private:
+        struct Task {
+            Priority priority;
+            uint64_t sequence;
+            function<void()> run;
+
+            // priority_queue pops the greatest: highest priority, then oldest
+            bool operator<(Task const& other) const {
+                if (priority != other.priority) return priority < other.priority;
+                return sequence > other.sequence;
+            }
+        };
+
+        vector<thread> threads;
+        priority_queue<Task> tasks;
+        mutex queue_mutex;
+        condition_variable available;
+        uint64_t next_sequence = 0;
+        bool stopping = false;
+
+        void work() {
+            while (true) {
+                Task task;
+                {
+                    unique_lock<mutex> lock(queue_mutex);
+                    available.wait(lock, [this] { return stopping || !tasks.empty(); });
+                    if (tasks.empty()) return;
+
+                    task = tasks.top();
+                    tasks.pop();
+                }
+
+                task.run();
+            }
+        }
+    };
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <omp.h>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "reductions.hpp"
+
+using namespace std;
+
+/**
+ * Monte-Carlo campaigns on simulated faults.
+ *
+ * Each simulation draws a key, a plaintext, a fault position and a fault fitting the fault model, encrypts with and
+ * without the fault in memory, then runs the first stage and a count-only second stage (`second_stage::count`),
+ * recording the first stage set sizes, the second stage survivors and the wall time. Simulations are spread over
+ * the cores, one simulation per thread, into preallocated records aggregated once they are all done: the loop does
+ * no I/O nor allocation but the stages' own.
+ *
+ * Simulation `i` only depends on the seed and on `i`, so a campaign gives the same figures whatever the thread count.
+ */
+namespace campaign {
+    struct Settings {
+        size_t simulations = 100;
+        uint64_t seed = 1;
+        vector<size_t> fault_positions;         // drawn among, all 16 if empty
+        FaultModel model;                       // of the simulated faults, and of the attack
+        second_stage::Settings stage2;          // `threads` is the campaign's thread count, each stage runs on one
+    };
+
+    struct Simulation {
+        size_t fault_position;
+        array<size_t, 4> stage1_sizes;          // candidate rows per antidiagonal
+        double stage1_space;                    // log2 of the second stage search space, the product of the sizes
+        size_t survivors;                       // second stage candidates
+        double seconds;
+    };
+
+    // splitmix64
+    inline uint64_t random(uint64_t& state) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    inline FlatState random_state(uint64_t& state) {
+        return unload(_mm_set_epi64x(random(state), random(state)));
+    }
+
+    /**
+     * @brief Ciphertext of `P` under the round keys `keys`, with the byte `fault_position` of the round 8 entry state
+     * (or of its SubBytes output) replaced by `fault(byte)`.
+     */
+    template<typename Fault>
+    inline FlatState encrypt(FlatState const& P, __m128i const keys[11], size_t fault_position, bool at_sbox_output, Fault const& fault) {
+        __m128i s = _mm_xor_si128(load(P), keys[0]);
+        for (int round = 1; round < 8; ++round) s = _mm_aesenc_si128(s, keys[round]);
+
+        FlatState S = unload(s);
+        if (at_sbox_output) S[fault_position] = INV_SBOX[fault(SBOX[S[fault_position]])];
+        else S[fault_position] = fault(S[fault_position]);
+
+        s = _mm_aesenc_si128(load(S), keys[8]);
+        s = _mm_aesenc_si128(s, keys[9]);
+
+        return unload(_mm_aesenclast_si128(s, keys[10]));
+    }
+
+    /**
+     * @brief Admissible fault differences of `model`, drawn among by the simulations.
+     */
+    inline vector<u8> fault_differences(FaultModel const& model) {
+        vector<u8> differences;
+        for (int d = 1; d < 256; ++d)
+            if (model.differences[d]) differences.push_back(d);
+
+        return differences;
+    }
+
+    /**
+     * @brief Regular and faulted ciphertexts of simulation `i`, and its fault position.
+     *
+     * The fault is any nonzero difference, a single bit, the stuck value or the known difference of `settings.model`,
+     * whose `differences` are the `fault_differences`. Ineffective faults (a byte already at its stuck value) are drawn
+     * again, key and plaintext included.
+     */
+    inline void draw(Settings const& settings, vector<u8> const& differences, size_t i, FlatState& Y, FlatState& Y_, size_t& fault_position) {
+        auto const& model = settings.model;
+
+        uint64_t state = settings.seed ^ (i * 0xd1b54a32d192ed03);
+        auto fault = [&](u8 byte) -> u8 {
+            if (model.stuck_value >= 0) return model.stuck_value;
+            return byte ^ differences[random(state) % differences.size()];
+        };
+
+        auto const& positions = settings.fault_positions;
+        do {
+            auto keys = key_schedule_from_last_round_key(load(random_state(state)));
+            FlatState P = random_state(state);
+            fault_position = positions.empty() ? random(state) % 16 : positions[random(state) % positions.size()];
+
+            Y  = encrypt(P, keys.data(), fault_position, false, [](u8 byte) { return byte; });
+            Y_ = encrypt(P, keys.data(), fault_position, model.at_sbox_output, fault);
+        } while (Y_ == Y);
+    }
+
+    /**
+     * @brief Run simulation `i`, drawing its fault among `differences`.
+     */
+    inline Simulation simulate(Settings const& settings, vector<u8> const& differences, size_t i) {
+        Simulation simulation;
+        FlatState Y, Y_;
+        draw(settings, differences, i, Y, Y_, simulation.fault_position);
+
+        auto stage2 = settings.stage2;
+        stage2.threads = 1;
+
+        auto start = chrono::steady_clock::now();
+
+        auto stage1_results = first_stage::reduction(Y, Y_, simulation.fault_position, settings.model);
+        simulation.stage1_space = 0;
+        for (size_t d = 0; d < 4; ++d) {
+            simulation.stage1_sizes[d] = stage1_results[d].size();
+            simulation.stage1_space += log2(max(stage1_results[d].size(), (size_t) 1));
+        }
+
+        simulation.survivors = second_stage::count(Y, Y_, simulation.fault_position, stage1_results, stage2, settings.model);
+        simulation.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        return simulation;
+    }
+
+    /**
+     * @brief Run every simulation of `settings`, on `settings.stage2.threads` threads.
+     */
+    inline vector<Simulation> run(Settings const& settings) {
+        vector<Simulation> simulations(settings.simulations);
+        auto differences = fault_differences(settings.model);
+
+        #pragma omp parallel for num_threads(settings.stage2.threads) schedule(dynamic)
+        for (size_t i = 0; i < simulations.size(); ++i)
+            simulations[i] = simulate(settings, differences, i);
+
+        return simulations;
+    }
+
+    /**
+     * @brief Power of two buckets: bucket 0 counts the zeros, bucket b > 0 the values in [2^(b-1), 2^b).
+     */
+    struct Histogram {
+        array<uint64_t, 48> buckets {};
+        uint64_t count = 0;
+        double sum = 0, min = HUGE_VAL, max = 0;
+
+        void add(double x) {
+            size_t b = (x < 1) ? 0 : std::min((size_t) floor(log2(x)) + 1, buckets.size() - 1);
+            ++buckets[b];
+            ++count;
+            sum += x;
+            min = std::min(min, x);
+            max = std::max(max, x);
+        }
+
+        double mean() const { return count ? sum / count : 0.0; }
+
+        static string label(size_t b) {
+            return (b == 0) ? "0" : "[" + to_string(1ull << (b - 1)) + ", " + to_string(1ull << b) + ")";
+        }
+    };
+
+    /**
+     * @brief Unit buckets: bucket b counts the values b, added as they come.
+     */
+    struct LinearHistogram {
+        vector<uint64_t> buckets;
+        uint64_t count = 0;
+        double sum = 0;
+
+        void add(size_t x) {
+            if (x >= buckets.size()) buckets.resize(x + 1);
+            ++buckets[x];
+            ++count;
+            sum += x;
+        }
+
+        double mean() const { return count ? sum / count : 0.0; }
+
+        static string label(size_t b) {
+            return to_string(b);
+        }
+    };
+
+    struct Summary {
+        uint64_t simulations = 0;
+        double stage1_space = 0;        // sum of the log2 of the search spaces
+        LinearHistogram stage1_sizes;   // candidate rows of every antidiagonal
+        Histogram survivors;
+        Histogram milliseconds;
+
+        double mean_stage1_space() const { return simulations ? stage1_space / simulations : 0.0; }
+    };
+
+    /**
+     * @brief Per fault position summaries of `simulations`, and overall in the last entry.
+     */
+    inline array<Summary, 17> summarize(vector<Simulation> const& simulations) {
+        array<Summary, 17> summaries;
+
+        for (auto const& simulation : simulations)
+            for (auto* summary : {&summaries[simulation.fault_position], &summaries[16]}) {
+                ++summary->simulations;
+                summary->stage1_space += simulation.stage1_space;
+                for (auto size : simulation.stage1_sizes) summary->stage1_sizes.add(size);
+                summary->survivors.add(simulation.survivors);
+                summary->milliseconds.add(simulation.seconds * 1000);
+            }
+
+        return summaries;
+    }
+}
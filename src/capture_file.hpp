@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "mapped_file.hpp"
+
+using namespace std;
+
+using u8 = unsigned char;
+using FlatState = array<u8, 16>;
+
+/**
+ * Binary capture files.
+ *
+ * A capture file is a 32 bytes header followed by fixed size 64 bytes records, all integers little endian:
+ *
+ *      header:  magic "ASFACAP\0" (8) | version (u32) | record size (u32) | record count (u64) | reserved (8)
+ *      record:  regular ciphertext (16) | faulted ciphertext (16) | plaintext (16) | fault (u8) | flags (u8) | reserved (14)
+ *
+ * `fault` is the fault position in [0, 16) or, with `COLUMN_ONLY`, only the index in [0, 4) of the
+ * column of the round 8 `MixColumns` input holding the fault (see `first_stage::get_diff_column`).
+ * The plaintext is meaningful only with `HAS_PLAINTEXT`.
+ *
+ * Records are read in place from a read-only memory mapping of the file.
+ */
+namespace capture_file {
+    constexpr char MAGIC[8] = {'A', 'S', 'F', 'A', 'C', 'A', 'P', '\0'};
+    constexpr uint32_t VERSION = 1;
+
+    enum Flags : u8 {
+        HAS_PLAINTEXT = 1 << 0,
+        COLUMN_ONLY   = 1 << 1,
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t record_count;
+        u8 reserved[8];
+    };
+
+    struct Record {
+        FlatState regular;
+        FlatState faulted;
+        FlatState plaintext;
+        u8 fault;
+        u8 flags;
+        u8 reserved[14];
+
+        bool has_plaintext() const { return flags & HAS_PLAINTEXT; }
+        bool column_only() const { return flags & COLUMN_ONLY; }
+    };
+
+    static_assert(sizeof(Header) == 32, "capture file header must be 32 bytes");
+    static_assert(sizeof(Record) == 64, "capture file records must be 64 bytes");
+
+    /**
+     * @brief Read-only memory mapped capture file.
+     */
+    class Reader {
+    public:
+        /**
+         * @brief Map the capture file at `path`.
+         *
+         * @return false on failure, `error()` telling why
+         */
+        bool open(string const& path) {
+            records = nullptr;
+            count = 0;
+
+            if (!file.open(path)) return fail(file.error());
+            if (file.size() < sizeof(Header)) return fail(path + ": too short to be a capture file");
+
+            auto const& header = *(Header const*) file.data();
+            if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) return fail(path + ": not a capture file");
+            if (header.version != VERSION) return fail(path + ": unsupported capture file version");
+            if (header.record_size != sizeof(Record)) return fail(path + ": unexpected record size");
+            if (header.record_count > (file.size() - sizeof(Header)) / sizeof(Record)) return fail(path + ": truncated capture file");
+
+            records = (Record const*) (file.data() + sizeof(Header));
+            count = header.record_count;
+            last_error = "";
+
+            return true;
+        }
+
+        size_t size() const { return count; }
+        Record const& operator[](size_t i) const { return records[i]; }
+        Record const* begin() const { return records; }
+        Record const* end() const { return records + count; }
+
+        string const& error() const { return last_error; }
+
+    private:
+        MappedFile file;
+        Record const* records = nullptr;
+        size_t count = 0;
+        string last_error;
+
+        bool fail(string const& message) {
+            last_error = message;
+            return false;
+        }
+    };
+
+    /**
+     * @brief Sequential capture file writer. The record count is written back by `close`.
+     */
+    class Writer {
+    public:
+        bool open(string const& path) {
+            file.open(path, ios::binary | ios::trunc);
+            if (!file) return false;
+
+            count = 0;
+            write_header();
+
+            return bool(file);
+        }
+
+        void append(Record const& record) {
+            file.write((char const*) &record, sizeof(record));
+            ++count;
+        }
+
+        bool close() {
+            file.seekp(0);
+            write_header();
+            file.close();
+
+            return !file.fail();
+        }
+
+        size_t size() const { return count; }
+
+    private:
+        ofstream file;
+        uint64_t count = 0;
+
+        void write_header() {
+            Header header {};
+            memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = VERSION;
+            header.record_size = sizeof(Record);
+            header.record_count = count;
+
+            file.write((char const*) &header, sizeof(header));
+        }
+    };
+}
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <immintrin.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "capture_file.hpp"
+
+using namespace std;
+
+/**
+ * Capture streaming through POSIX shared memory.
+ *
+ * Two single producer, single consumer rings of fixed size records link the injection rig controller to the attack:
+ * the controller publishes `capture_file::Record`s into `/NAME-captures`, and the attack publishes `Result`s into
+ * `/NAME-results`. The attack creates both segments, so the controller may come and go.
+ *
+ * Each segment is a 256 bytes header followed by a power of two count of records, all integers little endian:
+ *
+ *      header:  magic "ASFARNG\0" (8) | version (u32) | record size (u32) | capacity (u64) | reserved (40)
+ *               head (u64, own cache line) | tail (u64, own cache line) | closed (u32, own cache line)
+ *
+ * `head` counts the records published by the producer, `tail` the records released by the consumer, both only ever
+ * increasing, record `i` living in slot `i % capacity`. Records are written and read in place in the mapping, and
+ * each side keeps a private copy of the other side's counter, only reloaded when the ring looks full or empty: in the
+ * steady state moving a record costs no copy, no syscall and no shared cache line but the slot and one counter store.
+ * The producer sets `closed` after its last record.
+ */
+namespace capture_ring {
+    constexpr char MAGIC[8] = {'A', 'S', 'F', 'A', 'R', 'N', 'G', '\0'};
+    constexpr uint32_t VERSION = 1;
+    constexpr uint64_t DEFAULT_CAPACITY = 1024;
+    constexpr uint64_t MAX_CAPACITY = (uint64_t) 1 << 24;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t capacity;
+        u8 reserved[40];
+
+        alignas(64) atomic<uint64_t> head;
+        alignas(64) atomic<uint64_t> tail;
+        alignas(64) atomic<uint32_t> closed;
+    };
+
+    static_assert(sizeof(Header) == 256, "capture ring header must be 256 bytes");
+    static_assert(atomic<uint64_t>::is_always_lock_free && atomic<uint32_t>::is_always_lock_free, "ring counters are shared between processes");
+
+    /**
+     * @brief Attack results, in the order the attacks complete:
+     *
+     *      KEY      a candidate initial key of capture `sequence`
+     *      DONE     capture `sequence` is complete, with `count` keys
+     *      INVALID  capture `sequence` has an invalid fault
+     */
+    struct Result {
+        enum Status : uint32_t { KEY, DONE, INVALID };
+
+        uint64_t sequence;      // index of the capture in the stream
+        FlatState key;
+        uint32_t status;
+        uint32_t count;
+        u8 reserved[32];
+    };
+
+    static_assert(sizeof(Result) == 64, "capture ring results must be 64 bytes");
+
+    inline string segment_name(string const& name, string const& ring) {
+        return "/" + name + "-" + ring;
+    }
+
+    /**
+     * @brief Waits of a side finding the ring empty or full: spinning first, then yielding, then sleeping, for a
+     * millisecond at most so that an idle side doesn't take the CPU from the attack workers.
+     */
+    class Backoff {
+    public:
+        void wait() {
+            if (rounds < 64) _mm_pause();
+            else if (rounds < 128) this_thread::yield();
+            else this_thread::sleep_for(chrono::microseconds(min(50u << min(rounds - 128, 4u), 1000u)));
+
+            ++rounds;
+        }
+
+        void reset() { rounds = 0; }
+
+    private:
+        unsigned rounds = 0;
+    };
+
+    /**
+     * @brief One side of a ring of `T` records in a shared memory segment.
+     */
+    template<typename T>
+    class Ring {
+    public:
+        Ring() = default;
+        Ring(Ring const&) = delete;
+        Ring& operator=(Ring const&) = delete;
+
+        ~Ring() {
+            if (header != nullptr) munmap(header, mapping_size);
+            if (owner) shm_unlink(name.c_str());
+        }
+
+        /**
+         * @brief Create the segment `name` for `capacity` records, removed again when this side goes away.
+         *
+         * @return false on failure, `error()` telling why
+         */
+        bool create(string const& name, uint64_t capacity = DEFAULT_CAPACITY) {
+            if (capacity == 0 || capacity > MAX_CAPACITY || (capacity & (capacity - 1)) != 0)
+                return fail(name + ": capacity must be a power of 2 up to " + to_string(MAX_CAPACITY));
+
+            int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd < 0) return fail(name + ": " + strerror(errno));
+
+            this->name = name;
+            owner = true;
+
+            size_t size = sizeof(Header) + capacity * sizeof(T);
+            if (ftruncate(fd, size) != 0) {
+                ::close(fd);
+                return fail(name + ": " + strerror(errno));
+            }
+
+            if (!map(fd, size)) return false;
+
+            // fresh pages are zeroed, the counters start at 0
+            header->version = VERSION;
+            header->record_size = sizeof(T);
+            header->capacity = capacity;
+            atomic_thread_fence(memory_order_release);
+            memcpy(header->magic, MAGIC, sizeof(MAGIC));
+
+            return true;
+        }
+
+        /**
+         * @brief Attach to the segment `name` created by the other side.
+         *
+         * @return false on failure, `error()` telling why
+         */
+        bool attach(string const& name) {
+            int fd = shm_open(name.c_str(), O_RDWR, 0);
+            if (fd < 0) return fail(name + ": " + strerror(errno));
+
+            this->name = name;
+
+            struct stat st;
+            if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(Header)) {
+                ::close(fd);
+                return fail(name + ": not a capture ring");
+            }
+
+            if (!map(fd, st.st_size)) return false;
+
+            if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) return fail(name + ": not a capture ring");
+            atomic_thread_fence(memory_order_acquire);
+            if (header->version != VERSION) return fail(name + ": unsupported capture ring version");
+            if (header->record_size != sizeof(T)) return fail(name + ": unexpected record size");
+            if (header->capacity == 0 || (header->capacity & (header->capacity - 1)) != 0
+                || header->capacity > (mapping_size - sizeof(Header)) / sizeof(T)) return fail(name + ": truncated capture ring");
+
+            return true;
+        }
+
+        // producer side
+
+        /**
+         * @brief Slot of the next record, to fill in place then `publish`, or nullptr while the ring is full.
+         */
+        T* claim() {
+            if (head - cached_tail == capacity()) {
+                cached_tail = header->tail.load(memory_order_acquire);
+                if (head - cached_tail == capacity()) return nullptr;
+            }
+
+            return &records[head & mask()];
+        }
+
+        void publish() {
+            header->head.store(++head, memory_order_release);
+        }
+
+        /**
+         * @brief Tell the consumer there are no records after those published.
+         */
+        void close() {
+            header->closed.store(1, memory_order_release);
+        }
+
+        // consumer side
+
+        /**
+         * @brief Oldest record not released yet, read in place, or nullptr while the ring is empty.
+         */
+        T const* front() {
+            if (cached_head == tail) {
+                cached_head = header->head.load(memory_order_acquire);
+                if (cached_head == tail) return nullptr;
+            }
+
+            return &records[tail & mask()];
+        }
+
+        /**
+         * @brief Hand the slot of the `front` record back to the producer.
+         */
+        void release() {
+            header->tail.store(++tail, memory_order_release);
+        }
+
+        /**
+         * @brief Whether the producer closed the ring and every record is released.
+         */
+        bool drained() {
+            return header->closed.load(memory_order_acquire) && front() == nullptr;
+        }
+
+        // index in the stream of the `front` record
+        uint64_t position() const { return tail; }
+
+        uint64_t capacity() const { return header->capacity; }
+        string const& error() const { return last_error; }
+
+    private:
+        string name;
+        bool owner = false;
+        void* mapping = nullptr;
+        size_t mapping_size = 0;
+        Header* header = nullptr;
+        T* records = nullptr;
+
+        // private to this side
+        uint64_t head = 0, tail = 0;
+        uint64_t cached_head = 0, cached_tail = 0;
+
+        string last_error;
+
+        uint64_t mask() const { return header->capacity - 1; }
+
+        bool map(int fd, size_t size) {
+            mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (mapping == MAP_FAILED) {
+                mapping = nullptr;
+                return fail(name + ": " + strerror(errno));
+            }
+
+            mapping_size = size;
+            header = (Header*) mapping;
+            records = (T*) ((char*) mapping + sizeof(Header));
+
+            // either side may (re)attach to a running ring
+            head = cached_head = header->head.load(memory_order_acquire);
+            tail = cached_tail = header->tail.load(memory_order_acquire);
+
+            return true;
+        }
+
+        bool fail(string const& message) {
+            last_error = message;
+            return false;
+        }
+    };
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "lookup_tables.hpp"
+
+using namespace std;
+
+/**
+ * Fault descriptors, and the layouts the attack derives from them.
+ *
+ * A `FaultDescriptor` tells where a fault hits: the round whose entry state it corrupts, and which bytes of it.
+ * Everything the attack needs of its propagation through the last rounds is generated from it at compile time
+ * into a `FaultLayout`: the column of the round 8 `MixColumns` input holding the fault, the `MixColumns` factors of
+ * the first stage equations, the factors carrying the fault difference to the round 9 deltas, and the mask of the
+ * second stage check.
+ *
+ * The stage kernels are templates over a `FaultType`, whose layout is then a constant of the instantiation, and
+ * `dispatch_fault` picks the instantiation of a fault position or descriptor at run time, once per search.
+ *
+ * Faults hit one byte, or several bytes whose ShiftRows images share a column of the round 8 `MixColumns` input
+ * (a glitch corrupting part of that column): round 8 `MixColumns` then still spreads the fault over that column only.
+ */
+
+/**
+ * Position of the state byte `position` once moved by ShiftRows (bytes in column major order, row r rotated left by r).
+ */
+constexpr size_t shift_rows(size_t position) {
+    size_t row = position % 4, column = position / 4;
+    return 4 * ((column + 4 - row) % 4) + row;
+}
+
+/**
+ * Indices of the round 10 key bytes forming each antidiagonal, i.e. each `Row` of the first stage: the ciphertext
+ * bytes of column j of the round 10 ShiftRows input.
+ *
+ *      ( k1, k14, k11,  k8)
+ *      ( k5,  k2, k15, k12)
+ *      ( k9,  k6,  k3, k16)
+ *      (k13, k10,  k7,  k4)
+ */
+constexpr array<array<size_t, 4>, 4> ANTIDIAGONALS = [] {
+    array<array<size_t, 4>, 4> antidiagonals {};
+    for (size_t j = 0; j < 4; ++j)
+        for (size_t i = 0; i < 4; ++i) antidiagonals[j][i] = shift_rows(4 * j + i);
+    return antidiagonals;
+}();
+
+struct FaultDescriptor {
+    size_t round;       // whose entry state is faulted
+    uint16_t bytes;     // faulted bytes of that state, bit i for byte i
+};
+
+struct FaultLayout {
+    bool single_byte;
+    size_t diff_column;                     // column of the round 8 `MixColumns` input holding the fault
+    array<array<size_t, 4>, 4> factors;     // of the first stage equations: antidiagonal j, byte i
+    array<u8, 4> propagation;               // single byte: from the fault difference eps to the round 9 input difference of antidiagonal j
+    int fault_mask;                         // bytes of the round 8 `MixColumns` input left unchanged by the fault
+    int checked_mask;                       // bytes the second stage compares to `fault_mask`: all of them if the one faulted
+                                            // byte has to change, the unchanged ones if each faulted byte may or may not
+};
+
+/**
+ * @brief Whether the attack handles faults described by `fault`: bytes of the round 8 entry state, in one column
+ * once shifted by ShiftRows.
+ */
+constexpr bool is_supported(FaultDescriptor const& fault) {
+    if (fault.round != 8 || fault.bytes == 0) return false;
+
+    size_t column = 4;
+    for (size_t position = 0; position < 16; ++position) {
+        if (!(fault.bytes >> position & 1)) continue;
+        if (column != 4 && shift_rows(position) / 4 != column) return false;
+        column = shift_rows(position) / 4;
+    }
+
+    return true;
+}
+
+constexpr FaultDescriptor single_byte_fault(size_t position) {
+    return {8, (uint16_t) (1 << position)};
+}
+
+/**
+ * @brief Faulted bytes of the round 8 entry state landing in the rows `rows` (bit r for row r) of column `column`
+ * of the `MixColumns` input.
+ */
+constexpr uint16_t column_fault_bytes(size_t column, unsigned rows) {
+    uint16_t bytes = 0;
+    for (size_t r = 0; r < 4; ++r)
+        if (rows >> r & 1) bytes |= 1 << (4 * ((column + r) % 4) + r);
+    return bytes;
+}
+
+/**
+ * @brief Layout of the faults described by `fault`, assumed supported.
+ *
+ * ShiftRows moves the faulted byte (r, c') to column c, which round 8 `MixColumns` spreads with the factors
+ * f_i = MixColumns[i][r]. Round 9 ShiftRows then sends its byte (r_j, c), r_j = (c - j) mod 4, to column j,
+ * where its SubBytes output difference delta_j spreads with the factors MixColumns[i][r_j], round 10 keeping
+ * the column as antidiagonal j of the ciphertext.
+ */
+constexpr FaultLayout make_layout(FaultDescriptor const& fault) {
+    size_t position = 0;
+    while (!(fault.bytes >> position & 1)) ++position;
+
+    FaultLayout layout {};
+    layout.single_byte = (fault.bytes & (fault.bytes - 1)) == 0;
+    layout.diff_column = shift_rows(position) / 4;
+
+    layout.fault_mask = 0xffff;
+    for (size_t p = 0; p < 16; ++p)
+        if (fault.bytes >> p & 1) layout.fault_mask &= ~(1 << shift_rows(p));
+    layout.checked_mask = layout.single_byte ? 0xffff : layout.fault_mask;
+
+    for (size_t j = 0; j < 4; ++j) {
+        size_t r = (layout.diff_column + 4 - j) % 4;
+
+        if (layout.single_byte) layout.propagation[j] = MIX_COLUMNS[r][position % 4];
+        for (size_t i = 0; i < 4; ++i) layout.factors[j][i] = MIX_COLUMNS[i][r];
+    }
+
+    return layout;
+}
+
+/**
+ * @brief A fault description as a type, so that kernels get its layout as compile time constants.
+ */
+template<size_t ROUND, uint16_t BYTES>
+struct FaultType {
+    static constexpr FaultDescriptor DESCRIPTOR {ROUND, BYTES};
+    static_assert(is_supported(DESCRIPTOR), "unsupported fault");
+
+    static constexpr FaultLayout LAYOUT = make_layout(DESCRIPTOR);
+};
+
+template<size_t POSITION>
+using SingleByteFault = FaultType<8, (uint16_t) (1 << POSITION)>;
+
+template<size_t COLUMN, unsigned ROWS>
+using ColumnFault = FaultType<8, column_fault_bytes(COLUMN, ROWS)>;
+
+/**
+ * Layouts of the single byte faults, by fault position.
+ */
+constexpr array<FaultLayout, 16> SINGLE_BYTE_LAYOUTS = [] {
+    array<FaultLayout, 16> layouts {};
+    for (size_t position = 0; position < 16; ++position) layouts[position] = make_layout({8, (uint16_t) (1 << position)});
+    return layouts;
+}();
+
+template<typename Visitor, size_t... POSITIONS>
+inline decltype(auto) dispatch_fault(size_t fault_position, Visitor& visitor, index_sequence<POSITIONS...>) {
+    using Result = decltype(visitor(SingleByteFault<0>()));
+    constexpr Result (*kernels[])(Visitor&) = {[](Visitor& visitor) -> Result { return visitor(SingleByteFault<POSITIONS>()); }...};
+
+    return kernels[fault_position](visitor);
+}
+
+/**
+ * @brief `visitor(SingleByteFault<fault_position>())`, `visitor` being instantiated for the 16 positions.
+ */
+template<typename Visitor>
+inline decltype(auto) dispatch_fault(size_t fault_position, Visitor&& visitor) {
+    return dispatch_fault(fault_position, visitor, make_index_sequence<16>());
+}
+
+// the 15 nonempty row sets of each column, in order
+template<typename Visitor, size_t... FAULTS>
+inline decltype(auto) dispatch_fault(FaultDescriptor const& fault, Visitor& visitor, index_sequence<FAULTS...>) {
+    using Result = decltype(visitor(SingleByteFault<0>()));
+    constexpr Result (*kernels[])(Visitor&) = {[](Visitor& visitor) -> Result { return visitor(ColumnFault<FAULTS / 15, FAULTS % 15 + 1>()); }...};
+
+    auto layout = make_layout(fault);
+    unsigned rows = 0;
+    for (size_t p = 0; p < 16; ++p)
+        if (fault.bytes >> p & 1) rows |= 1 << (p % 4);
+
+    return kernels[15 * layout.diff_column + rows - 1](visitor);
+}
+
+/**
+ * @brief `visitor(FaultType<8, fault.bytes>())` for a supported `fault`, `visitor` being instantiated for the 60
+ * faults of 1 to 4 bytes of a column. Single byte faults get the same instantiations as their position.
+ */
+template<typename Visitor>
+inline decltype(auto) dispatch_fault(FaultDescriptor const& fault, Visitor&& visitor) {
+    return dispatch_fault(fault, visitor, make_index_sequence<60>());
+}
+
+/**
+ * @brief Mask of the bytes of the round 8 `MixColumns` input a fault at `fault_position` leaves unchanged.
+ */
+inline int get_fault_mask(size_t fault_position) {
+    return SINGLE_BYTE_LAYOUTS[fault_position].fault_mask;
+}
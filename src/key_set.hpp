@@ -0,0 +1,359 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+using u8 = unsigned char;
+using FlatState = array<u8, 16>;
+
+/**
+ * Key set files.
+ *
+ * A key set file holds a set of 16 bytes keys (round 10 keys of a capture, shard or session, or initial keys), sorted
+ * in byte order without duplicates and front coded: each key is the number of leading bytes it shares with the
+ * previous one, then its remaining bytes. The sorted keys of a set of n random keys share about log256(n) bytes
+ * with their predecessor, which the coding saves.
+ *
+ *      header:  magic "ASFAKEY\0" (8) | version (u32) | reserved (u32) | key count (u64) | reserved (8)
+ *      key:     shared prefix length (u8, < 16) | suffix (16 - prefix length)
+ *
+ * Sets are read and written as streams through small buffers, so the set operations merge files of any size in
+ * constant memory.
+ */
+namespace key_set {
+    constexpr char MAGIC[8] = {'A', 'S', 'F', 'A', 'K', 'E', 'Y', '\0'};
+    constexpr uint32_t VERSION = 1;
+    constexpr size_t BUFFER_SIZE = (size_t) 1 << 16;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t key_count;
+        u8 reserved2[8];
+    };
+
+    static_assert(sizeof(Header) == 32, "key set header must be 32 bytes");
+
+    /**
+     * @brief Three way comparison of `a` and `b` in byte order: the first differing byte found by one SSE compare.
+     */
+    inline int compare(FlatState const& a, FlatState const& b) {
+        __m128i x = _mm_loadu_si128((__m128i const*) a.data());
+        __m128i y = _mm_loadu_si128((__m128i const*) b.data());
+
+        unsigned differing = ~(unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) & 0xffff;
+        if (differing == 0) return 0;
+
+        size_t i = __builtin_ctz(differing);
+        return (a[i] < b[i]) ? -1 : 1;
+    }
+
+    /**
+     * @brief Number of leading bytes `a` and `b` share.
+     */
+    inline size_t shared_prefix(FlatState const& a, FlatState const& b) {
+        __m128i x = _mm_loadu_si128((__m128i const*) a.data());
+        __m128i y = _mm_loadu_si128((__m128i const*) b.data());
+
+        unsigned differing = ~(unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) & 0xffff;
+        return (differing == 0) ? 16 : __builtin_ctz(differing);
+    }
+
+    /**
+     * @brief Key of the 32 hex digits at `hex`, into `key`.
+     *
+     * @return false if they aren't all hex digits
+     */
+    inline bool parse(char const* hex, FlatState& key) {
+        auto digit = [](char c) {
+            return (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        };
+
+        for (size_t i = 0; i < 16; ++i) {
+            int high = digit(hex[2 * i]), low = digit(hex[2 * i + 1]);
+            if (high < 0 || low < 0) return false;
+            key[i] = high << 4 | low;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Sort `keys` in byte order and drop the duplicates.
+     *
+     * Keys are first scattered on their two leading bytes (one counting pass and one scatter pass), leaving buckets of
+     * a few keys for uniform keys, each then sorted by comparison.
+     */
+    inline void sort(vector<FlatState>& keys) {
+        constexpr size_t BUCKETS = 1 << 16;
+        auto bucket = [](FlatState const& key) { return (size_t) key[0] << 8 | key[1]; };
+        auto less = [](FlatState const& a, FlatState const& b) { return compare(a, b) < 0; };
+
+        vector<size_t> offsets(BUCKETS + 1, 0);
+        for (auto const& key : keys) ++offsets[bucket(key) + 1];
+        for (size_t b = 0; b < BUCKETS; ++b) offsets[b + 1] += offsets[b];
+
+        vector<FlatState> sorted(keys.size());
+        vector<size_t> next(offsets.begin(), offsets.end() - 1);
+        for (auto const& key : keys) sorted[next[bucket(key)]++] = key;
+
+        for (size_t b = 0; b < BUCKETS; ++b)
+            if (offsets[b + 1] - offsets[b] > 1) std::sort(sorted.begin() + offsets[b], sorted.begin() + offsets[b + 1], less);
+
+        sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+        keys = move(sorted);
+    }
+
+    /**
+     * @brief Streaming key set file reader.
+     */
+    class Reader {
+    public:
+        /**
+         * @brief Open the key set file at `path`.
+         *
+         * @return false on failure, `error()` telling why
+         */
+        bool open(string const& path) {
+            this->path = path;
+            last_error = "";
+            file.close();
+            file.clear();
+            file.open(path, ios::binary);
+            if (!file) return fail("cannot open");
+
+            Header header;
+            if (!file.read((char*) &header, sizeof(header)) || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) return fail("not a key set file");
+            if (header.version != VERSION) return fail("unsupported key set version");
+
+            count = remaining = header.key_count;
+            buffer.assign(PADDING + BUFFER_SIZE, 0);
+            begin = end = PADDING;
+            previous = _mm_setzero_si128();
+
+            return true;
+        }
+
+        /**
+         * @brief Next key of the set, into `key`.
+         *
+         * @return false past the last key, or on a corrupt file, `error()` telling why
+         */
+        bool next(FlatState& key) {
+            if (remaining == 0) return false;
+
+            // a whole key at least in the buffer
+            if (end - begin < 17 && !refill()) return false;
+
+            size_t prefix = buffer[begin];
+            if (prefix >= 16) return fail("corrupt key set");
+            if (end - begin < 17 - prefix) return fail("truncated key set");
+
+            // the suffix loaded in place, shifted by the prefix thanks to the padding, then blended in
+            __m128i suffix = _mm_loadu_si128((__m128i const*) &buffer[begin + 1 - prefix]);
+            __m128i shared = _mm_cmpgt_epi8(_mm_set1_epi8(prefix), _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+            previous = _mm_blendv_epi8(suffix, previous, shared);
+            begin += 17 - prefix;
+            --remaining;
+
+            _mm_storeu_si128((__m128i*) key.data(), previous);
+            return true;
+        }
+
+        uint64_t size() const { return count; }
+        string const& error() const { return last_error; }
+
+    private:
+        string path;
+        ifstream file;
+        // so that a suffix is loaded from up to 15 bytes before its start
+        static constexpr size_t PADDING = 16;
+
+        vector<u8> buffer;
+        size_t begin = 0, end = 0;
+        uint64_t count = 0, remaining = 0;
+        __m128i previous;
+        string last_error;
+
+        bool refill() {
+            memmove(buffer.data() + PADDING, buffer.data() + begin, end - begin);
+            end -= begin - PADDING;
+            begin = PADDING;
+
+            file.read((char*) buffer.data() + end, buffer.size() - end);
+            end += file.gcount();
+
+            if (end == PADDING) return fail("truncated key set");
+            return true;
+        }
+
+        bool fail(string const& message) {
+            last_error = path + ": " + message;
+            remaining = 0;
+            return false;
+        }
+    };
+
+    /**
+     * @brief Streaming key set file writer, of keys appended in increasing order. The key count is written back by
+     * `close`.
+     */
+    class Writer {
+    public:
+        bool open(string const& path) {
+            this->path = path;
+            file.open(path, ios::binary | ios::trunc);
+            if (!file) return fail("cannot open");
+
+            count = 0;
+            buffer.clear();
+            buffer.reserve(BUFFER_SIZE);
+            write_header();
+
+            return bool(file);
+        }
+
+        /**
+         * @brief Append `key`, skipped if equal to the last one.
+         *
+         * @return false if `key` is below the last one, `error()` telling why
+         */
+        bool append(FlatState const& key) {
+            size_t prefix = 0;
+
+            if (count != 0) {
+                int order = compare(key, previous);
+                if (order == 0) return true;
+                if (order < 0) return fail("keys out of order");
+
+                prefix = shared_prefix(key, previous);
+            }
+
+            if (buffer.size() + 17 > BUFFER_SIZE) flush();
+
+            buffer.push_back(prefix);
+            buffer.insert(buffer.end(), key.begin() + prefix, key.end());
+
+            previous = key;
+            ++count;
+
+            return true;
+        }
+
+        bool close() {
+            flush();
+            file.seekp(0);
+            write_header();
+            file.close();
+
+            return !file.fail() || fail("write error");
+        }
+
+        uint64_t size() const { return count; }
+        string const& error() const { return last_error; }
+
+    private:
+        string path;
+        ofstream file;
+        vector<u8> buffer;
+        uint64_t count = 0;
+        FlatState previous {};
+        string last_error;
+
+        void flush() {
+            file.write((char const*) buffer.data(), buffer.size());
+            buffer.clear();
+        }
+
+        void write_header() {
+            Header header {};
+            memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = VERSION;
+            header.key_count = count;
+
+            file.write((char const*) &header, sizeof(header));
+        }
+
+        bool fail(string const& message) {
+            last_error = path + ": " + message;
+            return false;
+        }
+    };
+
+    /**
+     * @brief Write the set of `keys`, in any order, to the key set file at `path`.
+     *
+     * @return false on failure, `error` telling why
+     */
+    inline bool write(string const& path, vector<FlatState> keys, string& error) {
+        sort(keys);
+
+        Writer writer;
+        if (!writer.open(path)) {
+            error = writer.error();
+            return false;
+        }
+
+        for (auto const& key : keys) writer.append(key);
+
+        if (!writer.close()) {
+            error = writer.error();
+            return false;
+        }
+
+        return true;
+    }
+
+    enum class Operation { INTERSECTION, UNION, DIFFERENCE };
+
+    /**
+     * @brief Merge the sets read by `a` and `b` into `out`: keys in both, in either, or in `a` but not in `b`.
+     *
+     * @return false on failure, `error` telling why
+     */
+    inline bool merge(Reader& a, Reader& b, Operation operation, Writer& out, string& error) {
+        FlatState x, y;
+        bool has_x = a.next(x), has_y = b.next(y);
+
+        bool keep_a = operation != Operation::INTERSECTION;     // keys only in a
+        bool keep_b = operation == Operation::UNION;            // keys only in b
+        bool keep_both = operation != Operation::DIFFERENCE;
+
+        while (has_x && has_y) {
+            int order = compare(x, y);
+
+            if (order < 0) {
+                if (keep_a) out.append(x);
+                has_x = a.next(x);
+            } else if (order > 0) {
+                if (keep_b) out.append(y);
+                has_y = b.next(y);
+            } else {
+                if (keep_both) out.append(x);
+                has_x = a.next(x);
+                has_y = b.next(y);
+            }
+        }
+
+        for (; has_x && keep_a; has_x = a.next(x)) out.append(x);
+        for (; has_y && keep_b; has_y = b.next(y)) out.append(y);
+
+        for (string const* e : {&a.error(), &b.error(), &out.error()})
+            if (*e != "") {
+                error = *e;
+                return false;
+            }
+
+        return true;
+    }
+}
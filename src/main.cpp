@@ -1,75 +1,1386 @@
-#include "reductions.hpp"
-
-#include <iostream>
-#include <iomanip>
-#include <string>
-#include <sstream>
-
-using namespace std;
-
-FlatState string_to_state(string const& s) {
-    FlatState X;
-    
-    auto hex_to_int = [](string s) {
-        int out;
-        istringstream(s) >> hex >> out;
-        return out;
-    };
-
-    for (int i = 0; i < 16; ++i) {
-        auto couple_of_hex_chars = s.substr(2*i, 2);
-        X[i] = hex_to_int(couple_of_hex_chars);
-    }
-
-    return X;
-}
-
-ostream& operator<<(ostream& os, FlatState const& state) {
-    for (int x : state)
-        os << setw(2) << setfill('0') << hex << x;
-    
-    os << setw(0) << setfill(' ') << dec; // back to default formatting
-
-    return os;
-}
-
-void crack(string const& regular_ciphertext, string const& faulted_ciphertext, size_t fault_position, string const& plaintext = "") {
-    vector<FlatState> found_keys;
-    
-    auto Y = string_to_state(regular_ciphertext);
-    auto Y_ = string_to_state(faulted_ciphertext);
-
-    auto stage1_results = first_stage::reduction(Y, Y_, fault_position);
-    auto stage2_results = second_stage::reduction(Y, Y_, fault_position, stage1_results);
-    
-    if (plaintext != "") {
-        auto X = string_to_state(plaintext);
-        found_keys = third_stage::reduction(Y, X, stage2_results);  
-    } else { 
-        for (auto key : stage2_results)
-            found_keys.push_back(get_initial_key(key));
-    }
-    
-    for (auto key : found_keys)
-            cout << key << endl;
-}
-
-int main(int argc, char* argv[]) {
-    string regular_ciphertext, faulted_ciphertext, plaintext;
-    size_t fault_position;
-
-    if (argc != 4 && argc != 5) {
-        cout << "Usage: aes-single-fault-attack regular_cipher faulted_cipher fault_position [plaintext]" << endl;
-        return 1;
-    }
-
-    istringstream(argv[1]) >> regular_ciphertext;
-    istringstream(argv[2]) >> faulted_ciphertext;
-    istringstream(argv[3]) >> fault_position;
-    if (argc == 5) istringstream(argv[4]) >> plaintext;
-
-    // TODO: add checks to sanitize and validate input
-    crack(regular_ciphertext, faulted_ciphertext, fault_position, plaintext);
-
-    return 0;
-};
+#include "reductions.hpp"
+#include "aes256.hpp"
+#include "campaign.hpp"
+#include "oracle.hpp"
+#include "profiling.hpp"
+#include "result_cache.hpp"
+#include "capture_file.hpp"
+#include "capture_ring.hpp"
+#include "key_set.hpp"
+#include "session.hpp"
+#include "scheduler.hpp"
+#include "statistical.hpp"
+#include "tracing.hpp"
+#include "tuning.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+FlatState string_to_state(string const& s) {
+    FlatState X;
+    
+    auto hex_to_int = [](string s) {
+        int out;
+        istringstream(s) >> hex >> out;
+        return out;
+    };
+
+    for (int i = 0; i < 16; ++i) {
+        auto couple_of_hex_chars = s.substr(2*i, 2);
+        X[i] = hex_to_int(couple_of_hex_chars);
+    }
+
+    return X;
+}
+
+ostream& operator<<(ostream& os, FlatState const& state) {
+    for (int x : state)
+        os << setw(2) << setfill('0') << hex << x;
+    
+    os << setw(0) << setfill(' ') << dec; // back to default formatting
+
+    return os;
+}
+
+ostream& operator<<(ostream& os, aes256::Key const& key) {
+    for (int x : key)
+        os << setw(2) << setfill('0') << hex << x;
+
+    os << setw(0) << setfill(' ') << dec;
+
+    return os;
+}
+
+/**
+ * @brief Command line options of the commands running the attack.
+ */
+struct Options {
+    KeyHints hints;
+    FaultModel fault_model;
+    second_stage::Settings settings;
+    profiling::Profiler* profiler = nullptr;
+    int workers = 0;    // batch: size of the shared worker pool attacking the records concurrently, 0 for one record at a time
+    vector<FlatState> ciphertexts;                  // more ciphertexts of the key, for the plaintext structure oracle
+    vector<oracle::Structure> structures;           // what is known of their plaintexts
+    result_cache::Cache* cache = nullptr;           // second stage results of earlier runs, if enabled
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();  // the second stage stops past it
+    size_t max_keys = 0;                            // the second stage stops once that many candidates are found, 0 for no limit
+    map<size_t, vector<u8>> covered;                // per fault position, second stage units searched by earlier runs
+    uint16_t fault_bytes = 0;                       // bytes faulted along with the fault position, for a multi-byte fault
+    size_t shard = 0;                               // second stage: the part of the units searched by this run,
+    size_t shards = 1;                              // out of `shards`
+};
+
+/**
+ * @brief Parse a `--k10-byte` specification `INDEX:VALUES` into `hints`.
+ * 
+ * `INDEX` is a decimal byte index in [0, 16), `VALUES` a comma separated list of hex values or `LO-HI` hex ranges.
+ * Constraints on the same byte are intersected.
+ * 
+ * @return false if `spec` is malformed
+ */
+bool parse_key_byte_hint(string const& spec, KeyHints& hints) {
+    auto colon = spec.find(':');
+    if (colon == string::npos) return false;
+
+    size_t index;
+    if (!(istringstream(spec.substr(0, colon)) >> index) || index >= 16) return false;
+
+    bitset<256> allowed;
+    istringstream values(spec.substr(colon + 1));
+    string value;
+
+    while (getline(values, value, ',')) {
+        auto dash = value.find('-');
+        unsigned int lo, hi;
+
+        if (!(istringstream(value.substr(0, dash)) >> hex >> lo)) return false;
+        hi = lo;
+        if (dash != string::npos && !(istringstream(value.substr(dash + 1)) >> hex >> hi)) return false;
+        if (lo > hi || hi > 0xff) return false;
+
+        for (unsigned int x = lo; x <= hi; ++x) allowed.set(x);
+    }
+
+    hints.allowed_bytes[index] &= allowed;
+
+    return allowed.any();
+}
+
+/**
+ * @brief Parse a `--covered` specification `POSITION:UNITS` into `covered`, `UNITS` being a comma separated list of
+ * decimal unit indices or `LO-HI` ranges, as reported by a second stage that stopped early.
+ * 
+ * @return false if `spec` is malformed
+ */
+bool parse_covered_units(string const& spec, map<size_t, vector<u8>>& covered) {
+    auto colon = spec.find(':');
+    if (colon == string::npos) return false;
+
+    size_t position;
+    if (!(istringstream(spec.substr(0, colon)) >> position) || position >= 16) return false;
+
+    auto& units = covered[position];
+    istringstream values(spec.substr(colon + 1));
+    string value;
+
+    while (getline(values, value, ',')) {
+        auto dash = value.find('-');
+        size_t lo, hi;
+
+        if (!(istringstream(value.substr(0, dash)) >> lo)) return false;
+        hi = lo;
+        if (dash != string::npos && !(istringstream(value.substr(dash + 1)) >> hi)) return false;
+        if (lo > hi || hi >= (1 << 20)) return false;
+
+        if (units.size() <= hi) units.resize(hi + 1, 0);
+        fill(units.begin() + lo, units.begin() + hi + 1, 1);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Parse a comma separated list of fault positions into `positions`.
+ * 
+ * @return false if `spec` is malformed or a position is out of range
+ */
+bool parse_fault_positions(string const& spec, vector<size_t>& positions) {
+    istringstream values(spec);
+    string value;
+
+    while (getline(values, value, ',')) {
+        size_t position;
+        if (!(istringstream(value) >> position) || position >= 16) return false;
+        positions.push_back(position);
+    }
+
+    return !positions.empty();
+}
+
+/**
+ * @brief Parse a fault argument, a position or `+` separated positions of a multi-byte fault, into the first position
+ * and the other faulted bytes.
+ * 
+ * @return false if `spec` is malformed, or if the bytes don't land in one column of the round 8 `MixColumns` input
+ */
+bool parse_fault(string const& spec, size_t& fault_position, uint16_t& fault_bytes) {
+    istringstream values(spec);
+    string value;
+    uint16_t bytes = 0;
+
+    while (getline(values, value, '+')) {
+        size_t position;
+        if (!(istringstream(value) >> position) || position >= 16 || (bytes >> position & 1)) return false;
+        if (bytes == 0) fault_position = position;
+        bytes |= 1 << position;
+    }
+
+    fault_bytes = bytes & ~(1 << fault_position);
+
+    return bytes != 0 && is_supported({8, bytes});
+}
+
+/**
+ * @brief Parse a `--shard` specification `I/N`, I in [1, N], into the 0 based `shard` of `shards`.
+ * 
+ * @return false if `spec` is malformed
+ */
+bool parse_shard(string const& spec, size_t& shard, size_t& shards) {
+    auto slash = spec.find('/');
+    if (slash == string::npos) return false;
+
+    size_t i, n;
+    if (!(istringstream(spec.substr(0, slash)) >> i) || !(istringstream(spec.substr(slash + 1)) >> n)) return false;
+    if (i == 0 || i > n) return false;
+
+    shard = i - 1;
+    shards = n;
+
+    return true;
+}
+
+/**
+ * @brief The indices of the set `units`, as comma separated `LO-HI` ranges.
+ */
+string format_units(vector<u8> const& units) {
+    ostringstream ranges;
+
+    for (size_t lo = 0; lo < units.size(); ++lo) {
+        if (!units[lo]) continue;
+
+        size_t hi = lo;
+        while (hi + 1 < units.size() && units[hi + 1]) ++hi;
+
+        ranges << (ranges.tellp() > 0 ? "," : "") << lo;
+        if (hi > lo) ranges << "-" << hi;
+        lo = hi;
+    }
+
+    return ranges.str();
+}
+
+/**
+ * @brief Parse a `--fault` specification into `model`: `any`, `bit-flip`, `stuck-at:HH` or `xor:HH` (known difference).
+ * 
+ * @return false if `spec` is malformed
+ */
+bool parse_fault_model(string const& spec, FaultModel& model) {
+    bool at_sbox_output = model.at_sbox_output;
+    unsigned int value;
+
+    auto hex_value = [&](string const& prefix) {
+        return spec.rfind(prefix, 0) == 0 && (istringstream(spec.substr(prefix.size())) >> hex >> value) && value <= 0xff;
+    };
+
+    if (spec == "any") model = FaultModel();
+    else if (spec == "bit-flip") model = FaultModel::bit_flip();
+    else if (hex_value("stuck-at:")) model = FaultModel::stuck_at(value);
+    else if (hex_value("xor:") && value != 0) model = FaultModel::known_difference(value);
+    else return false;
+
+    model.at_sbox_output = at_sbox_output;
+
+    return true;
+}
+
+/**
+ * @brief Parse an `--oracle` specification, `printable`, `magic:HEX`, `zeros:N` or `entropy:BITS`, into one more of `structures`.
+ * 
+ * @return false if `spec` is malformed
+ */
+bool parse_plaintext_structure(string const& spec, vector<oracle::Structure>& structures) {
+    using Kind = oracle::Structure::Kind;
+    oracle::Structure structure;
+
+    auto value = [&](string const& prefix) {
+        return (spec.rfind(prefix, 0) == 0) ? spec.substr(prefix.size()) : string();
+    };
+
+    if (spec == "printable") {
+        structure.kind = Kind::PRINTABLE;
+    } else if (value("magic:") != "") {
+        string magic = value("magic:");
+        if (magic.size() % 2 != 0 || magic.size() > 32) return false;
+
+        structure.kind = Kind::MAGIC;
+        for (size_t i = 0; i < magic.size(); i += 2) {
+            unsigned int byte;
+            if (!(istringstream(magic.substr(i, 2)) >> hex >> byte)) return false;
+            structure.magic.push_back(byte);
+        }
+    } else if (value("zeros:") != "") {
+        structure.kind = Kind::ZERO_PADDING;
+        if (!(istringstream(value("zeros:")) >> structure.padding) || structure.padding == 0 || structure.padding > 16) return false;
+    } else if (value("entropy:") != "") {
+        structure.kind = Kind::ENTROPY;
+        if (!(istringstream(value("entropy:")) >> structure.max_entropy) || structure.max_entropy < 0) return false;
+    } else {
+        return false;
+    }
+
+    structures.push_back(structure);
+
+    return true;
+}
+
+/**
+ * @brief Positions compatible with a fault described by `fault`, a position or, if `column_only`, a differential column.
+ * 
+ * @return vector<size_t> fault positions, empty if `fault` is out of range
+ */
+vector<size_t> get_fault_positions(size_t fault, bool column_only) {
+    vector<size_t> fault_positions;
+
+    for (size_t position = 0; position < 16; ++position)
+        if (column_only ? first_stage::get_diff_column(position) == fault : position == fault)
+            fault_positions.push_back(position);
+
+    return fault_positions;
+}
+
+/**
+ * @brief Third stage: the initial keys of the candidates `stage2_results` of regular ciphertext `Y`, checked against
+ * `plaintext` if any, or else against the plaintext structure oracle of `options` if any.
+ * 
+ * With `--k0` candidates, only those of them among `stage2_results` are left: the first stage hints only check each
+ * antidiagonal on its own, letting through the keys mixing the antidiagonals of several candidates.
+ */
+vector<FlatState> initial_keys(FlatState const& Y, vector<FlatState> stage2_results, FlatState const* plaintext, Options const& options) {
+    vector<FlatState> found_keys;
+
+    profiling::Scope scope(options.profiler, "stage3");
+    auto const& hinted = options.hints.last_round_keys;
+    if (!hinted.empty())
+        stage2_results.erase(remove_if(stage2_results.begin(), stage2_results.end(), [&](FlatState const& K10) {
+            return find(hinted.begin(), hinted.end(), K10) == hinted.end();
+        }), stage2_results.end());
+
+    if (plaintext != nullptr) {
+        found_keys = third_stage::reduction(Y, *plaintext, stage2_results, options.settings.inversion);
+    } else if (!options.structures.empty()) {
+        auto shortlist = oracle::rank(stage2_results, options.ciphertexts, options.structures, options.settings.threads, options.settings.inversion);
+        cerr << shortlist.size() << " of " << stage2_results.size() << " candidate keys fit the plaintext structure" << endl;
+
+        for (auto const& candidate : shortlist)
+            found_keys.push_back(get_initial_key(candidate.K10, options.settings.inversion));
+    } else { 
+        for (auto key : stage2_results)
+            found_keys.push_back(get_initial_key(key, options.settings.inversion));
+    }
+
+    return found_keys;
+}
+
+/**
+ * @brief Store the candidates `stage2_results` of a capture in the result cache of `options`, if enabled.
+ */
+void cache_results(string const& fingerprint, vector<FlatState> const& stage2_results, Options const& options) {
+    if (options.cache == nullptr) return;
+
+    profiling::Scope scope(options.profiler, "cache");
+    string error;
+    if (!options.cache->store(fingerprint, stage2_results, error)) cerr << "result cache: " << error << endl;
+}
+
+/**
+ * @brief Run the three stages on a capture whose fault lies somewhere in `fault_positions`, hitting the bytes of
+ * `options.fault_bytes` as well.
+ * 
+ * All the positions must share the same differential column, so that the first stage is run once.
+ * The first two stages are skipped when the result cache already holds the capture.
+ * 
+ * @return vector<FlatState> candidate initial keys
+ */
+vector<FlatState> attack(FlatState const& Y, FlatState const& Y_, vector<size_t> const& fault_positions, FlatState const* plaintext, Options const& options) {
+    vector<FlatState> stage2_results;
+    string fingerprint;
+
+    auto fault_at = [&](size_t fault_position) {
+        return FaultDescriptor {8, (uint16_t) (1 << fault_position | options.fault_bytes)};
+    };
+
+    // a multi-byte fault may leave a round 9 byte unchanged, whose antidiagonal the first stage then can't reduce
+    for (auto const& ind : ANTIDIAGONALS)
+        if (Y[ind[0]] == Y_[ind[0]] && Y[ind[1]] == Y_[ind[1]] && Y[ind[2]] == Y_[ind[2]] && Y[ind[3]] == Y_[ind[3]]) {
+            cerr << "the ciphertexts match on the antidiagonal of key bytes " << ind[0] << ", " << ind[1] << ", " << ind[2] << ", " << ind[3]
+                 << ": out of reach of the first stage" << endl;
+            return {};
+        }
+
+    // the cache fingerprint tells single byte faults only
+    bool cacheable = options.fault_bytes == 0;
+
+    if (options.cache != nullptr && cacheable) {
+        profiling::Scope scope(options.profiler, "cache");
+        fingerprint = result_cache::fingerprint(Y, Y_, fault_positions, options.hints, options.fault_model);
+        if (options.cache->lookup(fingerprint, stage2_results)) return initial_keys(Y, stage2_results, plaintext, options);
+    }
+
+    array<vector<Row>, 4> stage1_results;
+    {
+        profiling::Scope scope(options.profiler, "stage1");
+        // the first stage deltas depend on the fault row, only restricted for a known position
+        auto stage1_model = (fault_positions.size() == 1) ? options.fault_model : FaultModel();
+        stage1_results = first_stage::reduction(Y, Y_, fault_at(fault_positions.front()), options.hints, stage1_model);
+    }
+
+    // the units searched by this run and earlier ones, per fault position, if the search stops early
+    map<size_t, vector<u8>> covered;
+    string stop_reason;
+
+    {
+        profiling::Scope scope(options.profiler, "stage2");
+        for (size_t fault_position : fault_positions) {
+            if (stop_reason != "") break;
+
+            second_stage::Control control;
+            control.deadline = options.deadline;
+            if (options.max_keys != 0) control.max_keys = options.max_keys - stage2_results.size();
+            if (options.covered.count(fault_position)) control.skip = options.covered.at(fault_position);
+            control.shard = options.shard;
+            control.shards = options.shards;
+
+            // no need to search further once the key is found
+            if (plaintext != nullptr)
+                control.accept = [&](FlatState const& K10) { return decrypt(Y, K10, options.settings.inversion) == *plaintext; };
+
+            auto keys = second_stage::run(Y, Y_, fault_at(fault_position), stage1_results, options.settings, options.fault_model, &control);
+            stage2_results.insert(stage2_results.end(), keys.begin(), keys.end());
+            covered[fault_position] = control.covered;
+
+            if (control.accepted)
+                stop_reason = "plaintext matched";
+            else if (control.cancelled)
+                stop_reason = (control.max_keys != 0 && control.keys_found >= control.max_keys) ? "key budget spent" : "deadline reached";
+        }
+    }
+
+    if (stop_reason != "" && stop_reason != "plaintext matched") {
+        // multi-byte faults are always swept by key blocks
+        auto engine = (options.fault_bytes != 0) ? second_stage::Engine::RANGE : options.settings.engine;
+
+        bool join = engine == second_stage::Engine::JOIN;
+        string unit_name = join ? "fault differences " : (engine == second_stage::Engine::RANGE) ? "key blocks " : "rows ";
+        string resume = "--engine=" + tuning::to_string(engine);
+        if (options.shards > 1) resume += " --shard=" + to_string(options.shard + 1) + "/" + to_string(options.shards);
+
+        cerr << "stage 2 stopped, " << stop_reason << ": " << stage2_results.size() << " candidate keys so far" << endl;
+        for (size_t fault_position : fault_positions) {
+            auto const& units = covered[fault_position];
+            string ranges = format_units(units);
+
+            cerr << "fault position " << fault_position << ": covered " << unit_name << (ranges != "" ? ranges : "none");
+            if (!units.empty()) cerr << " of " << (join ? 1 : 0) << "-" << units.size() - 1;
+            cerr << endl;
+
+            if (ranges != "") resume += " --covered=" + to_string(fault_position) + ":" + ranges;
+        }
+        cerr << "the rest of the search: " << resume << endl;
+    }
+
+    // partial results are no results of the capture
+    if (stop_reason == "" && options.covered.empty() && options.shards == 1 && cacheable) cache_results(fingerprint, stage2_results, options);
+
+    return initial_keys(Y, stage2_results, plaintext, options);
+}
+
+void crack(string const& regular_ciphertext, string const& faulted_ciphertext, size_t fault_position, string const& plaintext, Options const& options) {
+    FlatState Y, Y_, X;
+    
+    {
+        profiling::Scope scope(options.profiler, "io");
+        Y = string_to_state(regular_ciphertext);
+        Y_ = string_to_state(faulted_ciphertext);
+        if (plaintext != "") X = string_to_state(plaintext);
+    }
+
+    auto found_keys = attack(Y, Y_, {fault_position}, (plaintext != "") ? &X : nullptr, options);
+    
+    profiling::Scope scope(options.profiler, "io");
+    for (auto key : found_keys)
+            cout << key << endl;
+}
+
+/**
+ * @brief A capture submitted to a `scheduler::Scheduler`, or answered by the result cache.
+ */
+struct Pending {
+    size_t record;
+    FlatState regular;
+    optional<FlatState> plaintext;
+    string fingerprint;
+    vector<FlatState> stage2_results;   // from the cache, when there's no `attack`
+    optional<scheduler::Attack> attack;
+};
+
+/**
+ * @brief Triage `capture`, record `record` of its stream: answered by the result cache if it holds the capture,
+ * else submitted to `pool`.
+ * 
+ * Records with a known fault position get a larger share of the workers than those only knowing the differential
+ * column, which take 4 times longer.
+ * 
+ * @return false if the fault of `capture` is invalid
+ */
+bool submit(size_t record, capture_file::Record const& capture, scheduler::Scheduler& pool, Options const& options, Pending& pending) {
+    // the third stage is left to `complete`, the pool returning every round 10 key candidate
+    async_attack::Request request;
+    request.regular = capture.regular;
+    request.faulted = capture.faulted;
+    request.fault_positions = get_fault_positions(capture.fault, capture.column_only());
+    request.hints = options.hints;
+    request.model = options.fault_model;
+    request.settings = options.settings;
+    request.last_round_keys = true;
+
+    if (request.fault_positions.empty()) return false;
+
+    pending = Pending {record, capture.regular, nullopt, "", {}, nullopt};
+    if (capture.has_plaintext()) pending.plaintext = capture.plaintext;
+
+    if (options.cache != nullptr) {
+        pending.fingerprint = result_cache::fingerprint(request.regular, request.faulted, request.fault_positions, request.hints, request.model);
+        if (options.cache->lookup(pending.fingerprint, pending.stage2_results)) return true;
+    }
+
+    auto priority = capture.column_only() ? async_attack::Priority::LOW : async_attack::Priority::NORMAL;
+    pending.attack.emplace(pool.submit(move(request), priority));
+
+    return true;
+}
+
+/**
+ * @brief Candidate initial keys of the `pending` capture, waiting for its attack if need be.
+ */
+vector<FlatState> complete(Pending& pending, Options const& options) {
+    if (pending.attack) {
+        pending.stage2_results = pending.attack->get().keys;
+        cache_results(pending.fingerprint, pending.stage2_results, options);
+        pending.attack.reset();
+    }
+
+    return initial_keys(pending.regular, pending.stage2_results, pending.plaintext ? &*pending.plaintext : nullptr, options);
+}
+
+/**
+ * @brief Run the attack on every record of `captures` at once, on a `scheduler::Scheduler` of `options.workers` workers.
+ * 
+ * Records held by the result cache skip the pool. Keys are printed as by `crack_captures`, in record order.
+ * 
+ * @return int exit status
+ */
+int crack_captures_concurrently(string const& path, capture_file::Reader const& captures, Options const& options) {
+    scheduler::Scheduler pool(options.workers);
+    vector<Pending> pending;
+
+    for (size_t i = 0; i < captures.size(); ++i) {
+        Pending record;
+        if (!submit(i, captures[i], pool, options, record)) {
+            cerr << path << ": record " << i << ": invalid fault " << int(captures[i].fault) << endl;
+            continue;
+        }
+
+        pending.push_back(move(record));
+    }
+
+    for (auto& record : pending)
+        for (auto key : complete(record, options))
+            cout << record.record << " " << key << endl;
+
+    return 0;
+}
+
+/**
+ * @brief Run the attack on every record of the capture file at `path`.
+ * 
+ * Each found key is printed on its own line, preceded by the index of its record.
+ * 
+ * @return int exit status
+ */
+int crack_captures(string const& path, Options const& options) {
+    capture_file::Reader captures;
+    
+    {
+        profiling::Scope scope(options.profiler, "io");
+        if (!captures.open(path)) {
+            cerr << captures.error() << endl;
+            return 1;
+        }
+    }
+
+    if (options.workers > 0) return crack_captures_concurrently(path, captures, options);
+
+    for (size_t i = 0; i < captures.size(); ++i) {
+        auto const& capture = captures[i];
+
+        auto fault_positions = get_fault_positions(capture.fault, capture.column_only());
+
+        if (fault_positions.empty()) {
+            cerr << path << ": record " << i << ": invalid fault " << int(capture.fault) << endl;
+            continue;
+        }
+
+        auto found_keys = attack(capture.regular, capture.faulted, fault_positions, capture.has_plaintext() ? &capture.plaintext : nullptr, options);
+
+        profiling::Scope scope(options.profiler, "io");
+        for (auto key : found_keys)
+            cout << i << " " << key << endl;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Attack the captures streamed by the injection rig controller through the shared memory rings `name`, as they
+ * come, on a `scheduler::Scheduler` of `options.workers` workers (one per physical core by default).
+ * 
+ * Captures are triaged straight from their ring slot: those with an invalid fault are answered at once, those held by
+ * the result cache too, and the others go to the pool. Each capture gets its candidate initial keys then a `DONE`
+ * result, in the order the attacks complete. Returns once the controller closed the capture ring and every attack
+ * is done.
+ * 
+ * @return int exit status
+ */
+int ingest(string const& name, uint64_t capacity, Options const& options) {
+    using capture_ring::Result;
+
+    capture_ring::Ring<capture_file::Record> captures;
+    capture_ring::Ring<Result> results;
+
+    if (!captures.create(capture_ring::segment_name(name, "captures"), capacity)) {
+        cerr << captures.error() << endl;
+        return 1;
+    }
+    if (!results.create(capture_ring::segment_name(name, "results"), capacity)) {
+        cerr << results.error() << endl;
+        return 1;
+    }
+
+    scheduler::Scheduler pool(options.workers > 0 ? options.workers : tuning::physical_cores());
+    vector<Pending> pending;
+    capture_ring::Backoff backoff;
+
+    auto publish = [&](uint64_t sequence, FlatState const& key, Result::Status status, size_t count) {
+        Result* slot;
+        // the controller is behind on the results
+        while ((slot = results.claim()) == nullptr) backoff.wait();
+        backoff.reset();
+
+        *slot = Result {sequence, key, status, (uint32_t) count, {}};
+        results.publish();
+    };
+
+    while (true) {
+        bool busy = false;
+
+        // triage every capture available, in place
+        while (auto const* capture = captures.front()) {
+            Pending record;
+            if (submit(captures.position(), *capture, pool, options, record))
+                pending.push_back(move(record));
+            else
+                publish(captures.position(), {}, Result::INVALID, 0);
+
+            captures.release();
+            busy = true;
+        }
+
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (it->attack && !it->attack->ready()) {
+                ++it;
+                continue;
+            }
+
+            auto keys = complete(*it, options);
+            for (auto const& key : keys) publish(it->record, key, Result::KEY, 0);
+            publish(it->record, {}, Result::DONE, keys.size());
+            cerr << "capture " << it->record << ": " << keys.size() << " candidate keys" << endl;
+
+            it = pending.erase(it);
+            busy = true;
+        }
+
+        if (pending.empty() && captures.drained()) break;
+
+        if (busy) backoff.reset();
+        else backoff.wait();
+    }
+
+    results.close();
+
+    return 0;
+}
+
+/**
+ * @brief Stand-in for the injection rig controller: stream the records of the capture file at `path` to the `ingest`
+ * running on the shared memory rings `name`, and print the keys it finds as `batch` does.
+ * 
+ * @return int exit status
+ */
+int replay(string const& name, string const& path) {
+    using capture_ring::Result;
+
+    capture_file::Reader input;
+    if (!input.open(path)) {
+        cerr << input.error() << endl;
+        return 1;
+    }
+
+    capture_ring::Ring<capture_file::Record> captures;
+    capture_ring::Ring<Result> results;
+
+    // `ingest` creates the rings, give it a few seconds to start
+    auto attach = [](auto& ring, string const& segment) {
+        for (int attempt = 0; !ring.attach(segment); ++attempt) {
+            if (attempt == 50) {
+                cerr << ring.error() << endl;
+                return false;
+            }
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+
+        return true;
+    };
+
+    if (!attach(captures, capture_ring::segment_name(name, "captures")) || !attach(results, capture_ring::segment_name(name, "results"))) return 1;
+
+    size_t next = 0, done = 0;
+    capture_ring::Backoff backoff;
+
+    while (done < input.size()) {
+        bool busy = false;
+
+        for (capture_file::Record* slot; next < input.size() && (slot = captures.claim()) != nullptr; ++next) {
+            *slot = input[next];
+            captures.publish();
+            busy = true;
+        }
+        if (next == input.size()) captures.close();
+
+        while (auto const* result = results.front()) {
+            if (result->status == Result::KEY)
+                cout << result->sequence << " " << result->key << endl;
+            else if (result->status == Result::INVALID)
+                cerr << path << ": record " << result->sequence << ": invalid fault" << endl;
+
+            done += (result->status != Result::KEY);
+            results.release();
+            busy = true;
+        }
+
+        // `ingest` went away
+        if (results.drained()) break;
+
+        if (busy) backoff.reset();
+        else backoff.wait();
+    }
+
+    return (done == input.size()) ? 0 : 1;
+}
+
+/**
+ * @brief Run a key set command on key set files:
+ * 
+ *      pack keys_log set               set of the keys of a text log (`-` for the standard input), the last 32 hex
+ *                                      digits of each line, so that the output of `crack` or `batch` fits
+ *      unpack set                      print the keys of the set
+ *      count set [...]                 print the size of each set
+ *      intersect|union|difference a b set
+ * 
+ * @return int exit status
+ */
+int run_key_set(vector<string> const& args) {
+    string const& command = args[0];
+    string error;
+
+    if (command == "pack") {
+        ifstream file;
+        if (args[1] != "-") {
+            file.open(args[1]);
+            if (!file) {
+                cerr << args[1] << ": cannot open" << endl;
+                return 1;
+            }
+        }
+        istream& log = (args[1] == "-") ? cin : file;
+
+        vector<FlatState> keys;
+        string line;
+        for (size_t number = 1; getline(log, line); ++number) {
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (line.empty() || line[0] == '#') continue;
+
+            FlatState key;
+            if (line.size() < 32 || !key_set::parse(line.data() + line.size() - 32, key)) {
+                cerr << args[1] << ":" << number << ": no key, skipped" << endl;
+                continue;
+            }
+
+            keys.push_back(key);
+        }
+
+        if (!key_set::write(args[2], move(keys), error)) {
+            cerr << error << endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    if (command == "unpack" || command == "count") {
+        for (size_t i = 1; i < args.size(); ++i) {
+            key_set::Reader set;
+            if (!set.open(args[i])) {
+                cerr << set.error() << endl;
+                return 1;
+            }
+
+            if (command == "count") {
+                cout << args[i] << " " << set.size() << endl;
+                continue;
+            }
+
+            for (FlatState key; set.next(key);) cout << key << endl;
+            if (set.error() != "") {
+                cerr << set.error() << endl;
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+    auto operation = (command == "intersect") ? key_set::Operation::INTERSECTION
+                   : (command == "union")     ? key_set::Operation::UNION
+                   :                            key_set::Operation::DIFFERENCE;
+
+    key_set::Reader a, b;
+    key_set::Writer out;
+
+    for (auto* reader : {&a, &b})
+        if (!reader->open(args[reader == &a ? 1 : 2])) {
+            cerr << reader->error() << endl;
+            return 1;
+        }
+
+    if (!out.open(args[3]) || !key_set::merge(a, b, operation, out, error) || !out.close()) {
+        cerr << (error != "" ? error : out.error()) << endl;
+        return 1;
+    }
+
+    cerr << out.size() << " keys" << endl;
+
+    return 0;
+}
+
+/**
+ * @brief Convert a text capture log into a binary capture file.
+ * 
+ * Each line of the log holds `regular_cipher faulted_cipher fault [plaintext]`, separated by commas or blanks,
+ * with `fault` either a fault position or `cN` when only the differential column N is known.
+ * Empty lines and lines starting with `#` are skipped.
+ * 
+ * @return int exit status
+ */
+int convert(string const& input, string const& output) {
+    ifstream log(input);
+    if (!log) {
+        cerr << input << ": cannot open" << endl;
+        return 1;
+    }
+
+    capture_file::Writer captures;
+    if (!captures.open(output)) {
+        cerr << output << ": cannot open" << endl;
+        return 1;
+    }
+
+    string line;
+    size_t line_number = 0;
+
+    while (getline(log, line)) {
+        ++line_number;
+        replace(line.begin(), line.end(), ',', ' ');
+
+        vector<string> fields;
+        istringstream words(line);
+        for (string word; words >> word; ) fields.push_back(word);
+
+        if (fields.empty() || fields[0][0] == '#') continue;
+
+        capture_file::Record record {};
+        bool column_only = (fields.size() >= 3 && fields[2][0] == 'c');
+        unsigned int fault = 16;
+
+        if (fields.size() >= 3) istringstream(fields[2].substr(column_only ? 1 : 0)) >> fault;
+
+        bool valid = (fields.size() == 3 || fields.size() == 4) && fault < (column_only ? 4u : 16u);
+        for (size_t f = 0; f < fields.size() && valid; ++f)
+            if (f != 2) valid = (fields[f].size() == 32);
+
+        if (!valid) {
+            cerr << input << ":" << line_number << ": malformed capture, skipped" << endl;
+            continue;
+        }
+
+        record.regular = string_to_state(fields[0]);
+        record.faulted = string_to_state(fields[1]);
+        record.fault = fault;
+        if (column_only) record.flags |= capture_file::COLUMN_ONLY;
+        if (fields.size() == 4) {
+            record.plaintext = string_to_state(fields[3]);
+            record.flags |= capture_file::HAS_PLAINTEXT;
+        }
+
+        captures.append(record);
+    }
+
+    size_t count = captures.size();
+    if (!captures.close()) {
+        cerr << output << ": write error" << endl;
+        return 1;
+    }
+
+    cerr << count << " captures written to " << output << endl;
+
+    return 0;
+}
+
+/**
+ * @brief Run a session command (`add`, `pair` or `show`) on the session file at `path`.
+ * 
+ * @return int exit status
+ */
+int run_session(string const& path, vector<string> const& args, Options const& options) {
+    session::Session current;
+    string error;
+
+    if (!session::load(path, current, error)) {
+        cerr << error << endl;
+        return 1;
+    }
+
+    string const& command = args[0];
+
+    if (command == "add") {
+        bool column_only = (args[3][0] == 'c');
+        size_t fault = 16;
+        istringstream(args[3].substr(column_only ? 1 : 0)) >> fault;
+
+        auto fault_positions = get_fault_positions(fault, column_only);
+        if (fault_positions.empty()) {
+            cerr << "invalid fault " << args[3] << endl;
+            return 1;
+        }
+
+        session::add_capture(current, string_to_state(args[1]), string_to_state(args[2]), fault_positions, options.hints, options.settings, options.fault_model);
+    } else if (command == "pair") {
+        if (!session::add_pair(current, string_to_state(args[1]), string_to_state(args[2]))) {
+            cerr << "the session needs a fault capture before any plaintext / ciphertext pair" << endl;
+            return 1;
+        }
+    }
+
+    if (command != "show" && !session::save(path, current, error)) {
+        cerr << error << endl;
+        return 1;
+    }
+
+    cerr << current.captures << " captures, " << current.pairs << " pairs: ";
+    if (current.initialized)
+        cerr << current.last_round_keys.size() << " candidate keys left" << endl;
+    else
+        cerr << "no candidate set yet" << endl;
+
+    if (command == "show" || current.last_round_keys.size() == 1)
+        for (auto const& K10 : current.last_round_keys)
+            cout << get_initial_key(K10, options.settings.inversion) << endl;
+
+    return 0;
+}
+
+/**
+ * @brief Recover an AES-256 key from `args`: captures `regular faulted position`, all at the round 12 entry but the last,
+ * at the round 11 entry, optionally followed by the plaintext of the last regular ciphertext.
+ * 
+ * @return int exit status
+ */
+int crack_aes256(vector<string> const& args, Options const& options) {
+    vector<aes256::Capture> captures;
+    FlatState plaintext;
+    bool has_plaintext = (args.size() % 3 == 1);
+
+    {
+        profiling::Scope scope(options.profiler, "io");
+        for (size_t i = 0; i + 2 < args.size(); i += 3) {
+            aes256::Capture capture {string_to_state(args[i]), string_to_state(args[i + 1]), 16};
+            istringstream(args[i + 2]) >> capture.fault_position;
+
+            if (capture.fault_position >= 16) {
+                cerr << "invalid fault position " << args[i + 2] << endl;
+                return 1;
+            }
+
+            captures.push_back(capture);
+        }
+
+        if (has_plaintext) plaintext = string_to_state(args.back());
+    }
+
+    auto round11 = captures.back();
+    captures.pop_back();
+
+    // `--k0` candidates are AES-128 keys, the byte hints apply to the round 14 key
+    KeyHints hints;
+    hints.allowed_bytes = options.hints.allowed_bytes;
+
+    vector<FlatState> last_keys;
+    string error;
+    {
+        profiling::Scope scope(options.profiler, "stage1");
+        if (!aes256::last_round_keys(captures, hints, last_keys, error)) {
+            cerr << error << endl;
+            return 1;
+        }
+    }
+
+    vector<pair<FlatState, FlatState>> round_keys;
+    {
+        profiling::Scope scope(options.profiler, "stage2");
+        for (auto const& K14 : last_keys)
+            for (auto const& K13 : aes256::penultimate_round_keys(round11, K14, options.settings))
+                round_keys.emplace_back(K13, K14);
+    }
+
+    vector<aes256::Key> found_keys;
+    {
+        profiling::Scope scope(options.profiler, "stage3");
+        for (auto const& [K13, K14] : round_keys)
+            if (!has_plaintext || aes256::decrypt(round11.regular, K13, K14) == plaintext)
+                found_keys.push_back(aes256::get_initial_key(K13, K14));
+    }
+
+    profiling::Scope scope(options.profiler, "io");
+    for (auto const& key : found_keys)
+        cout << key << endl;
+
+    return 0;
+}
+
+/**
+ * @brief Benchmark the second stage configurations and store the fastest as this host's tuning profile.
+ */
+int tune() {
+    auto settings = tuning::tune(cerr);
+
+    string path = tuning::profile_path(), error;
+    if (!tuning::save(path, settings, error)) {
+        cerr << error << endl;
+        return 1;
+    }
+
+    cout << "engine=" << tuning::to_string(settings.engine) << " kernel=" << tuning::to_string(settings.kernel)
+         << " threads=" << settings.threads << " chunk=" << settings.chunk << endl;
+    cerr << "saved to " << path << endl;
+
+    return 0;
+}
+
+/**
+ * @brief Prints the nonempty buckets of `histogram` under `name`.
+ */
+template<typename Histogram>
+void print_histogram(string const& name, Histogram const& histogram) {
+    cout << endl << name << endl;
+    for (size_t b = 0; b < histogram.buckets.size(); ++b) {
+        if (histogram.buckets[b] == 0) continue;
+
+        cout << setw(24) << Histogram::label(b) << setw(8) << histogram.buckets[b] << endl;
+    }
+}
+
+/**
+ * @brief Run `simulations` simulated attacks with faults at `positions` (all 16 if empty), using every core.
+ * 
+ * Prints, for each fault position, the number of simulations, the mean log2 of the second stage search space, the
+ * mean, min and max second stage survivors and the mean and max wall time, then, for each fault position and all of
+ * them, the histograms of the survivors, of the wall times and of the first stage candidate rows per antidiagonal.
+ * 
+ * @return int exit status
+ */
+int run_campaign(size_t simulations, vector<size_t> const& positions, uint64_t seed, Options const& options) {
+    campaign::Settings settings;
+    settings.simulations = simulations;
+    settings.seed = seed;
+    settings.fault_positions = positions;
+    settings.model = options.fault_model;
+    settings.stage2 = options.settings;
+
+    vector<campaign::Simulation> results;
+    {
+        profiling::Scope scope(options.profiler, "campaign");
+        results = campaign::run(settings);
+    }
+
+    auto summaries = campaign::summarize(results);
+
+    cout << setw(8) << "position" << setw(8) << "runs" << setw(12) << "log2 space" << setw(12) << "survivors"
+         << setw(8) << "min" << setw(8) << "max" << setw(12) << "time (ms)" << setw(12) << "max" << endl;
+    for (size_t position = 0; position <= 16; ++position) {
+        auto const& summary = summaries[position];
+        if (summary.simulations == 0) continue;
+
+        cout << setw(8) << (position < 16 ? to_string(position) : "all") << setw(8) << summary.simulations << fixed << setprecision(2)
+             << setw(12) << summary.mean_stage1_space() << setw(12) << summary.survivors.mean()
+             << setprecision(0) << setw(8) << summary.survivors.min << setw(8) << summary.survivors.max
+             << setprecision(1) << setw(12) << summary.milliseconds.mean() << setw(12) << summary.milliseconds.max << defaultfloat << setprecision(6) << endl;
+    }
+
+    for (size_t position = 0; position <= 16; ++position) {
+        auto const& summary = summaries[position];
+        if (summary.simulations == 0) continue;
+
+        string name = "position " + (position < 16 ? to_string(position) : string("all")) + ": ";
+        print_histogram(name + "survivors", summary.survivors);
+        print_histogram(name + "time (ms)", summary.milliseconds);
+        print_histogram(name + "stage 1 rows per antidiagonal", summary.stage1_sizes);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Rank the round 10 key byte hypotheses on the faulted ciphertexts of the raw ciphertext file at `path`.
+ * 
+ * Prints, for each key byte, its index, best hypothesis, runner-up, score of the best and margin over the runner-up.
+ * 
+ * @return int exit status
+ */
+int statistical_analysis(string const& path, statistical::Metric metric, Options const& options) {
+    statistical::Ciphertexts ciphertexts;
+    statistical::Histograms histograms;
+
+    {
+        profiling::Scope scope(options.profiler, "io");
+        if (!ciphertexts.open(path)) {
+            cerr << ciphertexts.error() << endl;
+            return 1;
+        }
+    }
+
+    {
+        profiling::Scope scope(options.profiler, "histograms");
+        histograms = statistical::histograms(ciphertexts.data(), ciphertexts.size(), options.settings.threads);
+    }
+
+    auto rankings = statistical::rank(histograms, metric);
+
+    cerr << ciphertexts.size() << " ciphertexts" << endl;
+    for (size_t j = 0; j < 16; ++j)
+        cout << setw(2) << j << " " << setfill('0') << hex << setw(2) << int(rankings[j].best) << " " << setw(2) << int(rankings[j].second)
+             << setfill(' ') << dec << " " << rankings[j].score << " " << fixed << setprecision(2) << rankings[j].margin << defaultfloat << endl;
+
+    return 0;
+}
+
+/**
+ * @brief Writes the timeline of the run to `path` on its way out, whatever the command, if tracing.
+ */
+struct TraceWriter {
+    string path;    // empty when tracing is disabled
+
+    ~TraceWriter() {
+        if (path == "") return;
+
+        ofstream file(path);
+        uint64_t lost = tracing::write_chrome_trace(file);
+
+        if (!file) cerr << path << ": write error" << endl;
+        else if (lost != 0) cerr << lost << " trace spans lost to full buffers, the earliest ones" << endl;
+    }
+};
+
+void print_usage() {
+    cout << "Usage: aes-single-fault-attack regular_cipher faulted_cipher fault_position[+position...] [plaintext] [options]" << endl;
+    cout << "       aes-single-fault-attack batch captures_file [options]" << endl;
+    cout << "       aes-single-fault-attack convert capture_log captures_file" << endl;
+    cout << "       aes-single-fault-attack ingest ring_name [options]" << endl;
+    cout << "       aes-single-fault-attack replay ring_name captures_file" << endl;
+    cout << "       aes-single-fault-attack keyset pack keys_log set | unpack set | count set [...]" << endl;
+    cout << "       aes-single-fault-attack keyset intersect|union|difference set_a set_b set" << endl;
+    cout << "       aes-single-fault-attack session session_file add regular_cipher faulted_cipher fault [options]" << endl;
+    cout << "       aes-single-fault-attack session session_file pair plaintext ciphertext" << endl;
+    cout << "       aes-single-fault-attack session session_file show" << endl;
+    cout << "       aes-single-fault-attack tune" << endl;
+    cout << "       aes-single-fault-attack campaign simulations [fault_position,...] [--seed=N] [options]" << endl;
+    cout << "       aes-single-fault-attack aes256 regular faulted round12_position [...] regular faulted round11_position [plaintext] [options]" << endl;
+    cout << "       aes-single-fault-attack sfa ciphertexts_file [--metric=sei|low|high]" << endl;
+    cout << endl;
+    cout << "Options:" << endl;
+    cout << "  --profile[=table|json]   report per stage timings and hardware counters on stderr" << endl;
+    cout << "  --trace=PATH             write a per thread timeline of the run to PATH (Chrome trace format)" << endl;
+    cout << "  --k10-byte=INDEX:VALUES  known values of a round 10 (aes256: 14) key byte, e.g. 3:1f or 3:10-1f,a0 (repeatable)" << endl;
+    cout << "  --k0=KEY                 candidate cipher key (repeatable)" << endl;
+    cout << "  --fault=MODEL            any (default), bit-flip, stuck-at:HH or xor:HH (known fault difference)" << endl;
+    cout << "  --fault-at=WHERE         entry (default): round 8 entry state, sbox-output: round 8 MixColumns input" << endl;
+    cout << "  --engine=ENGINE          second stage search: sweep (exhaustive), join (fault equations) or range (sweep by key blocks)," << endl;
+    cout << "                           multi-byte faults always being swept by key blocks (default: tuned)" << endl;
+    cout << "  --ciphertext=CIPHER      another ciphertext of the key, decrypted by the candidates for --oracle (repeatable)" << endl;
+    cout << "  --oracle=STRUCTURE       without plaintext, keep the keys whose decryptions are printable, start with magic:HEX," << endl;
+    cout << "                           end with zeros:N zero bytes or have at most entropy:BITS, best first (repeatable)" << endl;
+    cout << "  --no-cache               don't look up nor store second stage results in the result cache" << endl;
+    cout << "  --cache-dir=PATH         result cache directory (default: $XDG_CACHE_HOME/aes-single-fault-attack/results)" << endl;
+    cout << "  --cache-size=MIB         result cache size limit, least recently used results evicted first (default: 64)" << endl;
+    cout << "  --deadline=SECONDS       stop the second stage after SECONDS, reporting the keys found and the part searched" << endl;
+    cout << "  --budget=N               stop the second stage once N candidate keys are found, likewise" << endl;
+    cout << "  --shard=I/N              search the I-th of N contiguous parts of the second stage units, for N runs sharing a capture" << endl;
+    cout << "  --covered=POS:UNITS      skip the second stage units of fault position POS reported searched by a run stopped early" << endl;
+    cout << "  --workers=N              batch: attack all the records at once, sharing N pinned worker threads (ingest: the pool size)" << endl;
+    cout << "  --ring-size=N            ingest: records per shared memory ring, a power of 2 (default: 1024)" << endl;
+    cout << "  --seed=N                 campaign: seed of the simulated keys, plaintexts and faults (default: 1)" << endl;
+    cout << "  --metric=sei|low|high    sfa: score on the Hamming weights, any bias (default), bits cleared or bits set" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string regular_ciphertext, faulted_ciphertext, plaintext;
+    size_t fault_position;
+    string profile_format; // empty when profiling is disabled
+    string trace_path; // empty when tracing is disabled
+    Options options;
+    string engine; // empty to keep the tuned engine
+    statistical::Metric metric = statistical::Metric::SEI;
+    bool use_cache = true;
+    string cache_directory = result_cache::default_directory();
+    uint64_t cache_size = result_cache::DEFAULT_MAX_SIZE >> 20;    // MiB
+    uint64_t ring_size = capture_ring::DEFAULT_CAPACITY;
+    uint64_t seed = 1;
+    bool valid_options = true;
+    vector<string> args;
+
+    // settings picked by `tune` for this host, if any
+    string tuning_error;
+    tuning::load(tuning::profile_path(), options.settings, tuning_error);
+    if (tuning_error != "") cerr << "ignoring tuning profile " << tuning_error << endl;
+
+    auto option_value = [](string const& arg, string const& option) {
+        return arg.substr(option.size() + 1);
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+
+        if (arg == "--profile")
+            profile_format = "table";
+        else if (arg.rfind("--profile=", 0) == 0)
+            profile_format = option_value(arg, "--profile");
+        else if (arg.rfind("--trace=", 0) == 0)
+            valid_options &= (trace_path = option_value(arg, "--trace")) != "";
+        else if (arg.rfind("--k10-byte=", 0) == 0)
+            valid_options &= parse_key_byte_hint(option_value(arg, "--k10-byte"), options.hints);
+        else if (arg.rfind("--k0=", 0) == 0 && arg.size() == string("--k0=").size() + 32)
+            options.hints.last_round_keys.push_back(get_last_round_key(string_to_state(option_value(arg, "--k0"))));
+        else if (arg.rfind("--fault=", 0) == 0)
+            valid_options &= parse_fault_model(option_value(arg, "--fault"), options.fault_model);
+        else if (arg == "--fault-at=entry" || arg == "--fault-at=sbox-output")
+            options.fault_model.at_sbox_output = (arg == "--fault-at=sbox-output");
+        else if (arg.rfind("--engine=", 0) == 0)
+            engine = option_value(arg, "--engine");
+        else if (arg == "--metric=sei")
+            metric = statistical::Metric::SEI;
+        else if (arg == "--metric=low")
+            metric = statistical::Metric::LOW_WEIGHT;
+        else if (arg == "--metric=high")
+            metric = statistical::Metric::HIGH_WEIGHT;
+        else if (arg.rfind("--ciphertext=", 0) == 0 && arg.size() == string("--ciphertext=").size() + 32)
+            options.ciphertexts.push_back(string_to_state(option_value(arg, "--ciphertext")));
+        else if (arg.rfind("--oracle=", 0) == 0)
+            valid_options &= parse_plaintext_structure(option_value(arg, "--oracle"), options.structures);
+        else if (arg == "--no-cache")
+            use_cache = false;
+        else if (arg.rfind("--cache-dir=", 0) == 0)
+            cache_directory = option_value(arg, "--cache-dir");
+        else if (arg.rfind("--cache-size=", 0) == 0)
+            valid_options &= (istringstream(option_value(arg, "--cache-size")) >> cache_size) && cache_size > 0;
+        else if (arg.rfind("--ring-size=", 0) == 0)
+            valid_options &= bool(istringstream(option_value(arg, "--ring-size")) >> ring_size);
+        else if (arg.rfind("--seed=", 0) == 0)
+            valid_options &= bool(istringstream(option_value(arg, "--seed")) >> seed);
+        else if (arg.rfind("--deadline=", 0) == 0) {
+            double seconds = -1;
+            valid_options &= (istringstream(option_value(arg, "--deadline")) >> seconds) && seconds >= 0;
+            options.deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(max(seconds, 0.0)));
+        }
+        else if (arg.rfind("--budget=", 0) == 0)
+            valid_options &= (istringstream(option_value(arg, "--budget")) >> options.max_keys) && options.max_keys > 0;
+        else if (arg.rfind("--covered=", 0) == 0)
+            valid_options &= parse_covered_units(option_value(arg, "--covered"), options.covered);
+        else if (arg.rfind("--shard=", 0) == 0)
+            valid_options &= parse_shard(option_value(arg, "--shard"), options.shard, options.shards);
+        else if (arg.rfind("--workers=", 0) == 0)
+            valid_options &= (istringstream(option_value(arg, "--workers")) >> options.workers) && options.workers > 0;
+        else if (arg.rfind("--", 0) == 0)
+            valid_options = false;
+        else
+            args.push_back(arg);
+    }
+
+    if (profile_format != "" && profile_format != "table" && profile_format != "json") valid_options = false;
+    if (options.structures.empty() != options.ciphertexts.empty()) valid_options = false;
+    if (engine != "" && !tuning::parse(engine, options.settings.engine)) valid_options = false;
+
+    string command = args.empty() ? "" : args[0];
+    bool valid_args = (command == "convert") ? (args.size() == 3)
+                    : (command == "batch")   ? (args.size() == 2)
+                    : (command == "tune")    ? (args.size() == 1)
+                    : (command == "campaign") ? (args.size() == 2 || args.size() == 3)
+                    : (command == "ingest")  ? (args.size() == 2)
+                    : (command == "replay")  ? (args.size() == 3)
+                    : (command == "keyset")  ? (args.size() >= 3 && (((args[1] == "pack") && args.size() == 4) || (args[1] == "unpack" && args.size() == 3) || args[1] == "count"
+                                                                     || ((args[1] == "intersect" || args[1] == "union" || args[1] == "difference") && args.size() == 5)))
+                    : (command == "sfa")     ? (args.size() == 2)
+                    : (command == "aes256")  ? (args.size() >= 7 && args.size() % 3 != 0)
+                    : (command == "session") ? (args.size() >= 3 && ((args[2] == "add" && args.size() == 6) || (args[2] == "pair" && args.size() == 5) || (args[2] == "show" && args.size() == 3)))
+                    : (args.size() == 3 || args.size() == 4);
+
+    // campaign simulations and fault positions
+    size_t simulations = 0;
+    vector<size_t> positions;
+    if (command == "campaign" && valid_args)
+        valid_args = (istringstream(args[1]) >> simulations) && simulations > 0 && (args.size() == 2 || parse_fault_positions(args[2], positions));
+
+    if (!valid_args || !valid_options) {
+        print_usage();
+        return 1;
+    }
+
+    // the timeline is written when `main` returns
+    TraceWriter trace {trace_path};
+    if (trace_path != "") tracing::enable();
+
+    if (command == "convert") return convert(args[1], args[2]);
+    if (command == "tune") return tune();
+    if (command == "replay") return replay(args[1], args[2]);
+    if (command == "keyset") return run_key_set(vector<string>(args.begin() + 1, args.end()));
+    if (command == "session") return run_session(args[1], vector<string>(args.begin() + 2, args.end()), options);
+
+    // second stage results of earlier runs
+    unique_ptr<result_cache::Cache> cache;
+    if (use_cache) {
+        cache = make_unique<result_cache::Cache>(cache_directory, cache_size << 20);
+        options.cache = cache.get();
+    }
+
+    unique_ptr<profiling::Profiler> profiler;
+    if (profile_format != "") {
+        profiler = make_unique<profiling::Profiler>();
+        profiler->attach_worker_threads(options.settings.threads);
+        options.profiler = profiler.get();
+    }
+
+    int status = 0;
+
+    if (command == "batch") {
+        status = crack_captures(args[1], options);
+    } else if (command == "campaign") {
+        status = run_campaign(simulations, positions, seed, options);
+    } else if (command == "ingest") {
+        status = ingest(args[1], ring_size, options);
+    } else if (command == "aes256") {
+        status = crack_aes256(vector<string>(args.begin() + 1, args.end()), options);
+    } else if (command == "sfa") {
+        status = statistical_analysis(args[1], metric, options);
+    } else {
+        istringstream(args[0]) >> regular_ciphertext;
+        istringstream(args[1]) >> faulted_ciphertext;
+        if (args.size() == 4) istringstream(args[3]) >> plaintext;
+
+        if (!parse_fault(args[2], fault_position, options.fault_bytes)) {
+            cerr << "invalid fault " << args[2] << ": a position, or positions landing in one column of the round 8 MixColumns input" << endl;
+            return 1;
+        }
+
+        if (options.fault_bytes != 0 && !options.fault_model.is_arbitrary()) {
+            cerr << "multi-byte faults only fit --fault=any" << endl;
+            return 1;
+        }
+
+        // TODO: add checks to sanitize and validate input
+        crack(regular_ciphertext, faulted_ciphertext, fault_position, plaintext, options);
+    }
+
+    if (profile_format == "table") profiling::print_table(cerr, *profiler);
+    if (profile_format == "json") profiling::print_json(cerr, *profiler);
+
+    return status;
+};
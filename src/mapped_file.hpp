@@ -0,0 +1,83 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+/**
+ * @brief Read-only memory mapping of a whole file, read sequentially.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    ~MappedFile() {
+        unmap();
+    }
+
+    /**
+     * @brief Map the file at `path`, in place of the file mapped so far if any.
+     *
+     * @return false on failure, `error()` telling why
+     */
+    bool open(string const& path) {
+        unmap();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return fail(path + ": " + strerror(errno));
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return fail(path + ": " + strerror(errno));
+        }
+
+        // mmap rejects empty mappings
+        if (st.st_size == 0) {
+            close(fd);
+            return true;
+        }
+
+        void* address = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (address == MAP_FAILED) return fail(path + ": " + strerror(errno));
+
+        mapping = address;
+        mapping_size = st.st_size;
+        madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+
+        return true;
+    }
+
+    size_t size() const { return mapping_size; }
+    char const* data() const { return (char const*) mapping; }
+
+    string const& error() const { return last_error; }
+
+private:
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    string last_error;
+
+    void unmap() {
+        if (mapping != nullptr) munmap(mapping, mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+        last_error = "";
+    }
+
+    bool fail(string const& message) {
+        last_error = message;
+        return false;
+    }
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "reductions.hpp"
+
+using namespace std;
+
+/**
+ * Plaintext structure oracle, picking the key among the second stage candidates when no plaintext is known.
+ *
+ * Every candidate decrypts a few more ciphertexts of the same key, and the plaintexts are checked against what is
+ * known of their structure: printable text, a header magic, zero padding, or a low byte entropy. A wrong key
+ * decrypts to uniform bytes, which fit none of them: 16 printable bytes out of 16 already happen with probability
+ * (95/256)^16 ~ 2^-23, so one or two blocks usually leave the right key alone out of the ~256 candidates.
+ */
+namespace oracle {
+    /**
+     * @brief What is known of the plaintexts of the extra ciphertexts:
+     *
+     *      PRINTABLE     printable ASCII text (and tabs and line breaks), 90% of the bytes at least, but zero padding
+     *      MAGIC         the first plaintext starts with `magic`
+     *      ZERO_PADDING  the last plaintext ends with `padding` zero bytes
+     *      ENTROPY       the entropy of the plaintext bytes is at most `max_entropy` bits
+     */
+    struct Structure {
+        enum class Kind { PRINTABLE, MAGIC, ZERO_PADDING, ENTROPY };
+
+        Kind kind = Kind::PRINTABLE;
+        vector<u8> magic;
+        size_t padding = 0;
+        double max_entropy = 0;
+    };
+
+    constexpr double MIN_PRINTABLE = 0.9;
+
+    /**
+     * @brief Decryption of the `count` blocks at `in` into `out` under the round keys `keys`, 4 blocks interleaved.
+     */
+    inline void decrypt(FlatState const* in, FlatState* out, size_t count, __m128i const keys[11]) {
+        __m128i kimc[11];
+        for (int r = 0; r < 11; ++r) kimc[r] = (r == 0 || r == 10) ? keys[r] : _mm_aesimc_si128(keys[r]);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i m[4];
+            for (int b = 0; b < 4; ++b) m[b] = _mm_xor_si128(load(in[i + b]), kimc[10]);
+            for (int r = 9; r != 0; --r)
+                for (int b = 0; b < 4; ++b) m[b] = _mm_aesdec_si128(m[b], kimc[r]);
+            for (int b = 0; b < 4; ++b) out[i + b] = unload(_mm_aesdeclast_si128(m[b], kimc[0]));
+        }
+
+        for (; i < count; ++i) {
+            __m128i m = _mm_xor_si128(load(in[i]), kimc[10]);
+            for (int r = 9; r != 0; --r) m = _mm_aesdec_si128(m, kimc[r]);
+            out[i] = unload(_mm_aesdeclast_si128(m, kimc[0]));
+        }
+    }
+
+    inline bool is_printable(u8 c) {
+        return (c >= 0x20 && c < 0x7f) || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    /**
+     * @brief Score of the `plaintexts` on `structure`, the higher the better, and whether they fit it.
+     *
+     * Scores are fractions of the matching bytes, and for `ENTROPY` the number of bits below 8.
+     */
+    inline pair<double, bool> score(vector<FlatState> const& plaintexts, Structure const& structure) {
+        using Kind = Structure::Kind;
+
+        if (plaintexts.empty()) return {0, false};
+
+        switch (structure.kind) {
+            case Kind::PRINTABLE: {
+                size_t printable = 0, length = 16 * plaintexts.size();
+                for (auto const& P : plaintexts)
+                    for (u8 c : P) printable += is_printable(c);
+
+                // the zero padding of the last block is no text
+                for (size_t i = 16; i-- > 0 && plaintexts.back()[i] == 0;) --length;
+
+                double fraction = (length == 0) ? 0.0 : (double) printable / length;
+                return {fraction, fraction >= MIN_PRINTABLE};
+            }
+            case Kind::MAGIC: {
+                size_t length = min(structure.magic.size(), (size_t) 16), matching = 0;
+                for (size_t i = 0; i < length; ++i) matching += (plaintexts.front()[i] == structure.magic[i]);
+
+                return {(length == 0) ? 1.0 : (double) matching / length, matching == length};
+            }
+            case Kind::ZERO_PADDING: {
+                size_t length = min(structure.padding, (size_t) 16), zeros = 0;
+                for (size_t i = 16 - length; i < 16; ++i) zeros += (plaintexts.back()[i] == 0);
+
+                return {(length == 0) ? 1.0 : (double) zeros / length, zeros == length};
+            }
+            case Kind::ENTROPY: {
+                array<size_t, 256> counts {};
+                for (auto const& P : plaintexts)
+                    for (u8 c : P) ++counts[c];
+
+                double total = 16.0 * plaintexts.size(), entropy = 0;
+                for (size_t n : counts)
+                    if (n != 0) entropy -= n / total * log2(n / total);
+
+                return {8 - entropy, entropy <= structure.max_entropy};
+            }
+        }
+
+        return {0, false};
+    }
+
+    struct Candidate {
+        FlatState K10;
+        double score;       // sum of the scores on every structure
+    };
+
+    /**
+     * @brief Candidates of `last_round_keys` whose decryptions of `ciphertexts` fit every structure of `structures`,
+     * best score first.
+     * 
+     * @param method key inversion of the key schedules, derived 4 candidates at a time
+     */
+    inline vector<Candidate> rank(vector<FlatState> const& last_round_keys, vector<FlatState> const& ciphertexts, vector<Structure> const& structures, int threads = THREADS,
+                                  KeyInversion method = KeyInversion::AESKEYGENASSIST) {
+        vector<Candidate> shortlist;
+
+        #pragma omp parallel num_threads(threads)
+        {
+            vector<FlatState> plaintexts(ciphertexts.size());
+
+            #pragma omp for schedule(static)
+            for (size_t first = 0; first < last_round_keys.size(); first += 4) {
+                // the last batch is padded with its last key
+                size_t count = min<size_t>(4, last_round_keys.size() - first);
+
+                __m128i k10[4], keys[4][11];
+                for (size_t b = 0; b < 4; ++b) k10[b] = load(last_round_keys[first + min(b, count - 1)]);
+                key_schedules_from_last_round_key_x4(k10, keys, method);
+
+                for (size_t b = 0; b < count; ++b) {
+                    decrypt(ciphertexts.data(), plaintexts.data(), ciphertexts.size(), keys[b]);
+
+                    Candidate candidate {last_round_keys[first + b], 0};
+                    bool fits = true;
+                    for (auto const& structure : structures) {
+                        auto [s, ok] = score(plaintexts, structure);
+                        candidate.score += s;
+                        fits &= ok;
+                    }
+
+                    if (fits)
+                    #pragma omp critical
+                    {
+                        shortlist.push_back(candidate);
+                    }
+                }
+            }
+        }
+
+        // ties in key order, for the same output whatever the thread count
+        sort(shortlist.begin(), shortlist.end(), [](Candidate const& a, Candidate const& b) {
+            return (a.score != b.score) ? a.score > b.score : a.K10 < b.K10;
+        });
+
+        return shortlist;
+    }
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <omp.h>
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "tracing.hpp"
+
+using namespace std;
+
+namespace profiling {
+    enum Event { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, EVENT_COUNT };
+
+    constexpr array<uint64_t, EVENT_COUNT> EVENT_CONFIGS {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    using Counts = array<uint64_t, EVENT_COUNT>;
+
+    struct Phase {
+        string name;
+        double seconds = 0;
+        Counts counts {};
+    };
+
+    /**
+     * @brief Hardware performance counters of the main thread and of the OpenMP workers, attributed to named phases.
+     *
+     * Counters are opened per thread (user space only) and read from the main thread at each phase
+     * boundary, so the figures of a phase are summed over every thread that ran during it.
+     * When the kernel refuses the counters, phases are still timed and `counters_available` is false.
+     */
+    class Profiler {
+    public:
+        Profiler() {
+            open_thread_counters(0);
+        }
+
+        ~Profiler() {
+            for (auto const& fds : thread_fds)
+                for (int fd : fds)
+                    if (fd >= 0) close(fd);
+        }
+
+        Profiler(Profiler const&) = delete;
+        Profiler& operator=(Profiler const&) = delete;
+
+        /**
+         * @brief Also count the threads of the OpenMP team of size `threads`.
+         *
+         * Relies on the OpenMP runtime reusing the same threads for later teams of that size,
+         * which is what libgomp and the LLVM runtime do.
+         */
+        void attach_worker_threads(int threads) {
+            vector<pid_t> tids(threads, 0);
+
+            #pragma omp parallel num_threads(threads)
+            tids[omp_get_thread_num()] = (pid_t) syscall(SYS_gettid);
+
+            for (int t = 1; t < threads; ++t)
+                if (tids[t] != 0) open_thread_counters(tids[t]);
+
+            attached_threads = threads;
+        }
+
+        void begin(string const& name) {
+            current = find_or_add(name);
+            start_time = chrono::steady_clock::now();
+            start_counts = read_counters();
+        }
+
+        void end() {
+            if (current == nullptr) return;
+
+            Counts end_counts = read_counters();
+            current->seconds += chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+            for (size_t e = 0; e < EVENT_COUNT; ++e)
+                current->counts[e] += end_counts[e] - start_counts[e];
+
+            current = nullptr;
+        }
+
+        bool counters_available() const { return unavailable_reason.empty(); }
+        string const& reason() const { return unavailable_reason; }
+        int threads() const { return attached_threads; }
+        vector<Phase> const& phases() const { return recorded; }
+
+    private:
+        vector<array<int, EVENT_COUNT>> thread_fds;
+        vector<Phase> recorded;
+        string unavailable_reason;
+        int attached_threads = 1;
+
+        Phase* current = nullptr;
+        chrono::steady_clock::time_point start_time;
+        Counts start_counts {};
+
+        static int perf_event_open(perf_event_attr* attr, pid_t pid) {
+            return (int) syscall(SYS_perf_event_open, attr, pid, -1, -1, 0);
+        }
+
+        void open_thread_counters(pid_t tid) {
+            if (!counters_available()) return;
+
+            array<int, EVENT_COUNT> fds;
+            fds.fill(-1);
+
+            for (size_t e = 0; e < EVENT_COUNT; ++e) {
+                perf_event_attr attr;
+                memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = EVENT_CONFIGS[e];
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+
+                fds[e] = perf_event_open(&attr, tid);
+                if (fds[e] < 0) {
+                    unavailable_reason = string("perf_event_open: ") + strerror(errno);
+                    break;
+                }
+            }
+
+            thread_fds.push_back(fds);
+
+            if (!counters_available()) {
+                for (auto const& opened : thread_fds)
+                    for (int fd : opened)
+                        if (fd >= 0) close(fd);
+                thread_fds.clear();
+            }
+        }
+
+        Counts read_counters() const {
+            Counts total {};
+
+            for (auto const& fds : thread_fds)
+                for (size_t e = 0; e < EVENT_COUNT; ++e) {
+                    uint64_t values[3]; // value, time enabled, time running
+                    if (read(fds[e], values, sizeof(values)) != sizeof(values)) continue;
+
+                    // scale up when the kernel had to multiplex the counters
+                    if (values[2] != 0 && values[2] < values[1])
+                        values[0] = (uint64_t) ((double) values[0] * values[1] / values[2]);
+
+                    total[e] += values[0];
+                }
+
+            return total;
+        }
+
+        Phase* find_or_add(string const& name) {
+            for (auto& phase : recorded)
+                if (phase.name == name) return &phase;
+
+            recorded.push_back({name});
+            return &recorded.back();
+        }
+    };
+
+    /**
+     * @brief Time and count the enclosing block as phase `name` of `profiler`. No-op if `profiler` is null.
+     */
+    class Scope {
+    public:
+        // also a span of the timeline, when tracing
+        Scope(Profiler* profiler, string const& name) : profiler(profiler), span(tracing::enabled() ? tracing::intern(name) : nullptr) {
+            if (profiler) profiler->begin(name);
+        }
+
+        ~Scope() {
+            if (profiler) profiler->end();
+        }
+
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+
+    private:
+        Profiler* profiler;
+        tracing::Span span;
+    };
+
+    inline double ipc(Counts const& counts) {
+        return counts[CYCLES] ? (double) counts[INSTRUCTIONS] / counts[CYCLES] : 0.0;
+    }
+
+    inline void print_table(ostream& os, Profiler const& profiler) {
+        if (!profiler.counters_available())
+            os << "hardware counters unavailable (" << profiler.reason() << "), reporting wall time only" << endl;
+
+        os << left << setw(8) << "phase" << right << setw(12) << "time (ms)";
+        if (profiler.counters_available())
+            os << setw(16) << "cycles" << setw(16) << "instructions" << setw(8) << "IPC"
+               << setw(16) << "cache misses" << setw(16) << "branch misses";
+        os << endl;
+
+        for (auto const& phase : profiler.phases()) {
+            os << left << setw(8) << phase.name << right << setw(12) << fixed << setprecision(3) << phase.seconds * 1e3;
+            if (profiler.counters_available())
+                os << setw(16) << phase.counts[CYCLES] << setw(16) << phase.counts[INSTRUCTIONS]
+                   << setw(8) << setprecision(2) << ipc(phase.counts)
+                   << setw(16) << phase.counts[CACHE_MISSES] << setw(16) << phase.counts[BRANCH_MISSES];
+            os << endl;
+        }
+
+        os << defaultfloat << setprecision(6);
+    }
+
+    inline void print_json(ostream& os, Profiler const& profiler) {
+        os << "{\"counters\": " << (profiler.counters_available() ? "true" : "false");
+        if (!profiler.counters_available())
+            os << ", \"reason\": \"" << profiler.reason() << "\"";
+        os << ", \"threads\": " << profiler.threads() << ", \"phases\": [";
+
+        bool first = true;
+        for (auto const& phase : profiler.phases()) {
+            os << (first ? "" : ", ") << "{\"name\": \"" << phase.name << "\", \"seconds\": " << phase.seconds;
+            if (profiler.counters_available())
+                os << ", \"cycles\": " << phase.counts[CYCLES]
+                   << ", \"instructions\": " << phase.counts[INSTRUCTIONS]
+                   << ", \"ipc\": " << ipc(phase.counts)
+                   << ", \"cache_misses\": " << phase.counts[CACHE_MISSES]
+                   << ", \"branch_misses\": " << phase.counts[BRANCH_MISSES];
+            os << "}";
+            first = false;
+        }
+
+        os << "]}" << endl;
+    }
+}
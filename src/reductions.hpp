@@ -1,263 +1,1222 @@
-#include <array>
-#include <vector>
-
-#include <omp.h>
-
-#include "lookup_tables.hpp"
-#include "aes_ni_utils.hpp"
-
-using namespace std;
-
-const int THREADS = 8;
-
-using u8 = unsigned char;
-using Row = array<u8, 4>;
-using FlatState = array<u8, 16>;
-
-namespace first_stage {
-    /**
-     * @brief Compute the cartesian product of 4 sets.
-     * 
-     * @param (a, b, c, d) sets of elements used for the cartesian product
-     * @return vector<array<u8, 4>> containing all x, y, z, t for x in `a`, y in `b`, z in `c` and t in `d`.
-     */
-    vector<array<u8, 4>> cartesian_product(vector<u8> const& a, vector<u8> const& b, vector<u8> const& c, vector<u8> const& d) {
-        vector<Row> v;
-        
-        for (auto& xa : a) for (auto& xb : b) for (auto& xc : c) for (auto& xd : d)
-            v.push_back({xa, xb, xc, xd});
-        
-        return v;
-    };
-
-    /**
-     * Exhaustive search of all the solutions x in GF(256) of: 
-     * 
-     *      invS(x + a) + invS(x + b) = c
-     * 
-     * @param a, b, c equation parameters
-     * @return vector<u8> found solutions
-     */
-    vector<u8> solve_GF256_equation(const u8 a, const u8 b, const u8 c) {
-        vector<u8> v;
-        
-        for (int x = 0; x < 256; ++x)
-            if ((INV_SBOX[x ^ a] ^ INV_SBOX[x ^ b]) == c)
-                v.push_back(x);
-        
-        return v;
-    }
-
-    /**
-     * Given indices (i0, i1, i2, i3) and appropriate factors (f0, f1, f2, f3),
-     * return possible values of (K_{i0}, K_{i1}, K_{i2}, K_{i3}).
-     * (K being round 10 key)
-     * 
-     * More exactly, find those values that satisfy the following for some \delta:
-     * 
-     *      invS(K_{i0} + Y_{i0}) + invS(K_{i0} + Y'_{i0}) = f_0 * \delta
-     *      invS(K_{i1} + Y_{i1}) + invS(K_{i1} + Y'_{i1}) = f_1 * \delta
-     *      invS(K_{i2} + Y_{i2}) + invS(K_{i2} + Y'_{i2}) = f_2 * \delta
-     *      invS(K_{i3} + Y_{i3}) + invS(K_{i3} + Y'_{i3}) = f_3 * \delta
-     * 
-     * @param Y regular cipher
-     * @param Y_ faulted cipher
-     * @param ind indices (i0, i1, i2, i3)
-     * @param factors factors (f0, f1, f2, f3)
-     * @return vector<Row> possible values of partial key (at indices i0, i1, i2, i3)
-     */
-    vector<Row> partial_key_space_reduction(FlatState const& Y, FlatState const& Y_, array<size_t, 4> ind, array<size_t, 4> factors) {
-        vector<Row> result;
-
-        for (unsigned int delta = 1; delta < 256; ++delta) {
-            auto v0 = solve_GF256_equation(Y[ind[0]], Y_[ind[0]], MUL[factors[0]][delta]);
-            auto v1 = solve_GF256_equation(Y[ind[1]], Y_[ind[1]], MUL[factors[1]][delta]);
-            auto v2 = solve_GF256_equation(Y[ind[2]], Y_[ind[2]], MUL[factors[2]][delta]);
-            auto v3 = solve_GF256_equation(Y[ind[3]], Y_[ind[3]], MUL[factors[3]][delta]);
-
-            for (auto [k_i0, k_i1, k_i2, k_i3] : cartesian_product(v0, v1, v2, v3))
-                result.push_back({k_i0, k_i1, k_i2, k_i3});
-        }
-
-        return result;
-    }
-
-    /**
-     * Return the position of the non-zero column of the differential state
-     * after the first MixColumns following fault injection.
-     * 
-     * @param fault_position 
-     * @return size_t differential column position
-     */
-    size_t get_diff_column(size_t fault_position) {
-        // TODO: handle invalid input
-        switch (fault_position) {
-            case  0: case  5: case 10: case 15: return 0;
-            case  4: case  9: case 14: case  3: return 1;
-            case  8: case 13: case  2: case  7: return 2;
-            case 12: case  1: case  6: case 11: return 3;
-        }
-    }
-
-    /**
-     * @brief Parameters used in first stage reduction.
-     * 
-     * @param diff_column 
-     * @return array<array<size_t, 4>, 4> factors
-     */
-    array<array<size_t, 4>, 4> get_factors(size_t diff_column) {
-        // TODO: handle invalid input
-        switch (diff_column) {
-            case 0:
-                return {{
-                    {2, 1, 1, 3},
-                    {1, 1, 3, 2},
-                    {1, 3, 2, 1},
-                    {3, 2, 1, 1}
-                }};
-            case 1:
-                return {{
-                    {3, 2, 1, 1},
-                    {2, 1, 1, 3},
-                    {1, 1, 3, 2},
-                    {1, 3, 2, 1}
-                }};
-            case 2:
-                return {{
-                    {1, 3, 2, 1},
-                    {3, 2, 1, 1},
-                    {2, 1, 1, 3},
-                    {1, 1, 3, 2}
-                }};
-            case 3:
-                return {{
-                    {1, 1, 3, 2},
-                    {1, 3, 2, 1},
-                    {3, 2, 1, 1},
-                    {2, 1, 1, 3}
-                }};
-        }
-    }
-
-    /**
-     * Return the possible values of each of the quadruples:
-     * 
-     *      ( k1, k14, k11,  k8)
-     *      ( k5,  k2, k15, k12)
-     *      ( k9,  k6,  k3, k16)
-     *      (k13, k10,  k7,  k4)
-     * 
-     * On average, each set of values contains 256 instances, reducing
-     * the search space to 2^32 round 10 keys.
-     * 
-     * @param Y regular cipher
-     * @param Y_ faulted cipher
-     * @param fault_position index of the fault position in [0, 16)
-     * @return array<vector<Row>, 4> 
-     */
-    array<vector<Row>, 4> reduction(FlatState const& Y, FlatState const& Y_, size_t fault_position) {
-        // This should be declared somewhere else...
-        constexpr array<array<size_t, 4>, 4> ind {{
-            { 0, 13, 10,  7},
-            { 4,  1, 14, 11},
-            { 8,  5,  2, 15},
-            {12,  9,  6,  3}
-        }};
-
-        size_t diff_column = get_diff_column(fault_position);
-        auto factors   = get_factors(diff_column);
-
-        auto antidiag1 = partial_key_space_reduction(Y, Y_, ind[0], factors[0]); // values of ( k1, k14, k11,  k8)
-        auto antidiag2 = partial_key_space_reduction(Y, Y_, ind[1], factors[1]); // values of ( k5,  k2, k15, k12)
-        auto antidiag3 = partial_key_space_reduction(Y, Y_, ind[2], factors[2]); // values of ( k9,  k6,  k3, k16)
-        auto antidiag4 = partial_key_space_reduction(Y, Y_, ind[3], factors[3]); // values of (k13, k10,  k7,  k4)
-
-        return {antidiag1, antidiag2, antidiag3, antidiag4};
-    }
-}
-
-namespace second_stage {
-    /**
-     * @brief Return the key formed of first stage reduction results `ad1`, `ad2`, `ad3`, `ad4`.
-     * 
-     * @param ad1
-     * @param ad2
-     * @param ad3
-     * @param ad4 
-     * @return FlatState key
-     */
-    inline FlatState make_key(Row const& ad1, Row const& ad2, Row const& ad3, Row const& ad4) {
-        // This should be declared somewhere else...
-        constexpr array<array<size_t, 4>, 4> ind {{
-            { 0, 13, 10,  7},
-            { 4,  1, 14, 11},
-            { 8,  5,  2, 15},
-            {12,  9,  6,  3}
-        }};
-        
-        FlatState K;
-
-        K[ind[0][0]] = ad1[0]; K[ind[0][1]] = ad1[1]; K[ind[0][2]] = ad1[2]; K[ind[0][3]] = ad1[3];
-        K[ind[1][0]] = ad2[0]; K[ind[1][1]] = ad2[1]; K[ind[1][2]] = ad2[2]; K[ind[1][3]] = ad2[3];
-        K[ind[2][0]] = ad3[0]; K[ind[2][1]] = ad3[1]; K[ind[2][2]] = ad3[2]; K[ind[2][3]] = ad3[3];
-        K[ind[3][0]] = ad4[0]; K[ind[3][1]] = ad4[1]; K[ind[3][2]] = ad4[2]; K[ind[3][3]] = ad4[3];
-
-        return K;
-    }
-
-    /**
-     * @brief Reduce the possible round 10 keys to 256 instances on average.
-     * 
-     * @param Y regular ciphertext
-     * @param Y_ faulted ciphertext
-     * @param fault_position
-     * @param stage1_results
-     * @return vector<FlatState> 
-     */
-    vector<FlatState> reduction(FlatState const& Y, FlatState const& Y_, size_t fault_position, array<vector<Row>, 4> const& stage1_results) {
-        vector<FlatState> found_keys;
-        
-        int fault_mask = get_fault_mask(fault_position);
-        auto [antidiags1, antidiags2, antidiags3, antidiags4] = stage1_results;
-
-        omp_set_num_threads(THREADS);
-
-        #pragma omp parallel for
-        for (auto const& ad1 : antidiags1)
-            for (auto const& ad2 : antidiags2)
-                for (auto const& ad3 : antidiags3)
-                    for (auto const& ad4 : antidiags4)
-                    {
-                        FlatState K10 = make_key(ad1, ad2, ad3, ad4);
-                        if (check_partial_decryption(Y, Y_, K10, fault_mask))
-                        #pragma omp critical
-                        {
-                            found_keys.push_back(K10);
-                        }
-                    }
-        
-        return found_keys;
-    }
-}
-
-namespace third_stage {
-    /**
-     * @brief Find the key used to encrypt `plaintext`.
-     * 
-     * @param ciphertext 
-     * @param plaintext 
-     * @param stage2_results 
-     * @return vector<FlatState> key
-     */
-    vector<FlatState> reduction(FlatState const& ciphertext, FlatState const& plaintext, vector<FlatState> const& stage2_results) {
-        vector<FlatState> valid_keys;
-
-        for (auto K10 : stage2_results)
-            if (decrypt(ciphertext, K10) == plaintext) {
-                auto K0 = get_initial_key(K10);
-                valid_keys.push_back(K0);
-            }
-        
-        return valid_keys;
-    }
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include <omp.h>
+
+#if defined(__GFNI__) && defined(__AVX512F__) && defined(__AVX512BW__)
+#include <immintrin.h>
+#define REDUCTIONS_GFNI 1     // the column filter checks 64 keys per instruction
+#endif
+
+#include "lookup_tables.hpp"
+#include "aes_ni_utils.hpp"
+#include "fault_layout.hpp"
+#include "tracing.hpp"
+
+using namespace std;
+
+const int THREADS = 8;
+
+using u8 = unsigned char;
+using Row = array<u8, 4>;
+using FlatState = array<u8, 16>;
+
+/**
+ * @brief Side information on the key, used to prune the first stage results.
+ * 
+ * `allowed_bytes[i]` holds the admissible values of the i-th byte of the round 10 key (all of them by default).
+ * `last_round_keys`, when not empty, is a short list of candidate round 10 keys (e.g. derived from candidate
+ * initial keys): every antidiagonal value has to match one of them.
+ */
+struct KeyHints {
+    array<bitset<256>, 16> allowed_bytes;
+    vector<FlatState> last_round_keys;
+
+    KeyHints() {
+        for (auto& allowed : allowed_bytes) allowed.set();
+    }
+};
+
+/**
+ * @brief What is known of the injected fault.
+ * 
+ * `differences` holds the admissible fault differences (all the nonzero ones by default), `stuck_value` the value
+ * the faulted byte is forced to, if any. The fault hits the round 8 entry state or, with `at_sbox_output`, the
+ * output of its SubBytes, i.e. the round 8 `MixColumns` input (see README).
+ * 
+ * Faults at the `MixColumns` input restrict the difference `eps` of the first and second stage equations, and with it
+ * the first stage deltas and the join of the second stage. Every model also filters the final candidates: their partial
+ * decryption gives the faulted byte before and after the fault.
+ */
+struct FaultModel {
+    bitset<256> differences;
+    int stuck_value = -1;
+    bool at_sbox_output = false;
+
+    FaultModel() {
+        differences.set();
+        differences.reset(0);
+    }
+
+    static FaultModel bit_flip() {
+        FaultModel model;
+        model.differences.reset();
+        for (int b = 0; b < 8; ++b) model.differences.set(1 << b);
+        return model;
+    }
+
+    static FaultModel stuck_at(u8 value) {
+        FaultModel model;
+        model.stuck_value = value;
+        return model;
+    }
+
+    static FaultModel known_difference(u8 difference) {
+        FaultModel model;
+        model.differences.reset();
+        model.differences.set(difference);
+        return model;
+    }
+
+    bool is_arbitrary() const { return stuck_value < 0 && differences.count() == 255; }
+
+    /**
+     * @brief Admissible differences `eps` at the round 8 `MixColumns` input.
+     */
+    bitset<256> mix_columns_input_differences() const {
+        if (at_sbox_output) return differences;
+
+        bitset<256> eps;
+        for (int x = 0; x < 256; ++x)
+            for (int e = 1; e < 256; ++e)
+                if (differences[e]) eps.set(SBOX[x] ^ SBOX[x ^ e]);
+
+        return eps;
+    }
+
+    /**
+     * @brief Whether the faulted byte `before` / `after` the fault, as seen at the round 8 `MixColumns` input, fits the model.
+     */
+    bool admits(u8 before, u8 after) const {
+        if (!at_sbox_output) {
+            before = INV_SBOX[before];
+            after  = INV_SBOX[after];
+        }
+
+        if (stuck_value >= 0 && after != stuck_value) return false;
+
+        return differences[before ^ after];
+    }
+
+    /**
+     * @brief Whether the round 10 key candidate `K10` gives a fault fitting the model.
+     */
+    bool admits(FlatState const& Y, FlatState const& Y_, FlatState const& K10, size_t fault_position) const {
+        if (is_arbitrary()) return true;
+
+        // position of the faulted byte once shifted by ShiftRows
+        size_t shifted = shift_rows(fault_position);
+
+        return admits(partial_decryption(Y, K10)[shifted], partial_decryption(Y_, K10)[shifted]);
+    }
+};
+
+namespace first_stage {
+    /**
+     * @brief Compute the cartesian product of 4 sets.
+     * 
+     * @param (a, b, c, d) sets of elements used for the cartesian product
+     * @return vector<array<u8, 4>> containing all x, y, z, t for x in `a`, y in `b`, z in `c` and t in `d`.
+     */
+    inline vector<array<u8, 4>> cartesian_product(vector<u8> const& a, vector<u8> const& b, vector<u8> const& c, vector<u8> const& d) {
+        vector<Row> v;
+        
+        for (auto& xa : a) for (auto& xb : b) for (auto& xc : c) for (auto& xd : d)
+            v.push_back({xa, xb, xc, xd});
+        
+        return v;
+    };
+
+    /**
+     * Exhaustive search of all the solutions x in GF(256) of: 
+     * 
+     *      invS(x + a) + invS(x + b) = c
+     * 
+     * @param a, b, c equation parameters
+     * @return vector<u8> found solutions
+     */
+    inline vector<u8> solve_GF256_equation(const u8 a, const u8 b, const u8 c) {
+        vector<u8> v;
+        
+        for (int x = 0; x < 256; ++x)
+            if ((INV_SBOX[x ^ a] ^ INV_SBOX[x ^ b]) == c)
+                v.push_back(x);
+        
+        return v;
+    }
+
+    /**
+     * Given indices (i0, i1, i2, i3) and appropriate factors (f0, f1, f2, f3),
+     * return possible values of (K_{i0}, K_{i1}, K_{i2}, K_{i3}).
+     * (K being round 10 key)
+     * 
+     * More exactly, find those values that satisfy the following for some \delta:
+     * 
+     *      invS(K_{i0} + Y_{i0}) + invS(K_{i0} + Y'_{i0}) = f_0 * \delta
+     *      invS(K_{i1} + Y_{i1}) + invS(K_{i1} + Y'_{i1}) = f_1 * \delta
+     *      invS(K_{i2} + Y_{i2}) + invS(K_{i2} + Y'_{i2}) = f_2 * \delta
+     *      invS(K_{i3} + Y_{i3}) + invS(K_{i3} + Y'_{i3}) = f_3 * \delta
+     * 
+     * @param Y regular cipher
+     * @param Y_ faulted cipher
+     * @param ind indices (i0, i1, i2, i3)
+     * @param factors factors (f0, f1, f2, f3)
+     * @param deltas admissible values of \delta
+     * @return vector<Row> possible values of partial key (at indices i0, i1, i2, i3)
+     */
+    inline vector<Row> partial_key_space_reduction(FlatState const& Y, FlatState const& Y_, array<size_t, 4> ind, array<size_t, 4> factors, bitset<256> const& deltas = bitset<256>().set()) {
+        vector<Row> result;
+
+        for (unsigned int delta = 1; delta < 256; ++delta) {
+            if (!deltas[delta]) continue;
+
+            auto v0 = solve_GF256_equation(Y[ind[0]], Y_[ind[0]], MUL[factors[0]][delta]);
+            auto v1 = solve_GF256_equation(Y[ind[1]], Y_[ind[1]], MUL[factors[1]][delta]);
+            auto v2 = solve_GF256_equation(Y[ind[2]], Y_[ind[2]], MUL[factors[2]][delta]);
+            auto v3 = solve_GF256_equation(Y[ind[3]], Y_[ind[3]], MUL[factors[3]][delta]);
+
+            for (auto [k_i0, k_i1, k_i2, k_i3] : cartesian_product(v0, v1, v2, v3))
+                result.push_back({k_i0, k_i1, k_i2, k_i3});
+        }
+
+        return result;
+    }
+
+    /**
+     * Return the position of the non-zero column of the differential state
+     * after the first MixColumns following fault injection.
+     * 
+     * @param fault_position 
+     * @return size_t differential column position
+     */
+    inline size_t get_diff_column(size_t fault_position) {
+        return SINGLE_BYTE_LAYOUTS[fault_position].diff_column;
+    }
+
+    /**
+     * @brief Admissible \delta of each antidiagonal under the fault model `model`.
+     * 
+     * The \delta of antidiagonal j is the SubBytes output difference, in round 9, of the byte (r_j, c) of the round 8
+     * output column c = `get_diff_column(fault_position)`, r_j = (c - j) mod 4, whose input difference is f_{r_j} * eps.
+     * (eps being the round 8 `MixColumns` input difference, f_{r_j} the layout's `propagation[j]`)
+     * 
+     * @param fault the fault type, whose layout gives the factors
+     * @param model
+     * @return array<bitset<256>, 4> admissible values of \delta
+     */
+    template<typename Fault>
+    inline array<bitset<256>, 4> get_deltas(Fault, FaultModel const& model) {
+        array<bitset<256>, 4> deltas;
+        for (auto& d : deltas) d.set();
+
+        // the differences of several faulted bytes mix in round 8: no single eps to restrict the deltas with
+        auto eps = model.mix_columns_input_differences();
+        if (!Fault::LAYOUT.single_byte || eps.count() == 255) return deltas;
+
+        for (size_t j = 0; j < 4; ++j) {
+            u8 f = Fault::LAYOUT.propagation[j];
+
+            deltas[j].reset();
+            for (int e = 1; e < 256; ++e)
+                if (eps[e])
+                    for (int x = 0; x < 256; ++x)
+                        deltas[j].set(SBOX[x] ^ SBOX[x ^ gf_mul(f, e)]);
+        }
+
+        return deltas;
+    }
+
+    /**
+     * Return the possible values of each of the quadruples:
+     * 
+     *      ( k1, k14, k11,  k8)
+     *      ( k5,  k2, k15, k12)
+     *      ( k9,  k6,  k3, k16)
+     *      (k13, k10,  k7,  k4)
+     * 
+     * On average, each set of values contains 256 instances, reducing
+     * the search space to 2^32 round 10 keys.
+     * 
+     * @param fault the fault type, whose layout gives the equation factors
+     * @param Y regular cipher
+     * @param Y_ faulted cipher
+     * @param model fault model, restricting the admissible deltas
+     * @return array<vector<Row>, 4> 
+     */
+    template<typename Fault>
+    inline array<vector<Row>, 4> reduction(Fault fault, FlatState const& Y, FlatState const& Y_, FaultModel const& model = {}) {
+        auto const& ind = ANTIDIAGONALS;
+
+        constexpr auto factors = Fault::LAYOUT.factors;
+        auto deltas    = get_deltas(fault, model);
+
+        auto antidiag1 = partial_key_space_reduction(Y, Y_, ind[0], factors[0], deltas[0]); // values of ( k1, k14, k11,  k8)
+        auto antidiag2 = partial_key_space_reduction(Y, Y_, ind[1], factors[1], deltas[1]); // values of ( k5,  k2, k15, k12)
+        auto antidiag3 = partial_key_space_reduction(Y, Y_, ind[2], factors[2], deltas[2]); // values of ( k9,  k6,  k3, k16)
+        auto antidiag4 = partial_key_space_reduction(Y, Y_, ind[3], factors[3], deltas[3]); // values of (k13, k10,  k7,  k4)
+
+        return {antidiag1, antidiag2, antidiag3, antidiag4};
+    }
+
+    /**
+     * @brief `reduction` of a fault at `fault_position`, in [0, 16).
+     */
+    inline array<vector<Row>, 4> reduction(FlatState const& Y, FlatState const& Y_, size_t fault_position, FaultModel const& model = {}) {
+        return dispatch_fault(fault_position, [&](auto fault) { return reduction(fault, Y, Y_, model); });
+    }
+
+    /**
+     * @brief `reduction` of a fault described by `fault`, which may hit several bytes of a column.
+     */
+    inline array<vector<Row>, 4> reduction(FlatState const& Y, FlatState const& Y_, FaultDescriptor const& fault, FaultModel const& model = {}) {
+        return dispatch_fault(fault, [&](auto type) { return reduction(type, Y, Y_, model); });
+    }
+
+    /**
+     * @brief Drop the antidiagonal values contradicting `hints`.
+     * 
+     * @param stage1_results results of `reduction`, filtered in place
+     * @param hints
+     */
+    inline void apply_hints(array<vector<Row>, 4>& stage1_results, KeyHints const& hints) {
+        for (size_t d = 0; d < 4; ++d) {
+            auto const& ind = ANTIDIAGONALS[d];
+
+            auto is_admissible = [&](Row const& row) {
+                for (size_t i = 0; i < 4; ++i)
+                    if (!hints.allowed_bytes[ind[i]][row[i]]) return false;
+
+                if (hints.last_round_keys.empty()) return true;
+
+                for (auto const& K10 : hints.last_round_keys)
+                    if (row == Row {K10[ind[0]], K10[ind[1]], K10[ind[2]], K10[ind[3]]}) return true;
+
+                return false;
+            };
+
+            auto& rows = stage1_results[d];
+            rows.erase(remove_if(rows.begin(), rows.end(), [&](Row const& row) { return !is_admissible(row); }), rows.end());
+        }
+    }
+
+    /**
+     * @brief `reduction` restricted to the antidiagonal values compatible with `hints`.
+     */
+    inline array<vector<Row>, 4> reduction(FlatState const& Y, FlatState const& Y_, size_t fault_position, KeyHints const& hints, FaultModel const& model = {}) {
+        auto stage1_results = reduction(Y, Y_, fault_position, model);
+        apply_hints(stage1_results, hints);
+
+        return stage1_results;
+    }
+
+    inline array<vector<Row>, 4> reduction(FlatState const& Y, FlatState const& Y_, FaultDescriptor const& fault, KeyHints const& hints, FaultModel const& model = {}) {
+        auto stage1_results = reduction(Y, Y_, fault, model);
+        apply_hints(stage1_results, hints);
+
+        return stage1_results;
+    }
+}
+
+namespace second_stage {
+    /**
+     * @brief Search algorithm of the second stage: the 2^32 `reduction` sweep, the `join_reduction` join, or the sweep
+     * over flat key index ranges of `sweep_range`.
+     */
+    enum class Engine { SWEEP, JOIN, RANGE };
+
+    /**
+     * @brief Candidate check used by the sweep: one key at a time, 4 interleaved keys, 4 keys per VAES instruction, or
+     * the column filter of `filter_keys`, dropping keys on the first wrong byte of the differential column.
+     */
+    enum class Kernel { SCALAR, INTERLEAVED, VAES, COLUMN };
+
+    /**
+     * @brief Second stage configuration, as picked for the host by `tuning::tune`.
+     * 
+     * `inversion` is that of the key schedules following the search, from the candidates to their initial keys: the
+     * third stage, the plaintext structure oracle and the initial keys printed.
+     */
+    struct Settings {
+        Engine engine = Engine::SWEEP;
+        Kernel kernel = Kernel::SCALAR;
+        KeyInversion inversion = KeyInversion::AESKEYGENASSIST;
+        int threads = THREADS;
+        int chunk = 0;      // OpenMP dynamic schedule chunk of the sweep outer loop, 0 for a static schedule
+    };
+
+    /**
+     * @brief Cooperative cancellation and progress of a running search, shared with other threads.
+     * 
+     * The search polls `cancelled` between work units and counts the units it went through in `done`.
+     * 
+     * It is also an anytime search: it cancels itself once past `deadline`, once `max_keys` keys are found, or once a
+     * key passes `accept` (say, a known plaintext check). Units in progress then complete, so that `covered` tells
+     * exactly which units were searched, indexed as rows of the first antidiagonal for the sweep, as fault
+     * differences for the join and as key blocks for the range sweep. Units set in `skip`, covered by an earlier run,
+     * are not searched again.
+     * 
+     * With `shards` > 1, the search is one of `shards` independent ones splitting the unit indices into contiguous
+     * parts: it only goes through part `shard`, in [0, `shards`), its progress and `covered` ignoring the others.
+     */
+    struct Control {
+        atomic<bool> cancelled {false};
+        atomic<size_t> done {0};
+        atomic<size_t> total {0};
+
+        chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+        size_t max_keys = 0;                            // 0 for no limit
+        function<bool(FlatState const&)> accept;        // called under the search's critical section
+        vector<u8> skip;
+        size_t shard = 0;
+        size_t shards = 1;
+
+        vector<u8> covered;
+        atomic<size_t> keys_found {0};
+        atomic<bool> accepted {false};
+
+        /**
+         * @brief Unit indices [first, last) of the shard, out of `indices`.
+         */
+        pair<size_t, size_t> shard_range(size_t indices) const {
+            return {(shard * indices + shards - 1) / shards, ((shard + 1) * indices + shards - 1) / shards};
+        }
+
+        /**
+         * @param units number of work units of the shard, for the progress
+         * @param indices size of the index space of the units, `units` by default
+         */
+        void start(size_t units, size_t indices = 0) {
+            done = 0;
+            total = units;
+            covered.assign(indices ? indices : units, 0);
+        }
+
+        double progress() const {
+            size_t t = total;
+            return (t == 0) ? 0.0 : (double) done / t;
+        }
+
+        /**
+         * @brief Whether to search unit `index`, false once cancelled or if an earlier run covered it.
+         */
+        bool claim(size_t index) {
+            if (index < skip.size() && skip[index]) {
+                covered[index] = 1;
+                ++done;
+                return false;
+            }
+
+            if (cancelled) return false;
+            if (chrono::steady_clock::now() >= deadline) {
+                cancelled = true;
+                return false;
+            }
+
+            return true;
+        }
+
+        void finish(size_t index) {
+            covered[index] = 1;
+            ++done;
+        }
+
+        // a key found, in the search's critical section
+        void found(FlatState const& key) {
+            if (max_keys != 0 && ++keys_found >= max_keys) cancelled = true;
+            if (accept && accept(key)) {
+                accepted = true;
+                cancelled = true;
+            }
+        }
+    };
+
+    inline bool kernel_available(Kernel kernel) {
+#ifdef AES_NI_UTILS_VAES
+        return true;
+#else
+        return kernel != Kernel::VAES;
+#endif
+    }
+
+    /**
+     * @brief Return the key formed of first stage reduction results `ad1`, `ad2`, `ad3`, `ad4`.
+     * 
+     * @param ad1
+     * @param ad2
+     * @param ad3
+     * @param ad4 
+     * @return FlatState key
+     */
+    inline FlatState make_key(Row const& ad1, Row const& ad2, Row const& ad3, Row const& ad4) {
+        auto const& ind = ANTIDIAGONALS;
+        
+        FlatState K;
+
+        K[ind[0][0]] = ad1[0]; K[ind[0][1]] = ad1[1]; K[ind[0][2]] = ad1[2]; K[ind[0][3]] = ad1[3];
+        K[ind[1][0]] = ad2[0]; K[ind[1][1]] = ad2[1]; K[ind[1][2]] = ad2[2]; K[ind[1][3]] = ad2[3];
+        K[ind[2][0]] = ad3[0]; K[ind[2][1]] = ad3[1]; K[ind[2][2]] = ad3[2]; K[ind[2][3]] = ad3[3];
+        K[ind[3][0]] = ad4[0]; K[ind[3][1]] = ad4[1]; K[ind[3][2]] = ad4[2]; K[ind[3][3]] = ad4[3];
+
+        return K;
+    }
+
+    /**
+     * @brief Contribution of a first stage `Row` to the round 10 key and to the linear part of the round 9 key InvMixColumns image.
+     * 
+     * Apart from the SubWord(RotWord(x)) term, x = K10[2] xor K10[3], the InvMixColumns image of the round 9 key
+     * is linear in the round 10 key: xoring the contributions of the 4 antidiagonals yields it up to that term,
+     * which `add_subword_rotword` then gets from the xor of the `x` contributions with a few table lookups.
+     * This keeps `aeskeygenassist` and `aesimc` out of the search loop.
+     */
+    struct KeyContribution {
+        __m128i k10;
+        __m128i k9imc;      // linear part of the round 9 key InvMixColumns image
+        uint32_t x;         // part of K10[2] xor K10[3]
+        uint32_t z = 0;         // column filter: the bytes of `k9imc` it reads, see `filter_keys`
+        uint64_t column = 0;    // column filter: its inputs a, a' of antidiagonal j, at bits 16 j
+    };
+
+    inline KeyContribution get_key_contribution(Row const& row, size_t antidiag) {
+        FlatState K {};
+        for (size_t i = 0; i < 4; ++i) K[ANTIDIAGONALS[antidiag][i]] = row[i];
+
+        KeyContribution c;
+        c.k10   = load(K);
+        c.k9imc = _mm_aesimc_si128(_mm_xor_si128(c.k10, _mm_slli_si128(c.k10, 4)));   // [K4 xor K3, K3 xor K2, K2 xor K1, K1]
+        c.x     = (uint32_t) (K[ 8] ^ K[12])       | (uint32_t) (K[ 9] ^ K[13]) <<  8
+                | (uint32_t) (K[10] ^ K[14]) << 16 | (uint32_t) (K[11] ^ K[15]) << 24;
+
+        return c;
+    }
+
+    inline KeyContribution operator^(KeyContribution const& a, KeyContribution const& b) {
+        return {
+            _mm_xor_si128(a.k10, b.k10),
+            _mm_xor_si128(a.k9imc, b.k9imc),
+            a.x ^ b.x,
+            a.z ^ b.z,
+            a.column ^ b.column,
+        };
+    }
+
+    /**
+     * @brief InvMixColumns image of the first column (`rcon`, 0, 0, 0), as a little endian word.
+     */
+    constexpr uint32_t inv_mix_rcon(u8 rcon) {
+        return (uint32_t) gf_mul(INV_MIX_COLUMNS_ROW[0], rcon)       | (uint32_t) gf_mul(INV_MIX_COLUMNS_ROW[3], rcon) <<  8
+             | (uint32_t) gf_mul(INV_MIX_COLUMNS_ROW[2], rcon) << 16 | (uint32_t) gf_mul(INV_MIX_COLUMNS_ROW[1], rcon) << 24;
+    }
+
+    /**
+     * @brief InvMixColumns image of the SubWord(RotWord(x)) xor RCON term, the first column of the round 9 key missing
+     * from its linear part, `rcon_imc` being that of RCON.
+     */
+    inline uint32_t subword_rotword_imc(uint32_t x, uint32_t rcon_imc) {
+        u8 x0 = x, x1 = x >> 8, x2 = x >> 16, x3 = x >> 24;
+
+        return INV_MIX_SUBWORD_ROTWORD[0][x0] ^ INV_MIX_SUBWORD_ROTWORD[1][x1]
+             ^ INV_MIX_SUBWORD_ROTWORD[2][x2] ^ INV_MIX_SUBWORD_ROTWORD[3][x3] ^ rcon_imc;
+    }
+
+    /**
+     * @brief Complete the linear part `k9imc` with the InvMixColumns image of the SubWord(RotWord(x)) xor RCON term,
+     * `rcon_imc` being that of RCON.
+     */
+    inline void add_subword_rotword(uint32_t x, __m128i& k9imc, uint32_t rcon_imc = inv_mix_rcon(0x36)) {
+        k9imc = _mm_xor_si128(k9imc, _mm_cvtsi32_si128((int) subword_rotword_imc(x, rcon_imc)));
+    }
+
+    /**
+     * @brief How the sweep derives InvMixColumns(K9) from the round 10 key candidates: xor of the `contribution`s of
+     * their rows, of `offset`, and of the InvMixColumns image of SubWord(RotWord(x)) xor `rcon`.
+     * 
+     * The default is the AES-128 key schedule. `aes256` plugs in the relation between its last three round keys.
+     */
+    struct KeyRelation {
+        KeyContribution (*contribution)(Row const&, size_t) = get_key_contribution;
+        __m128i offset = _mm_setzero_si128();
+        u8 rcon = 0x36;
+    };
+
+    /**
+     * @brief Contributions of the first stage results to the key candidates of ciphertexts `y`, `y_`, under `relation`.
+     */
+    template<typename Fault>
+    inline array<vector<KeyContribution>, 4> get_contributions(Fault, __m128i y, __m128i y_, array<vector<Row>, 4> const& stage1_results, KeyRelation const& relation) {
+        constexpr size_t c = Fault::LAYOUT.diff_column;
+
+        array<vector<KeyContribution>, 4> contributions;
+        for (size_t d = 0; d < 4; ++d)
+            for (auto const& row : stage1_results[d])
+                contributions[d].push_back(relation.contribution(row, d));
+
+        // the offset goes in once, with the first antidiagonal
+        for (auto& contribution : contributions[0])
+            contribution.k9imc = _mm_xor_si128(contribution.k9imc, relation.offset);
+
+        // the column filter inputs: a, a' only depend on the row of antidiagonal j, z is linear in the key
+        for (size_t j = 0; j < 4; ++j)
+            for (auto& contribution : contributions[j]) {
+                auto k9imc = unload(contribution.k9imc);
+                for (size_t i = 0; i < 4; ++i) contribution.z |= (uint32_t) k9imc[4*i + (c + 4 - i) % 4] << 8*i;
+
+                size_t r = (c + 4 - j) % 4;
+                u8 a  = unload(_mm_aesimc_si128(_mm_aesdeclast_si128(_mm_xor_si128(y , contribution.k10), _mm_setzero_si128())))[4*j + r];
+                u8 a_ = unload(_mm_aesimc_si128(_mm_aesdeclast_si128(_mm_xor_si128(y_, contribution.k10), _mm_setzero_si128())))[4*j + r];
+                contribution.column = (uint64_t) (a | a_ << 8) << 16*j;
+            }
+
+        return contributions;
+    }
+
+    /**
+     * @brief Inputs of the column filter of the fourth antidiagonal rows, byte sliced: byte k of their `x` and `z`,
+     * and their a, a', one vector per byte.
+     */
+    struct ColumnInputs {
+        array<vector<u8>, 4> x;
+        array<vector<u8>, 4> z;
+        array<vector<u8>, 2> a;
+    };
+
+    inline ColumnInputs slice_column_inputs(vector<KeyContribution> const& antidiags4) {
+        ColumnInputs inputs;
+        for (auto const& ad4 : antidiags4) {
+            for (size_t k = 0; k < 4; ++k) {
+                inputs.x[k].push_back(ad4.x >> 8*k);
+                inputs.z[k].push_back(ad4.z >> 8*k);
+            }
+            inputs.a[0].push_back(ad4.column >> 48);
+            inputs.a[1].push_back(ad4.column >> 56);
+        }
+
+        return inputs;
+    }
+
+    /**
+     * @brief Rows of the differential column checked by the column filter, those the fault leaves unchanged first,
+     * -1 past the last.
+     */
+    template<typename Fault>
+    constexpr array<int, 4> filter_rows() {
+        constexpr size_t c = Fault::LAYOUT.diff_column;
+        int equal = Fault::LAYOUT.fault_mask >> 4*c, checked = Fault::LAYOUT.checked_mask >> 4*c;
+
+        array<int, 4> rows {-1, -1, -1, -1};
+        size_t n = 0;
+        for (int i = 0; i < 4; ++i) if (checked >> i & 1 && equal >> i & 1) rows[n++] = i;
+        for (int i = 0; i < 4; ++i) if (checked >> i & 1 && !(equal >> i & 1)) rows[n++] = i;
+
+        return rows;
+    }
+
+#ifdef REDUCTIONS_GFNI
+    /**
+     * @brief `filter_keys` of 64 keys per instruction, `end - begin` being a multiple of 64: the bytes of the column
+     * filter are byte sliced in 512 bits registers, the S-boxes and the InvMixColumns products computed by GFNI.
+     */
+    template<typename Fault, typename Found>
+    inline void filter_keys_x64(Fault, KeyContribution const& ad123, vector<KeyContribution> const& antidiags4, ColumnInputs const& inputs, size_t begin, size_t end, uint32_t rcon_imc, Found const& found) {
+        constexpr size_t c = Fault::LAYOUT.diff_column;
+        constexpr int equal_rows = Fault::LAYOUT.fault_mask >> 4*c;
+        constexpr auto ROWS = filter_rows<Fault>();
+
+        // invS(v) = inverse(A^-1 v + 5), S(v) = A inverse(v) + 0x63, A being the S-box affine map
+        const __m512i INV_AFFINE = _mm512_set1_epi64(0xa44992254a942952);
+        const __m512i AFFINE     = _mm512_set1_epi64(0xf1e3c78f1f3e7cf8);
+        const __m512i IDENTITY   = _mm512_set1_epi64(0x0102040810204080);
+        auto inv_sbox = [&](__m512i v) { return _mm512_gf2p8affineinv_epi64_epi8(_mm512_gf2p8affine_epi64_epi8(v, INV_AFFINE, 0x05), IDENTITY, 0); };
+        auto broadcast = [](uint64_t v, size_t byte) { return _mm512_set1_epi8((char) (v >> 8*byte)); };
+
+        // the key bytes of the first three antidiagonals, and byte c of the SubWord(RotWord(x)) term factors
+        __m512i x123[4], z123[4], a123[3], a123_[3], subword_factors[4];
+        for (size_t k = 0; k < 4; ++k) {
+            x123[k] = broadcast(ad123.x, k);
+            z123[k] = broadcast(ad123.z, k);
+            subword_factors[k] = _mm512_set1_epi8((char) INV_MIX_COLUMNS_ROW[((k + 3) % 4 + 4 - c) % 4]);
+        }
+        for (size_t j = 0; j < 3; ++j) {
+            a123[j]  = broadcast(ad123.column, 2*j);
+            a123_[j] = broadcast(ad123.column, 2*j + 1);
+        }
+        __m512i rcon = broadcast(rcon_imc, c);
+
+        for (size_t i = begin; i < end; i += 64) {
+            __m512i term = rcon;
+            for (size_t k = 0; k < 4; ++k) {
+                __m512i x = _mm512_xor_si512(x123[k], _mm512_loadu_si512(&inputs.x[k][i]));
+                term = _mm512_xor_si512(term, _mm512_gf2p8mul_epi8(_mm512_gf2p8affineinv_epi64_epi8(x, AFFINE, 0x63), subword_factors[k]));
+            }
+
+            __m512i d[4];
+            for (size_t j = 0; j < 4; ++j) {
+                __m512i z = _mm512_xor_si512(z123[j], _mm512_loadu_si512(&inputs.z[j][i]));
+                if (j == 0) z = _mm512_xor_si512(z, term);
+
+                __m512i a  = (j < 3) ? a123[j]  : _mm512_loadu_si512(&inputs.a[0][i]);
+                __m512i a_ = (j < 3) ? a123_[j] : _mm512_loadu_si512(&inputs.a[1][i]);
+                d[(c + 4 - j) % 4] = _mm512_xor_si512(inv_sbox(_mm512_xor_si512(a, z)), inv_sbox(_mm512_xor_si512(a_, z)));
+            }
+
+            __mmask64 valid = ~(__mmask64) 0;
+            for (int row : ROWS) {
+                if (row < 0 || valid == 0) break;
+
+                __m512i difference = _mm512_setzero_si512();
+                for (size_t r = 0; r < 4; ++r)
+                    difference = _mm512_xor_si512(difference, _mm512_gf2p8mul_epi8(d[r], _mm512_set1_epi8((char) INV_MIX_COLUMNS_ROW[(r + 4 - row) % 4])));
+
+                __mmask64 zero = _mm512_cmpeq_epi8_mask(difference, _mm512_setzero_si512());
+                valid &= (equal_rows >> row & 1) ? zero : ~zero;
+            }
+
+            for (; valid != 0; valid &= valid - 1)
+                found(unload(_mm_xor_si128(ad123.k10, antidiags4[i + __builtin_ctzll(valid)].k10)));
+        }
+    }
+#endif
+
+    /**
+     * @brief The column filter of the keys `ad123 ^ antidiags4[i]`, i in [`begin`, `end`), calling `found(K10)` for
+     * those passing: the check of `check_partial_decryption`, one column and one byte at a time with table lookups.
+     * 
+     * The rows of the first stage already make the round 8 difference zero out of the differential column c: that of
+     * the InvSubBytes input of round 9 has one nonzero byte per column j, (r_j, j) with r_j = (c - j) mod 4, which
+     * InvShiftRows gathers into column c. Only column c is thus computed, from the bytes
+     * 
+     *      a_j = InvMixColumns(invS(invSR(Y xor K10)))[r_j][j]     (a'_j for Y')
+     * 
+     * depending on the row of antidiagonal j alone, and z_j = InvMixColumns(K9)[r_j][j]:
+     * 
+     *      d_{r_j} = invS(a_j + z_j) + invS(a'_j + z_j),       difference[i][c] = sum over r of InvMixColumns[i][r] * d_r
+     * 
+     * The bytes the fault leaves unchanged come first, the key being dropped on the first nonzero one: 8 S-box and 4
+     * product lookups for all but 1 in 256 keys, and no AES instruction. Built with GFNI and AVX-512, runs of 64 keys
+     * go through `filter_keys_x64` instead, the lookups giving way to byte sliced arithmetic.
+     * 
+     * Only valid on first stage results, the AES-NI kernels also checking the other columns.
+     */
+    template<typename Fault, typename Found>
+    inline void filter_keys(Fault fault, KeyContribution const& ad123, vector<KeyContribution> const& antidiags4, ColumnInputs const& inputs, size_t begin, size_t end, uint32_t rcon_imc, Found const& found) {
+        constexpr size_t c = Fault::LAYOUT.diff_column;
+        constexpr int equal_rows = Fault::LAYOUT.fault_mask >> 4*c;
+        constexpr auto ROWS = filter_rows<Fault>();
+
+#ifdef REDUCTIONS_GFNI
+        size_t sliced_end = begin + (end - begin) / 64 * 64;
+        filter_keys_x64(fault, ad123, antidiags4, inputs, begin, sliced_end, rcon_imc, found);
+        begin = sliced_end;
+#endif
+
+        for (size_t i = begin; i < end; ++i) {
+            auto const& ad4 = antidiags4[i];
+
+            // the SubWord(RotWord(x)) term only reaches z_0, byte c of the first column
+            uint32_t x = ad123.x ^ ad4.x;
+            uint32_t z = ad123.z ^ ad4.z ^ (subword_rotword_imc(x, rcon_imc) >> 8*c & 0xff);
+            uint64_t column = ad123.column ^ ad4.column;
+
+            array<u8, 4> d;
+            for (size_t j = 0; j < 4; ++j) {
+                u8 zj = z >> 8*j;
+                d[(c + 4 - j) % 4] = INV_SBOX[(u8) (column >> 16*j) ^ zj] ^ INV_SBOX[(u8) (column >> (16*j + 8)) ^ zj];
+            }
+
+            bool valid = true;
+            for (int row : ROWS) {
+                if (row < 0) break;
+
+                u8 difference = INV_MIX_MUL[(4 - row) % 4][d[0]] ^ INV_MIX_MUL[(5 - row) % 4][d[1]]
+                              ^ INV_MIX_MUL[(6 - row) % 4][d[2]] ^ INV_MIX_MUL[(7 - row) % 4][d[3]];
+                if ((difference == 0) != bool(equal_rows >> row & 1)) {
+                    valid = false;
+                    break;
+                }
+            }
+
+            if (valid) found(unload(_mm_xor_si128(ad123.k10, ad4.k10)));
+        }
+    }
+
+    /**
+     * @brief Check the keys `ad123 ^ antidiags4[i]`, i in [`begin`, `end`), 4 at a time with `kernel` unless `SCALAR`,
+     * or through `filter_keys` and the `inputs` of `antidiags4` for `COLUMN`, calling `found(K10)` for those passing.
+     */
+    template<typename Fault, typename Found>
+    inline void check_keys(Fault fault, __m128i y, __m128i y_, KeyContribution const& ad123, vector<KeyContribution> const& antidiags4, ColumnInputs const& inputs, size_t begin, size_t end, Kernel kernel, uint32_t rcon_imc, Found const& found) {
+        if (kernel == Kernel::COLUMN) return filter_keys(fault, ad123, antidiags4, inputs, begin, end, rcon_imc, found);
+
+        constexpr int fault_mask = Fault::LAYOUT.fault_mask;
+        constexpr int checked_mask = Fault::LAYOUT.checked_mask;
+
+        auto check_batch = [&](__m128i const k10[4], __m128i const k9imc[4]) {
+#ifdef AES_NI_UTILS_VAES
+            if (kernel == Kernel::VAES) return check_partial_decryption_vaes(y, y_, k10, k9imc, fault_mask, checked_mask);
+#endif
+            return check_partial_decryption_x4(y, y_, k10, k9imc, fault_mask, checked_mask);
+        };
+        size_t batched_end = (kernel == Kernel::SCALAR) ? begin : begin + (end - begin) / 4 * 4;
+
+        for (size_t i = begin; i < batched_end; i += 4) {
+            alignas(64) __m128i k10[4], k9imc[4];
+            for (size_t b = 0; b < 4; ++b) {
+                auto key = ad123 ^ antidiags4[i + b];
+                add_subword_rotword(key.x, key.k9imc, rcon_imc);
+                k10[b] = key.k10; k9imc[b] = key.k9imc;
+            }
+
+            if (int valid = check_batch(k10, k9imc))
+                for (size_t b = 0; b < 4; ++b)
+                    if (valid & (1 << b)) found(unload(k10[b]));
+        }
+
+        for (size_t i = batched_end; i < end; ++i)
+        {
+            auto key = ad123 ^ antidiags4[i];
+            add_subword_rotword(key.x, key.k9imc, rcon_imc);
+
+            if (check_partial_decryption(y, y_, key.k10, key.k9imc, fault_mask, checked_mask)) found(unload(key.k10));
+        }
+    }
+
+    /**
+     * @brief The 2^32 sweep of `reduction`, calling `found(K10)` from the searching threads for every key found.
+     */
+    template<typename Fault, typename Found>
+    inline void sweep(Fault fault, FlatState const& Y, FlatState const& Y_, array<vector<Row>, 4> const& stage1_results, Settings const& settings, Control* control, KeyRelation const& relation, Found const& found) {
+        __m128i y  = load(Y);
+        __m128i y_ = load(Y_);
+
+        auto contributions = get_contributions(fault, y, y_, stage1_results, relation);
+        uint32_t rcon_imc = inv_mix_rcon(relation.rcon);
+
+        auto const& [antidiags1, antidiags2, antidiags3, antidiags4] = contributions;
+        pair<size_t, size_t> rows {0, antidiags1.size()};
+        if (control != nullptr) {
+            rows = control->shard_range(antidiags1.size());
+            control->start(rows.second - rows.first, antidiags1.size());
+        }
+
+        Kernel kernel = kernel_available(settings.kernel) ? settings.kernel : Kernel::SCALAR;
+        auto inputs = (kernel == Kernel::COLUMN) ? slice_column_inputs(antidiags4) : ColumnInputs();
+
+        // the schedule is a per thread setting, concurrent callers don't step on each other
+        omp_set_schedule(settings.chunk > 0 ? omp_sched_dynamic : omp_sched_static, settings.chunk);
+
+        // `num_threads` rather than `omp_set_num_threads` for the same reason
+        #pragma omp parallel num_threads(settings.threads)
+        {
+            #pragma omp for schedule(runtime) nowait
+            for (size_t row = rows.first; row < rows.second; ++row) {
+                auto const& ad1 = antidiags1[row];
+                if (control != nullptr && !control->claim(row)) continue;
+                tracing::Span span("sweep row");
+
+                for (auto const& ad2 : antidiags2) {
+                    auto ad12 = ad1 ^ ad2;
+                    for (auto const& ad3 : antidiags3)
+                        check_keys(fault, y, y_, ad12 ^ ad3, antidiags4, inputs, 0, antidiags4.size(), kernel, rcon_imc, found);
+                }
+
+                if (control != nullptr) control->finish(row);
+            }
+
+            // the load imbalance, on the timeline
+            tracing::Span barrier("barrier");
+            #pragma omp barrier
+        }
+    }
+
+    /**
+     * Keys per work unit of `sweep_range`.
+     */
+    const uint64_t RANGE_BLOCK = 1 << 16;
+
+    /**
+     * @brief The sweep of `reduction` over flat key indices, in blocks of `RANGE_BLOCK` keys, calling `found(K10)`
+     * from the searching threads for every key found.
+     * 
+     * Key t is formed of the rows (i1, i2, i3, i4) of the 4 antidiagonals, t = ((i1 n2 + i2) n3 + i3) n4 + i4, n_j
+     * being their sizes. The blocks are the units of `control`: equal whatever the first stage sizes, they balance the
+     * threads and the shards of candidate spaces far bigger than 2^32 keys, such as those of multi-byte faults, and
+     * tell the part searched of a run stopped early at a finer grain than rows.
+     */
+    template<typename Fault, typename Found>
+    inline void sweep_range(Fault fault, FlatState const& Y, FlatState const& Y_, array<vector<Row>, 4> const& stage1_results, Settings const& settings, Control* control, KeyRelation const& relation, Found const& found) {
+        __m128i y  = load(Y);
+        __m128i y_ = load(Y_);
+
+        auto contributions = get_contributions(fault, y, y_, stage1_results, relation);
+        uint32_t rcon_imc = inv_mix_rcon(relation.rcon);
+
+        auto const& [antidiags1, antidiags2, antidiags3, antidiags4] = contributions;
+        uint64_t n2 = antidiags2.size(), n3 = antidiags3.size(), n4 = antidiags4.size();
+        uint64_t keys = antidiags1.size() * n2 * n3 * n4;
+        int64_t blocks = (keys + RANGE_BLOCK - 1) / RANGE_BLOCK;
+        pair<size_t, size_t> shard_blocks {0, (size_t) blocks};
+        if (control != nullptr) {
+            shard_blocks = control->shard_range(blocks);
+            control->start(shard_blocks.second - shard_blocks.first, blocks);
+        }
+        int64_t first = shard_blocks.first, last = shard_blocks.second;
+
+        Kernel kernel = kernel_available(settings.kernel) ? settings.kernel : Kernel::SCALAR;
+        auto inputs = (kernel == Kernel::COLUMN) ? slice_column_inputs(antidiags4) : ColumnInputs();
+
+        // the schedule is a per thread setting, concurrent callers don't step on each other
+        omp_set_schedule(settings.chunk > 0 ? omp_sched_dynamic : omp_sched_static, settings.chunk);
+
+        #pragma omp parallel num_threads(settings.threads)
+        {
+            #pragma omp for schedule(runtime) nowait
+            for (int64_t block = first; block < last; ++block) {
+                if (control != nullptr && !control->claim(block)) continue;
+                tracing::Span span("sweep block");
+
+                // runs of keys sharing (i1, i2, i3)
+                uint64_t end = min(keys, (block + 1) * RANGE_BLOCK);
+                for (uint64_t t = block * RANGE_BLOCK; t < end; ) {
+                    uint64_t i4 = t % n4, i3 = t / n4 % n3, i2 = t / n4 / n3 % n2, i1 = t / n4 / n3 / n2;
+                    uint64_t run_end = min(n4, i4 + (end - t));
+
+                    check_keys(fault, y, y_, antidiags1[i1] ^ antidiags2[i2] ^ antidiags3[i3], antidiags4, inputs, i4, run_end, kernel, rcon_imc, found);
+                    t += run_end - i4;
+                }
+
+                if (control != nullptr) control->finish(block);
+            }
+
+            tracing::Span barrier("barrier");
+            #pragma omp barrier
+        }
+    }
+
+    /**
+     * @brief `found` callback storing the keys in `keys` and telling `control` of them, in a critical section.
+     */
+    inline auto collect(vector<FlatState>& keys, Control* control) {
+        return [&keys, control](FlatState const& K10) {
+            tracing::Span critical("critical");
+            #pragma omp critical
+            {
+                keys.push_back(K10);
+                if (control != nullptr) control->found(K10);
+            }
+        };
+    }
+
+    template<typename Found>
+    inline void sweep(FlatState const& Y, FlatState const& Y_, size_t fault_position, array<vector<Row>, 4> const& stage1_results, Settings const& settings, Control* control, KeyRelation const& relation, Found const& found) {
+        dispatch_fault(fault_position, [&](auto fault) { sweep(fault, Y, Y_, stage1_results, settings, control, relation, found); });
+    }
+
+    /**
+     * @brief Reduce the possible round 10 keys to 256 instances on average.
+     * 
+     * @param Y regular ciphertext
+     * @param Y_ faulted ciphertext
+     * @param fault_position
+     * @param stage1_results
+     * @param settings kernel, threads and schedule of the sweep (`settings.engine` is ignored)
+     * @param control optional cancellation and progress, in rows of the first antidiagonal
+     * @param relation key schedule relation between the round 10 and round 9 keys
+     * @return vector<FlatState> 
+     */
+    inline vector<FlatState> reduction(FlatState const& Y, FlatState const& Y_, size_t fault_position, array<vector<Row>, 4> const& stage1_results, Settings const& settings, Control* control = nullptr, KeyRelation const& relation = {}) {
+        vector<FlatState> found_keys;
+        sweep(Y, Y_, fault_position, stage1_results, settings, control, relation, collect(found_keys, control));
+
+        return found_keys;
+    }
+
+    /**
+     * @brief `reduction` with the scalar kernel on `threads` OpenMP threads.
+     */
+    inline vector<FlatState> reduction(FlatState const& Y, FlatState const& Y_, size_t fault_position, array<vector<Row>, 4> const& stage1_results, int threads = THREADS) {
+        Settings settings;
+        settings.threads = threads;
+
+        return reduction(Y, Y_, fault_position, stage1_results, settings);
+    }
+
+    /**
+     * @brief The join of `join_reduction`, calling `found(K10)` from the searching threads for every key found.
+     */
+    template<typename Fault, typename Found>
+    inline void join(Fault, FlatState const& Y, FlatState const& Y_, array<vector<Row>, 4> const& stage1_results, int threads, FaultModel const& model, Control* control, Found const& found) {
+        auto admissible_eps = model.mix_columns_input_differences();
+        pair<size_t, size_t> shard_eps {0, 256};
+        if (control != nullptr) {
+            shard_eps = control->shard_range(256);
+
+            size_t units = 0;
+            for (size_t eps = shard_eps.first; eps < shard_eps.second; ++eps) units += admissible_eps[eps];
+            control->start(units, 256);
+        }
+        int first = max<int>(1, shard_eps.first), last = shard_eps.second;
+
+        constexpr int fault_mask = Fault::LAYOUT.fault_mask;
+        constexpr size_t c = Fault::LAYOUT.diff_column;
+        __m128i y  = load(Y);
+        __m128i y_ = load(Y_);
+
+        // Per antidiagonal j: linear parts of z_1, z_2, z_3 (bytes 0, 1, 2) for each row,
+        // and for j > 0, the (row index, z_j) solutions of equation j grouped by eps.
+        array<vector<uint32_t>, 4> z_parts;
+        array<array<vector<pair<uint16_t, u8>>, 256>, 4> solutions;
+
+        for (size_t j = 0; j < 4; ++j) {
+            size_t r = (c + 4 - j) % 4;
+            u8 f = Fault::LAYOUT.propagation[j];
+
+            array<u8, 256> eps_of {}; // eps such that f * eps = d
+            for (int eps = 0; eps < 256; ++eps) eps_of[gf_mul(f, eps)] = eps;
+
+            auto const& rows = stage1_results[j];
+
+            for (size_t i = 0; i < rows.size(); ++i) {
+                auto contribution = get_key_contribution(rows[i], j);
+                auto k9imc = unload(contribution.k9imc);
+                z_parts[j].push_back((uint32_t) k9imc[4 + (c + 3) % 4] | (uint32_t) k9imc[8 + (c + 2) % 4] << 8 | (uint32_t) k9imc[12 + (c + 1) % 4] << 16);
+
+                if (j == 0) continue;
+
+                // InvMixColumns(S9) = InvMixColumns(invS(invSR(Y xor K10))), correct in column j
+                auto a  = unload(_mm_aesimc_si128(_mm_aesdeclast_si128(_mm_xor_si128(y , contribution.k10), _mm_setzero_si128())))[4*j + r];
+                auto a_ = unload(_mm_aesimc_si128(_mm_aesdeclast_si128(_mm_xor_si128(y_, contribution.k10), _mm_setzero_si128())))[4*j + r];
+
+                for (int z = 0; z < 256; ++z) {
+                    u8 eps = eps_of[INV_SBOX[a ^ z] ^ INV_SBOX[a_ ^ z]];
+                    solutions[j][eps].push_back({(uint16_t) i, (u8) z});
+                }
+            }
+        }
+
+        auto const& [rows1, rows2, rows3, rows4] = stage1_results;
+
+        // `num_threads` rather than `omp_set_num_threads` so that concurrent callers don't step on each other
+        #pragma omp parallel num_threads(threads)
+        {
+            // entries packed as key << 40 | index << 20 | index
+            vector<uint64_t> left, right;
+
+            #pragma omp for schedule(dynamic) nowait
+            for (int eps = first; eps < last; ++eps) {
+                if (!admissible_eps[eps]) continue;
+                if (control != nullptr && !control->claim(eps)) continue;
+                tracing::Span span("join eps");
+
+                left.clear();
+                right.clear();
+
+                for (size_t i1 = 0; i1 < rows1.size(); ++i1)
+                    for (auto [i2, z2] : solutions[1][eps]) {
+                        uint64_t key = z_parts[0][i1] ^ z_parts[1][i2] ^ z2;
+                        left.push_back(key << 40 | (uint64_t) i1 << 20 | i2);
+                    }
+
+                for (auto [i3, z3] : solutions[2][eps])
+                    for (auto [i4, z4] : solutions[3][eps]) {
+                        uint64_t key = z_parts[2][i3] ^ z_parts[3][i4] ^ (uint32_t) z3 << 8 ^ (uint32_t) z4 << 16;
+                        right.push_back(key << 40 | (uint64_t) i3 << 20 | i4);
+                    }
+
+                sort(left.begin(), left.end());
+                sort(right.begin(), right.end());
+
+                // merge, every left entry matching every right entry of the same key
+                auto l = left.begin(), r = right.begin();
+                while (l != left.end() && r != right.end()) {
+                    uint64_t key = *l >> 40;
+
+                    if (key < (*r >> 40)) { ++l; continue; }
+                    if (key > (*r >> 40)) { ++r; continue; }
+
+                    auto r_end = r;
+                    while (r_end != right.end() && (*r_end >> 40) == key) ++r_end;
+
+                    for (; l != left.end() && (*l >> 40) == key; ++l)
+                        for (auto m = r; m != r_end; ++m) {
+                            constexpr uint64_t INDEX_MASK = (1 << 20) - 1;
+
+                            FlatState K10 = make_key(rows1[(*l >> 20) & INDEX_MASK], rows2[*l & INDEX_MASK],
+                                                     rows3[(*m >> 20) & INDEX_MASK], rows4[*m & INDEX_MASK]);
+
+                            if (check_partial_decryption(Y, Y_, K10, fault_mask)) found(K10);
+                        }
+
+                    r = r_end;
+                }
+
+                if (control != nullptr) control->finish(eps);
+            }
+
+            tracing::Span barrier("barrier");
+            #pragma omp barrier
+        }
+    }
+
+    template<typename Found>
+    inline void join(FlatState const& Y, FlatState const& Y_, size_t fault_position, array<vector<Row>, 4> const& stage1_results, int threads, FaultModel const& model, Control* control, Found const& found) {
+        dispatch_fault(fault_position, [&](auto fault) { join(fault, Y, Y_, stage1_results, threads, model, control, found); });
+    }
+
+    /**
+     * @brief Same results as `reduction`, through a join on the round 8 fault equations instead of a 2^32 sweep.
+     * 
+     * Let c be the differential column and r_j = (c - j) mod 4. Once the first stage holds, the faulty column of the
+     * round 8 output state S8 only depends on the key through:
+     * 
+     *      delta S8[r_j][c] = invS(a_j + z_j) + invS(a'_j + z_j) = f_{r_j} * eps       (j = 0 .. 3)
+     * 
+     * where a_j, a'_j are bytes of InvMixColumns(S9) only depending on the antidiagonal j of K10,
+     * z_j the byte of InvMixColumns(K9) in column j, and f the MixColumns factors of the fault row.
+     * For j = 1, 2, 3, z_j is linear in K10: the xor of one contribution per antidiagonal.
+     * 
+     * For each eps, the equations j = 1, 2, 3 thus split into a key computed from antidiagonals (1, 2) and
+     * one computed from antidiagonals (3, 4), equal if and only if the 3 equations hold. Matching those keys
+     * (sorted lists merge) leaves ~2^16 candidates, then checked with `check_partial_decryption`.
+     * Work is about 2^25 instead of 2^32, and shrinks with the number of eps admitted by the fault model.
+     * 
+     * @param Y regular ciphertext
+     * @param Y_ faulted ciphertext
+     * @param fault_position
+     * @param stage1_results
+     * @param threads number of OpenMP threads used for the search
+     * @param model fault model, only its admissible eps are joined
+     * @param control optional cancellation and progress, in values of eps
+     * @return vector<FlatState> 
+     */
+    inline vector<FlatState> join_reduction(FlatState const& Y, FlatState const& Y_, size_t fault_position, array<vector<Row>, 4> const& stage1_results, int threads = THREADS, FaultModel const& model = {}, Control* control = nullptr) {
+        vector<FlatState> found_keys;
+        join(Y, Y_, fault_position, stage1_results, threads, model, control, collect(found_keys, control));
+
+        return found_keys;
+    }
+
+    /**
+     * @brief The search of `settings.engine`, calling `found(K10)` from the searching threads for every key found.
+     * 
+     * The join solves for the one difference of a single byte fault: multi-byte faults, whose candidates are up to 2^32
+     * times more, always go through the range sweep.
+     */
+    template<typename Fault, typename Found>
+    inline void search(Fault fault, FlatState const& Y, FlatState const& Y_, array<vector<Row>, 4> const& stage1_results, Settings const& settings, FaultModel const& model, Control* control, Found const& found) {
+        if constexpr (Fault::LAYOUT.single_byte) {
+            if (settings.engine == Engine::JOIN) return join(fault, Y, Y_, stage1_results, settings.threads, model, control, found);
+            if (settings.engine == Engine::SWEEP) return sweep(fault, Y, Y_, stage1_results, settings, control, KeyRelation(), found);
+        }
+
+        sweep_range(fault, Y, Y_, stage1_results, settings, control, KeyRelation(), found);
+    }
+
+    /**
+     * @brief Run the second stage with the engine, kernel, threads and schedule of `settings`,
+     * keeping the keys whose fault fits `model`. The keys found are incomplete if `control` gets cancelled.
+     */
+    inline vector<FlatState> run(FlatState const& Y, FlatState const& Y_, size_t fault_position, array<vector<Row>, 4> const& stage1_results, Settings const& settings, FaultModel const& model = {}, Control* control = nullptr) {
+        vector<FlatState> keys;
+        dispatch_fault(fault_position, [&](auto fault) { search(fault, Y, Y_, stage1_results, settings, model, control, collect(keys, control)); });
+
+        keys.erase(remove_if(keys.begin(), keys.end(), [&](FlatState const& K10) {
+            return !model.admits(Y, Y_, K10, fault_position);
+        }), keys.end());
+
+        return keys;
+    }
+
+    /**
+     * @brief `run` for a fault described by `fault`. Multi-byte faults only fit the arbitrary fault model: each of
+     * their keys is kept.
+     */
+    inline vector<FlatState> run(FlatState const& Y, FlatState const& Y_, FaultDescriptor const& fault, array<vector<Row>, 4> const& stage1_results, Settings const& settings, FaultModel const& model = {}, Control* control = nullptr) {
+        if (make_layout(fault).single_byte) {
+            size_t fault_position = 0;
+            while (!(fault.bytes >> fault_position & 1)) ++fault_position;
+
+            return run(Y, Y_, fault_position, stage1_results, settings, model, control);
+        }
+
+        vector<FlatState> keys;
+        dispatch_fault(fault, [&](auto type) { search(type, Y, Y_, stage1_results, settings, FaultModel(), control, collect(keys, control)); });
+
+        return keys;
+    }
+
+    /**
+     * @brief Number of keys `run` would return, counted without storing them nor any critical section.
+     */
+    inline size_t count(FlatState const& Y, FlatState const& Y_, size_t fault_position, array<vector<Row>, 4> const& stage1_results, Settings const& settings, FaultModel const& model = {}) {
+        atomic<size_t> survivors {0};
+        auto found = [&](FlatState const& K10) {
+            if (model.admits(Y, Y_, K10, fault_position)) ++survivors;
+        };
+
+        dispatch_fault(fault_position, [&](auto fault) { search(fault, Y, Y_, stage1_results, settings, model, nullptr, found); });
+
+        return survivors;
+    }
+
+    /**
+     * @brief Run the second stage with `engine`.
+     */
+    inline vector<FlatState> reduction(FlatState const& Y, FlatState const& Y_, size_t fault_position, array<vector<Row>, 4> const& stage1_results, Engine engine, int threads = THREADS) {
+        Settings settings;
+        settings.engine = engine;
+        settings.threads = threads;
+
+        return run(Y, Y_, fault_position, stage1_results, settings);
+    }
+}
+
+namespace third_stage {
+    /**
+     * @brief Find the key used to encrypt `plaintext`.
+     * 
+     * The candidates go 4 at a time, their key schedules derived together with `method` and their decryptions
+     * interleaved, the initial key coming with the schedule.
+     * 
+     * @param ciphertext 
+     * @param plaintext 
+     * @param stage2_results 
+     * @param method key inversion of the key schedules
+     * @return vector<FlatState> key
+     */
+    inline vector<FlatState> reduction(FlatState const& ciphertext, FlatState const& plaintext, vector<FlatState> const& stage2_results, KeyInversion method = KeyInversion::AESKEYGENASSIST) {
+        vector<FlatState> valid_keys;
+        __m128i y = load(ciphertext), x = load(plaintext);
+
+        for (size_t i = 0; i < stage2_results.size(); i += 4) {
+            // the last batch is padded with its last key
+            size_t count = min<size_t>(4, stage2_results.size() - i);
+
+            __m128i k10[4], keys[4][11], decrypted[4];
+            for (size_t b = 0; b < 4; ++b) k10[b] = load(stage2_results[i + min(b, count - 1)]);
+
+            key_schedules_from_last_round_key_x4(k10, keys, method);
+            decrypt_x4(y, keys, decrypted);
+
+            for (size_t b = 0; b < count; ++b)
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(decrypted[b], x)) == 0xffff) valid_keys.push_back(unload(keys[b][0]));
+        }
+        
+        return valid_keys;
+    }
 }
\ No newline at end of file
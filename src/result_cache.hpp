@@ -0,0 +1,272 @@
+#pragma once
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "reductions.hpp"
+
+using namespace std;
+
+/**
+ * Persistent cache of second stage results.
+ *
+ * The round 10 key candidates of a capture only depend on the ciphertexts, the fault positions, the fault model and
+ * the key hints: the engine, kernel and thread settings give the same set. The cache maps a fingerprint of those
+ * inputs to the candidates, so a resubmitted capture skips the first and second stages; the plaintext, if any, is
+ * checked afterwards as usual.
+ *
+ * Each entry is a file named after the 64 bits hash of its fingerprint, holding the fingerprint itself (hash
+ * collisions are thus told apart) and the candidates:
+ *
+ *      magic "ASFARES\0" (8) | version (u32) | reserved (u32) | fingerprint size (u64) | key count (u64) | fingerprint | keys (16 each)
+ *
+ * Entries are written to a temporary file then renamed, so concurrent runs sharing the directory never read a partial
+ * one. Hits refresh the modification time of their entry, and storing evicts the least recently used entries beyond
+ * the size limit.
+ */
+namespace result_cache {
+    constexpr char MAGIC[8] = {'A', 'S', 'F', 'A', 'R', 'E', 'S', '\0'};
+    constexpr uint32_t VERSION = 1;
+    constexpr char SUFFIX[] = ".k10";
+    constexpr uint64_t DEFAULT_MAX_SIZE = (uint64_t) 64 << 20;
+    constexpr uint64_t MAX_KEYS = (uint64_t) 1 << 24;      // far beyond any second stage result, guards against corrupt entries
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t fingerprint_size;
+        uint64_t key_count;
+    };
+
+    static_assert(sizeof(Header) == 32, "result cache header must be 32 bytes");
+
+    /**
+     * @brief Canonical bytes of the inputs determining the second stage results of a capture.
+     */
+    inline string fingerprint(FlatState const& Y, FlatState const& Y_, vector<size_t> fault_positions, KeyHints const& hints, FaultModel const& model) {
+        string bytes;
+        auto append = [&](void const* data, size_t size) { bytes.append((char const*) data, size); };
+        auto append_bits = [&](bitset<256> const& bits) {
+            for (size_t i = 0; i < 256; i += 8) {
+                u8 byte = 0;
+                for (size_t b = 0; b < 8; ++b) byte |= bits[i + b] << b;
+                bytes.push_back((char) byte);
+            }
+        };
+
+        append(Y.data(), 16);
+        append(Y_.data(), 16);
+
+        sort(fault_positions.begin(), fault_positions.end());
+        bytes.push_back((char) fault_positions.size());
+        for (size_t position : fault_positions) bytes.push_back((char) position);
+
+        append_bits(model.differences);
+        bytes.push_back((char) (model.stuck_value < 0 ? 0 : 1));
+        bytes.push_back((char) (model.stuck_value < 0 ? 0 : model.stuck_value));
+        bytes.push_back((char) model.at_sbox_output);
+
+        for (auto const& allowed : hints.allowed_bytes) append_bits(allowed);
+
+        auto last_round_keys = hints.last_round_keys;
+        sort(last_round_keys.begin(), last_round_keys.end());
+        last_round_keys.erase(unique(last_round_keys.begin(), last_round_keys.end()), last_round_keys.end());
+        for (auto const& K10 : last_round_keys) append(K10.data(), 16);
+
+        return bytes;
+    }
+
+    // FNV-1a
+    inline uint64_t hash(string const& bytes) {
+        uint64_t h = 0xcbf29ce484222325;
+        for (char c : bytes) {
+            h ^= (u8) c;
+            h *= 0x100000001b3;
+        }
+
+        return h;
+    }
+
+    /**
+     * @brief Default cache directory: `$XDG_CACHE_HOME/aes-single-fault-attack/results`, `~/.cache/...` by default.
+     */
+    inline string default_directory() {
+        char const* cache_home = getenv("XDG_CACHE_HOME");
+        char const* home = getenv("HOME");
+
+        string directory = (cache_home != nullptr && *cache_home != '\0') ? string(cache_home)
+                         : string(home != nullptr ? home : ".") + "/.cache";
+
+        return directory + "/aes-single-fault-attack/results";
+    }
+
+    class Cache {
+    public:
+        /**
+         * @param directory where the entries live, created on the first store
+         * @param max_size total size of the entries beyond which the least recently used ones are evicted
+         */
+        explicit Cache(string directory = default_directory(), uint64_t max_size = DEFAULT_MAX_SIZE)
+            : root(move(directory)), max_size(max_size) {}
+
+        /**
+         * @brief Candidates stored for `fingerprint`, into `keys`.
+         *
+         * @return false if there are none (missing, unreadable or colliding entry)
+         */
+        bool lookup(string const& fingerprint, vector<FlatState>& keys) const {
+            string path = entry_path(fingerprint);
+            ifstream file(path, ios::binary);
+            if (!file) return false;
+
+            Header header;
+            if (!file.read((char*) &header, sizeof(header)) || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+                || header.version != VERSION || header.fingerprint_size != fingerprint.size() || header.key_count > MAX_KEYS) return false;
+
+            string stored(fingerprint.size(), '\0');
+            if (!file.read(&stored[0], stored.size()) || stored != fingerprint) return false;
+
+            vector<FlatState> found(header.key_count);
+            if (!file.read((char*) found.data(), found.size() * sizeof(FlatState))) return false;
+
+            keys = move(found);
+
+            // most recently used
+            touch(path);
+
+            return true;
+        }
+
+        /**
+         * @brief Store `keys` for `fingerprint`, then evict the least recently used entries beyond the size limit.
+         *
+         * @return false on failure, `error` telling why
+         */
+        bool store(string const& fingerprint, vector<FlatState> const& keys, string& error) {
+            if (!make_directories(error)) return false;
+
+            string path = entry_path(fingerprint);
+            // unique in the directory whatever the threads and processes storing at the same time, and not an entry
+            string temporary = root + "/store.XXXXXX";
+            int fd = mkstemp(&temporary[0]);
+            if (fd < 0) {
+                error = root + ": " + strerror(errno);
+                return false;
+            }
+
+            Header header {};
+            memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = VERSION;
+            header.fingerprint_size = fingerprint.size();
+            header.key_count = keys.size();
+
+            string bytes((char const*) &header, sizeof(header));
+            bytes.append(fingerprint);
+            bytes.append((char const*) keys.data(), keys.size() * sizeof(FlatState));
+
+            bool written = true;
+            for (size_t offset = 0; written && offset < bytes.size();) {
+                ssize_t n = write(fd, bytes.data() + offset, bytes.size() - offset);
+                if (n < 0 && errno == EINTR) continue;
+                written = n > 0;
+                if (written) offset += n;
+            }
+
+            if (close(fd) != 0 || !written) {
+                remove(temporary.c_str());
+                error = temporary + ": write error";
+                return false;
+            }
+
+            if (rename(temporary.c_str(), path.c_str()) != 0) {
+                error = path + ": " + strerror(errno);
+                remove(temporary.c_str());
+                return false;
+            }
+
+            evict();
+
+            return true;
+        }
+
+        /**
+         * @brief Remove the least recently used entries until they fit in the size limit.
+         */
+        void evict() const {
+            struct Entry {
+                string path;
+                uint64_t size;
+                timespec modified;
+            };
+
+            vector<Entry> entries;
+            uint64_t total = 0;
+
+            DIR* directory = opendir(root.c_str());
+            if (directory == nullptr) return;
+
+            while (dirent* item = readdir(directory)) {
+                string name = item->d_name;
+                if (name.size() <= strlen(SUFFIX) || name.compare(name.size() - strlen(SUFFIX), string::npos, SUFFIX) != 0) continue;
+
+                string path = root + "/" + name;
+                struct stat st;
+                if (stat(path.c_str(), &st) != 0) continue;
+
+                entries.push_back({path, (uint64_t) st.st_size, st.st_mtim});
+                total += st.st_size;
+            }
+            closedir(directory);
+
+            sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b) {
+                return (a.modified.tv_sec != b.modified.tv_sec) ? a.modified.tv_sec < b.modified.tv_sec : a.modified.tv_nsec < b.modified.tv_nsec;
+            });
+
+            for (auto const& entry : entries) {
+                if (total <= max_size) break;
+                if (remove(entry.path.c_str()) == 0) total -= entry.size;
+            }
+        }
+
+        string const& directory() const { return root; }
+
+    private:
+        string root;
+        uint64_t max_size;
+
+        string entry_path(string const& fingerprint) const {
+            char name[17];
+            snprintf(name, sizeof(name), "%016llx", (unsigned long long) hash(fingerprint));
+
+            return root + "/" + name + SUFFIX;
+        }
+
+        bool make_directories(string& error) const {
+            string path = root + "/";
+            for (size_t slash = path.find('/', 1); slash != string::npos; slash = path.find('/', slash + 1))
+                if (mkdir(path.substr(0, slash).c_str(), 0755) != 0 && errno != EEXIST) {
+                    error = path.substr(0, slash) + ": " + strerror(errno);
+                    return false;
+                }
+
+            return true;
+        }
+
+        static void touch(string const& path) {
+            utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+        }
+    };
+}
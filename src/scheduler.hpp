@@ -0,0 +1,348 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "async_attack.hpp"
+#include "tuning.hpp"
+
+using namespace std;
+
+/**
+ * Multi-tenant attack scheduling on one shared worker pool.
+ *
+ * Rather than each attack spreading its own OpenMP team over the whole machine, a `Scheduler` runs the attacks of
+ * all its clients on a fixed pool of single threaded workers, pinned one per CPU. The second stage of every job is cut
+ * into chunks (rows of the first antidiagonal for the sweep, admissible fault differences for the join), and each
+ * free worker takes the next chunk of the job having received the least worker time relative to its priority weight
+ * (stride scheduling). Jobs thus share the pool fairly whatever their size: a quick, fully triaged capture completes
+ * in a few chunks even while a long unknown-position sweep runs, and `Priority::HIGH` jobs get a larger share.
+ */
+namespace scheduler {
+    using async_attack::Attack;
+    using async_attack::Priority;
+    using async_attack::Request;
+    using async_attack::Result;
+    using async_attack::State;
+
+    constexpr size_t SWEEP_ROWS_PER_CHUNK = 1;     // ~2^24 candidate checks
+    constexpr size_t JOIN_EPS_PER_CHUNK = 8;
+
+    /**
+     * @brief Share of the workers of a job of priority `priority`, relative to the other jobs.
+     */
+    inline double weight(Priority priority) {
+        switch (priority) {
+            case Priority::LOW:    return 1;
+            case Priority::NORMAL: return 4;
+            case Priority::HIGH:   return 16;
+        }
+
+        return 4;
+    }
+
+    class Scheduler {
+    public:
+        /**
+         * @param workers size of the pool, by default one per physical core (hyperthreads share the AES units)
+         * @param pin whether to pin worker i to CPU i
+         */
+        explicit Scheduler(int workers = tuning::physical_cores(), bool pin = true) {
+            for (int i = 0; i < workers; ++i)
+                threads.emplace_back([this, i, pin] {
+                    if (pin) {
+                        cpu_set_t cpus;
+                        CPU_ZERO(&cpus);
+                        CPU_SET(i % omp_get_num_procs(), &cpus);
+                        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+                    }
+
+                    work();
+                });
+        }
+
+        /**
+         * @brief Wait for the jobs already submitted, then stop the workers.
+         */
+        ~Scheduler() {
+            {
+                lock_guard<mutex> lock(jobs_mutex);
+                stopping = true;
+            }
+            changed.notify_all();
+
+            for (auto& thread : threads) thread.join();
+        }
+
+        Scheduler(Scheduler const&) = delete;
+        Scheduler& operator=(Scheduler const&) = delete;
+
+        /**
+         * @brief Queue `request`. Its `settings.engine` and kernel are honoured, its threads and
+         * schedule chunk are not: each chunk runs on a single worker. Progress is counted in chunks.
+         *
+         * A request without fault position is not queued, its future holding an `invalid_argument` right away. A job
+         * whose stages throw (say, `bad_alloc`) fails through its future with that exception.
+         */
+        Attack submit(Request request, Priority priority = Priority::NORMAL) {
+            auto job = make_shared<Job>();
+            job->request = move(request);
+            job->request.settings.threads = 1;
+            job->request.settings.chunk = 0;
+            job->state = make_shared<State>();
+            job->state->priority = priority;
+            job->weight = weight(priority);
+
+            Attack attack(job->state, job->result.get_future());
+
+            if (job->request.fault_positions.empty()) {
+                job->state->finished = true;
+                job->result.set_exception(make_exception_ptr(invalid_argument("attack request without fault position")));
+                return attack;
+            }
+
+            {
+                lock_guard<mutex> lock(jobs_mutex);
+                // joining at the current virtual time, a new job neither starves nor gets starved by the older ones
+                job->pass = virtual_time;
+                jobs.push_back(job);
+            }
+            changed.notify_one();
+
+            return attack;
+        }
+
+    private:
+        // rows [begin, end) of the first antidiagonal for the sweep, admissible eps [begin, end) for the join
+        struct Chunk {
+            size_t fault_position;
+            size_t begin, end;
+        };
+
+        struct Job {
+            Request request;
+            shared_ptr<State> state;
+            promise<Result> result;
+            double weight = 1;
+            double pass = 0;                    // worker seconds received, over `weight`
+
+            bool stage1_started = false;
+            bool stage1_done = false;
+            array<vector<Row>, 4> stage1_results;
+            vector<int> eps;
+            vector<Chunk> chunks;
+            size_t next_chunk = 0;
+            size_t running = 0;
+            vector<FlatState> keys;
+            exception_ptr error;                // of the first stage or chunk that threw, the job then cancelled
+
+            bool cancelled() const { return state->control.cancelled; }
+            bool runnable(bool cancelled) const { return !cancelled && (!stage1_started || (stage1_done && next_chunk < chunks.size())); }
+            bool complete(bool cancelled) const { return running == 0 && (cancelled || (stage1_done && next_chunk == chunks.size())); }
+        };
+
+        vector<thread> threads;
+        list<shared_ptr<Job>> jobs;             // in submission order
+        mutex jobs_mutex;
+        condition_variable changed;
+        double virtual_time = 0;
+        bool stopping = false;
+
+        void work() {
+            while (true) {
+                shared_ptr<Job> job;
+                bool stage1 = false;
+                Chunk chunk {};
+
+                // jobs taken out of the queue, finished once the lock is released
+                vector<pair<shared_ptr<Job>, bool>> completed;
+
+                {
+                    unique_lock<mutex> lock(jobs_mutex);
+
+                    while (true) {
+                        for (auto it = jobs.begin(); it != jobs.end();) {
+                            // read once, a job getting cancelled in between would be neither complete nor runnable
+                            bool cancelled = (*it)->cancelled();
+
+                            // done jobs, cancelled ones not waiting for their remaining chunks
+                            if ((*it)->complete(cancelled)) {
+                                completed.emplace_back(*it, cancelled);
+                                it = jobs.erase(it);
+                                continue;
+                            }
+
+                            // least virtual time first, ties going to the oldest job
+                            if ((*it)->runnable(cancelled) && (!job || (*it)->pass < job->pass)) job = *it;
+                            ++it;
+                        }
+
+                        if (job || !completed.empty() || (stopping && jobs.empty())) break;
+                        tracing::Span idle("idle");
+                        changed.wait(lock);
+                    }
+
+                    if (job) {
+                        virtual_time = job->pass;
+                        ++job->running;
+
+                        if (!job->stage1_started) {
+                            job->stage1_started = true;
+                            stage1 = true;
+                        } else {
+                            chunk = job->chunks[job->next_chunk++];
+                        }
+                    }
+                }
+
+                // the third stages don't hold up the chunk dispatch of the other workers
+                for (auto const& [done, cancelled] : completed) finish(done, cancelled);
+
+                if (!job) {
+                    if (completed.empty()) return;
+                    continue;
+                }
+
+                auto start = chrono::steady_clock::now();
+                vector<FlatState> keys;
+                exception_ptr error;
+                {
+                    tracing::Span span(stage1 ? "stage1" : "chunk");
+                    try {
+                        if (stage1)
+                            run_stage1(*job);
+                        else
+                            keys = run_chunk(*job, chunk);
+                    } catch (...) {
+                        error = current_exception();
+                    }
+                }
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+                {
+                    lock_guard<mutex> lock(jobs_mutex);
+                    --job->running;
+                    job->pass += seconds / job->weight;
+
+                    if (!error) {
+                        try {
+                            job->keys.insert(job->keys.end(), keys.begin(), keys.end());
+                        } catch (...) {
+                            error = current_exception();
+                        }
+                    }
+
+                    // the job fails as a whole, its other chunks dropped, the worker going on with the other jobs
+                    if (error) {
+                        if (!job->error) job->error = error;
+                        job->state->control.cancelled = true;
+                    }
+
+                    if (stage1) job->stage1_done = true;
+                    else ++job->state->control.done;
+                }
+                changed.notify_all();
+            }
+        }
+
+        /**
+         * @brief Run the first stage of `job` and cut its second stage into chunks.
+         */
+        static void run_stage1(Job& job) {
+            auto const& request = job.request;
+
+            // the first stage deltas depend on the fault row, only restricted for a known position
+            auto stage1_model = (request.fault_positions.size() == 1) ? request.model : FaultModel();
+            job.stage1_results = first_stage::reduction(request.regular, request.faulted, request.fault_positions.front(), request.hints, stage1_model);
+
+            auto admissible_eps = request.model.mix_columns_input_differences();
+            for (int eps = 1; eps < 256; ++eps)
+                if (admissible_eps[eps]) job.eps.push_back(eps);
+
+            bool join = request.settings.engine == second_stage::Engine::JOIN;
+            size_t units = join ? job.eps.size() : job.stage1_results[0].size();
+            size_t units_per_chunk = join ? JOIN_EPS_PER_CHUNK : SWEEP_ROWS_PER_CHUNK;
+
+            for (size_t fault_position : request.fault_positions)
+                for (size_t begin = 0; begin < units; begin += units_per_chunk)
+                    job.chunks.push_back({fault_position, begin, min(begin + units_per_chunk, units)});
+
+            job.state->control.start(job.chunks.size());
+        }
+
+        /**
+         * @brief Second stage keys of `chunk` whose fault fits the model of `job`.
+         */
+        static vector<FlatState> run_chunk(Job const& job, Chunk const& chunk) {
+            auto const& request = job.request;
+            vector<FlatState> keys;
+
+            if (request.settings.engine == second_stage::Engine::JOIN) {
+                // a fault at the MixColumns input whose differences are the chunk eps joins exactly those eps
+                FaultModel chunk_model;
+                chunk_model.at_sbox_output = true;
+                chunk_model.differences.reset();
+                for (size_t i = chunk.begin; i < chunk.end; ++i) chunk_model.differences.set(job.eps[i]);
+
+                keys = second_stage::join_reduction(request.regular, request.faulted, chunk.fault_position, job.stage1_results, 1, chunk_model);
+            } else {
+                auto slice = job.stage1_results;
+                slice[0].assign(job.stage1_results[0].begin() + chunk.begin, job.stage1_results[0].begin() + chunk.end);
+
+                keys = second_stage::reduction(request.regular, request.faulted, chunk.fault_position, slice, request.settings);
+            }
+
+            keys.erase(remove_if(keys.begin(), keys.end(), [&](FlatState const& K10) {
+                return !request.model.admits(request.regular, request.faulted, K10, chunk.fault_position);
+            }), keys.end());
+
+            return keys;
+        }
+
+        /**
+         * @brief Run the third stage of the complete `job` and hand over its result, or the exception of its
+         * first stage, chunks or third stage.
+         */
+        static void finish(shared_ptr<Job> const& job, bool cancelled) {
+            auto const& request = job->request;
+            Result result;
+            exception_ptr error = job->error;
+
+            if (!error) {
+                try {
+                    if (cancelled)
+                        result.cancelled = true;
+                    else if (request.last_round_keys)
+                        result.keys = job->keys;
+                    else if (request.has_plaintext)
+                        result.keys = third_stage::reduction(request.regular, request.plaintext, job->keys, request.settings.inversion);
+                    else
+                        for (auto const& K10 : job->keys)
+                            result.keys.push_back(get_initial_key(K10, request.settings.inversion));
+                } catch (...) {
+                    error = current_exception();
+                }
+            }
+
+            job->state->finished = true;
+            if (error) job->result.set_exception(error);
+            else job->result.set_value(move(result));
+        }
+    };
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "reductions.hpp"
+
+using namespace std;
+
+/**
+ * Incremental attack sessions.
+ *
+ * A session persists the round 10 key candidates surviving every capture seen so far, so that a new capture
+ * only costs a `check_partial_decryption` per stored candidate instead of a whole second stage search.
+ *
+ * Session file layout (integers little endian):
+ *
+ *      magic "ASFASES\0" (8) | version (u32) | initialized (u32) | captures (u64) | pairs (u64) | key count (u64) | keys (16 each)
+ */
+namespace session {
+    constexpr char MAGIC[8] = {'A', 'S', 'F', 'A', 'S', 'E', 'S', '\0'};
+    constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t initialized;
+        uint64_t captures;
+        uint64_t pairs;
+        uint64_t key_count;
+    };
+
+    static_assert(sizeof(Header) == 40, "session file header must be 40 bytes");
+
+    struct Session {
+        bool initialized = false;       // false until the first capture, when every key is still a candidate
+        uint64_t captures = 0;          // number of fault captures applied
+        uint64_t pairs = 0;             // number of plaintext / ciphertext pairs applied
+        vector<FlatState> last_round_keys;
+    };
+
+    /**
+     * @brief Load the session stored at `path`. A missing file yields a fresh session.
+     *
+     * @return false on failure, `error` telling why
+     */
+    inline bool load(string const& path, Session& session, string& error) {
+        session = Session();
+
+        ifstream file(path, ios::binary);
+        if (!file) return true;
+
+        Header header;
+        if (!file.read((char*) &header, sizeof(header)) || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            error = path + ": not a session file";
+            return false;
+        }
+        if (header.version != VERSION) {
+            error = path + ": unsupported session file version";
+            return false;
+        }
+
+        // the key count of a corrupt header must not size the allocation
+        file.seekg(0, ios::end);
+        uint64_t key_bytes = (uint64_t) file.tellg() - sizeof(header);
+        file.seekg(sizeof(header));
+        if (header.key_count > key_bytes / sizeof(FlatState)) {
+            error = path + ": truncated session file";
+            return false;
+        }
+
+        session.initialized = header.initialized;
+        session.captures = header.captures;
+        session.pairs = header.pairs;
+        session.last_round_keys.resize(header.key_count);
+
+        if (!file.read((char*) session.last_round_keys.data(), header.key_count * sizeof(FlatState))) {
+            error = path + ": truncated session file";
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Store `session` at `path`, atomically replacing the previous file.
+     *
+     * @return false on failure, `error` telling why
+     */
+    inline bool save(string const& path, Session const& session, string& error) {
+        string temporary = path + ".tmp";
+
+        {
+            ofstream file(temporary, ios::binary | ios::trunc);
+
+            Header header {};
+            memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = VERSION;
+            header.initialized = session.initialized;
+            header.captures = session.captures;
+            header.pairs = session.pairs;
+            header.key_count = session.last_round_keys.size();
+
+            file.write((char const*) &header, sizeof(header));
+            file.write((char const*) session.last_round_keys.data(), session.last_round_keys.size() * sizeof(FlatState));
+
+            if (!file.flush()) {
+                error = temporary + ": write error";
+                return false;
+            }
+        }
+
+        if (rename(temporary.c_str(), path.c_str()) != 0) {
+            error = path + ": " + strerror(errno);
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Refine `session` with a fault capture whose fault lies somewhere in `fault_positions`.
+     *
+     * The first capture of a session runs the first and second stages (all the positions must then share
+     * the same differential column), later ones only re-check the stored candidates.
+     * Candidates whose fault doesn't fit `model`, or missing from `hints.last_round_keys` if any, are dropped.
+     */
+    inline void add_capture(Session& session, FlatState const& Y, FlatState const& Y_, vector<size_t> const& fault_positions, KeyHints const& hints = {}, second_stage::Settings const& settings = {}, FaultModel const& model = {}) {
+        if (!session.initialized) {
+            // the first stage deltas depend on the fault row, only restricted for a known position
+            auto stage1_model = (fault_positions.size() == 1) ? model : FaultModel();
+            auto stage1_results = first_stage::reduction(Y, Y_, fault_positions.front(), hints, stage1_model);
+
+            // the first stage only knows the hinted keys per antidiagonal, mixing several of them
+            auto const& hinted = hints.last_round_keys;
+            for (size_t fault_position : fault_positions) {
+                auto keys = second_stage::run(Y, Y_, fault_position, stage1_results, settings, model);
+                if (!hinted.empty())
+                    keys.erase(remove_if(keys.begin(), keys.end(), [&](FlatState const& K10) {
+                        return find(hinted.begin(), hinted.end(), K10) == hinted.end();
+                    }), keys.end());
+
+                session.last_round_keys.insert(session.last_round_keys.end(), keys.begin(), keys.end());
+            }
+
+            session.initialized = true;
+        } else {
+            vector<int> fault_masks;
+            for (size_t fault_position : fault_positions)
+                fault_masks.push_back(get_fault_mask(fault_position));
+
+            auto& keys = session.last_round_keys;
+            keys.erase(remove_if(keys.begin(), keys.end(), [&](FlatState const& K10) {
+                for (size_t i = 0; i < fault_positions.size(); ++i)
+                    if (check_partial_decryption(Y, Y_, K10, fault_masks[i]) && model.admits(Y, Y_, K10, fault_positions[i])) return false;
+                return true;
+            }), keys.end());
+        }
+
+        ++session.captures;
+    }
+
+    /**
+     * @brief Refine `session` with a known plaintext / ciphertext pair.
+     *
+     * @return false if the session holds no capture yet, the pair alone being unable to bound the key space
+     */
+    inline bool add_pair(Session& session, FlatState const& plaintext, FlatState const& ciphertext) {
+        if (!session.initialized) return false;
+
+        auto& keys = session.last_round_keys;
+        keys.erase(remove_if(keys.begin(), keys.end(), [&](FlatState const& K10) {
+            return decrypt(ciphertext, K10) != plaintext;
+        }), keys.end());
+
+        ++session.pairs;
+
+        return true;
+    }
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.hpp"
+#include "reductions.hpp"
+
+using namespace std;
+
+/**
+ * Statistical fault analysis, for campaigns yielding many faulted ciphertexts with no matching regular ones.
+ *
+ * The faults have to bias the round 10 `SubBytes` input (e.g. stuck-at or reset faults late in round 9), with an
+ * unknown but non uniform distribution. Under the right hypothesis k for the round 10 key byte j, the values
+ * INV_SBOX[C[j] xor k] then follow that distribution, while a wrong hypothesis sends them through the bijection
+ * v -> INV_SBOX[SBOX[v] xor d]. Any bias measure of the values themselves, like their square Euclidean imbalance,
+ * is blind to such a relabeling and scores every hypothesis the same: the hypotheses are thus scored on the
+ * Hamming weights of the values, which the bijection does not preserve and which reset, stuck-at and most physical
+ * faults skew.
+ *
+ * The ciphertexts are only read once: for each byte, the distribution of INV_SBOX[C[j] xor k] is a permutation of the
+ * histogram of C[j], so the 2^8 hypotheses are scored on the 16 histograms, whatever the number of ciphertexts.
+ */
+namespace statistical {
+    /**
+     * @brief Score of a hypothesis, from the Hamming weights of its values:
+     * 
+     *      SEI          square Euclidean imbalance of their distribution, i.e. its distance to that of uniform bytes,
+     *                   for any bias; a hypothesis mapping the faulted values to their complements often ties
+     *      LOW_WEIGHT   4 - their mean, for faults clearing bits (resets, stuck-at 0)
+     *      HIGH_WEIGHT  their mean - 4, for faults setting bits
+     */
+    enum class Metric { SEI, LOW_WEIGHT, HIGH_WEIGHT };
+
+    using Histogram = array<uint64_t, 256>;
+    using Histograms = array<Histogram, 16>;
+
+    /**
+     * @brief Histograms of each byte of the `count` ciphertexts at `ciphertexts`.
+     */
+    inline Histograms histograms(FlatState const* ciphertexts, size_t count, int threads = THREADS) {
+        Histograms total {};
+
+        #pragma omp parallel num_threads(threads)
+        {
+            // 32 bits counts flushed every 2^31 ciphertexts
+            constexpr size_t FLUSH = (size_t) 1 << 31;
+            array<array<uint32_t, 256>, 16> local {};
+
+            auto flush = [&] {
+                #pragma omp critical
+                {
+                    for (size_t j = 0; j < 16; ++j)
+                        for (size_t v = 0; v < 256; ++v) total[j][v] += local[j][v];
+                }
+                local = {};
+            };
+
+            size_t seen = 0;
+
+            #pragma omp for schedule(static) nowait
+            for (size_t i = 0; i < count; ++i) {
+                auto const& C = ciphertexts[i];
+                for (size_t j = 0; j < 16; ++j) ++local[j][C[j]];
+
+                if (++seen == FLUSH) {
+                    flush();
+                    seen = 0;
+                }
+            }
+
+            flush();
+        }
+
+        return total;
+    }
+
+    inline int hamming_weight(u8 x) {
+        return __builtin_popcount(x);
+    }
+
+    /**
+     * @brief Score of the 256 hypotheses on a key byte, given the `histogram` of the matching ciphertext byte.
+     */
+    inline array<double, 256> scores(Histogram const& histogram, Metric metric) {
+        array<double, 256> scores {};
+
+        uint64_t count = 0;
+        for (auto n : histogram) count += n;
+        if (count == 0) return scores;
+
+        // 256 times the distribution of the Hamming weight of a uniform byte
+        constexpr array<double, 9> BINOMIAL = {1, 8, 28, 56, 70, 56, 28, 8, 1};
+
+        for (int k = 0; k < 256; ++k) {
+            array<uint64_t, 9> weights {};
+            for (int v = 0; v < 256; ++v) weights[hamming_weight(v)] += histogram[SBOX[v] ^ k];
+
+            double score = 0;
+            for (int w = 0; w <= 8; ++w) {
+                double p = (double) weights[w] / count;
+                double d = p - BINOMIAL[w] / 256;
+
+                if (metric == Metric::SEI) score += d * d;
+                else score += p * (w - 4) * ((metric == Metric::HIGH_WEIGHT) ? 1 : -1);
+            }
+
+            scores[k] = score;
+        }
+
+        return scores;
+    }
+
+    struct ByteRanking {
+        u8 best;            // best hypothesis on the key byte
+        u8 second;          // runner-up
+        double score;       // score of the best hypothesis
+        double margin;      // SEI: score of the best over the runner-up, well above 1 when the byte was faulted
+                            // LOW_WEIGHT, HIGH_WEIGHT: score of the best minus the runner-up's, the scores being signed
+    };
+
+    /**
+     * @brief Rank the hypotheses on each round 10 key byte.
+     */
+    inline array<ByteRanking, 16> rank(Histograms const& histograms, Metric metric) {
+        array<ByteRanking, 16> rankings;
+
+        for (size_t j = 0; j < 16; ++j) {
+            auto s = scores(histograms[j], metric);
+
+            int best = max_element(s.begin(), s.end()) - s.begin();
+            int second = (best == 0) ? 1 : 0;
+            for (int k = 0; k < 256; ++k)
+                if (k != best && s[k] > s[second]) second = k;
+
+            double margin = s[best] - s[second];
+            if (metric == Metric::SEI) margin = (s[second] > 0) ? s[best] / s[second] : (s[best] > 0) ? HUGE_VAL : 0;
+            rankings[j] = {(u8) best, (u8) second, s[best], margin};
+        }
+
+        return rankings;
+    }
+
+    /**
+     * @brief Read-only memory mapped file of raw 16 bytes ciphertexts.
+     */
+    class Ciphertexts {
+    public:
+        /**
+         * @brief Map the ciphertext file at `path`.
+         *
+         * @return false on failure, `error()` telling why
+         */
+        bool open(string const& path) {
+            count = 0;
+
+            if (!file.open(path)) return fail(file.error());
+            if (file.size() == 0 || file.size() % sizeof(FlatState) != 0) return fail(path + ": size is not a positive multiple of 16 bytes");
+
+            count = file.size() / sizeof(FlatState);
+            last_error = "";
+
+            return true;
+        }
+
+        size_t size() const { return count; }
+        FlatState const* data() const { return (FlatState const*) file.data(); }
+
+        string const& error() const { return last_error; }
+
+    private:
+        MappedFile file;
+        size_t count = 0;
+        string last_error;
+
+        bool fail(string const& message) {
+            last_error = message;
+            return false;
+        }
+    };
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Per thread timeline tracing, exported in the Chrome trace event format (chrome://tracing, ui.perfetto.dev).
+ *
+ * While enabled, every `Span` records its name, start and duration into a ring buffer of the calling thread, allocated
+ * once on the thread's first span: recording is two clock reads and a store, without locks. A full buffer overwrites
+ * its oldest spans. Disabled, a `Span` costs a relaxed load.
+ *
+ * Spans cover the stages and I/O (through `profiling::Scope`), the rows of the second stage sweep, the fault
+ * differences of the join, the scheduler chunks, and the waits on `omp critical` sections and barriers, so load
+ * imbalance and synchronization show up as gaps and waits on the worker timelines.
+ */
+namespace tracing {
+    constexpr size_t DEFAULT_CAPACITY = (size_t) 1 << 16;      // spans per thread
+
+    struct Event {
+        char const* name;       // string literal or `intern`ed
+        int64_t start;          // ns since the tracing epoch
+        int64_t duration;       // ns
+    };
+
+    struct Buffer {
+        pid_t tid;
+        vector<Event> events;
+        uint64_t count = 0;     // spans recorded, the last `events.size()` of them kept
+
+        void push(Event const& event) {
+            events[count++ % events.size()] = event;
+        }
+    };
+
+    struct Registry {
+        atomic<bool> enabled {false};
+        size_t capacity = DEFAULT_CAPACITY;
+        chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+        mutex buffers_mutex;
+        vector<unique_ptr<Buffer>> buffers;
+        set<string> names;
+    };
+
+    inline Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    inline bool enabled() {
+        return registry().enabled.load(memory_order_relaxed);
+    }
+
+    /**
+     * @brief Start recording, with buffers of `capacity` spans per thread.
+     */
+    inline void enable(size_t capacity = DEFAULT_CAPACITY) {
+        auto& r = registry();
+        r.capacity = max(capacity, (size_t) 1);
+        r.epoch = chrono::steady_clock::now();
+        r.enabled = true;
+    }
+
+    inline void disable() {
+        registry().enabled = false;
+    }
+
+    /**
+     * @brief Stable copy of `name`, for span names that aren't string literals.
+     */
+    inline char const* intern(string const& name) {
+        auto& r = registry();
+        lock_guard<mutex> lock(r.buffers_mutex);
+
+        return r.names.insert(name).first->c_str();
+    }
+
+    inline int64_t now() {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - registry().epoch).count();
+    }
+
+    /**
+     * @brief Ring buffer of the calling thread, allocated on its first call.
+     */
+    inline Buffer& thread_buffer() {
+        thread_local Buffer* buffer = nullptr;
+
+        if (buffer == nullptr) {
+            auto& r = registry();
+            auto allocated = make_unique<Buffer>();
+            allocated->tid = (pid_t) syscall(SYS_gettid);
+            allocated->events.resize(r.capacity);
+
+            lock_guard<mutex> lock(r.buffers_mutex);
+            buffer = allocated.get();
+            r.buffers.push_back(move(allocated));
+        }
+
+        return *buffer;
+    }
+
+    /**
+     * @brief Record the enclosing block as span `name` of the calling thread's timeline, if tracing is enabled.
+     */
+    class Span {
+    public:
+        explicit Span(char const* name) : name(enabled() ? name : nullptr) {
+            if (this->name != nullptr) start = now();
+        }
+
+        ~Span() {
+            if (name != nullptr) thread_buffer().push({name, start, now() - start});
+        }
+
+        Span(Span const&) = delete;
+        Span& operator=(Span const&) = delete;
+
+    private:
+        char const* name;
+        int64_t start = 0;
+    };
+
+    /**
+     * @brief Write the recorded spans as a Chrome trace JSON object. No span may be running meanwhile.
+     *
+     * @return number of spans lost to full buffers
+     */
+    inline uint64_t write_chrome_trace(ostream& os) {
+        auto& r = registry();
+        lock_guard<mutex> lock(r.buffers_mutex);
+
+        uint64_t lost = 0;
+        pid_t pid = getpid();
+        bool first = true;
+
+        auto separator = [&]() -> ostream& {
+            os << (first ? "\n" : ",\n");
+            first = false;
+            return os;
+        };
+
+        // microseconds to the nanosecond, the default 6 significant digits losing milliseconds after 100 s
+        auto flags = os.flags();
+        auto precision = os.precision();
+        os << fixed << setprecision(3);
+
+        os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+
+        for (auto const& buffer : r.buffers) {
+            separator() << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << buffer->tid
+                        << ", \"args\": {\"name\": \"" << (buffer->tid == pid ? "main" : "worker " + to_string(buffer->tid)) << "\"}}";
+
+            size_t capacity = buffer->events.size();
+            size_t kept = (size_t) min<uint64_t>(buffer->count, capacity);
+            lost += buffer->count - kept;
+
+            // oldest first
+            for (uint64_t i = buffer->count - kept; i < buffer->count; ++i) {
+                auto const& event = buffer->events[i % capacity];
+                separator() << "{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": " << pid << ", \"tid\": " << buffer->tid
+                            << ", \"ts\": " << event.start / 1000.0 << ", \"dur\": " << event.duration / 1000.0 << "}";
+            }
+        }
+
+        os << "\n]}" << endl;
+
+        os.flags(flags);
+        os.precision(precision);
+
+        return lost;
+    }
+
+    /**
+     * @brief Forget the recorded spans, keeping the buffers.
+     */
+    inline void clear() {
+        auto& r = registry();
+        lock_guard<mutex> lock(r.buffers_mutex);
+
+        for (auto& buffer : r.buffers) buffer->count = 0;
+    }
+}
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <sys/stat.h>
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "campaign.hpp"
+#include "reductions.hpp"
+
+using namespace std;
+
+/**
+ * Per host tuning of the second stage.
+ *
+ * `tune` microbenchmarks the sweep kernels, thread counts and schedule chunks, the join engine, and the key inversions
+ * of the key schedules following the search, on a reference capture, and returns the fastest `second_stage::Settings`.
+ * They are stored in a small text profile (one `name=value` per line) that later runs load. A profile records the CPU
+ * model it was measured on and is ignored on any other CPU, so a home directory shared by several hosts doesn't spread
+ * one host's settings.
+ */
+namespace tuning {
+    using second_stage::Engine;
+    using second_stage::Kernel;
+    using second_stage::Settings;
+
+    inline string to_string(Engine engine) {
+        switch (engine) {
+            case Engine::SWEEP: return "sweep";
+            case Engine::JOIN:  return "join";
+            case Engine::RANGE: return "range";
+        }
+
+        return "";
+    }
+
+    inline string to_string(Kernel kernel) {
+        switch (kernel) {
+            case Kernel::SCALAR:      return "scalar";
+            case Kernel::INTERLEAVED: return "interleaved";
+            case Kernel::VAES:        return "vaes";
+            case Kernel::COLUMN:      return "column";
+        }
+
+        return "";
+    }
+
+    inline string to_string(KeyInversion inversion) {
+        return (inversion == KeyInversion::AESENCLAST) ? "aesenclast" : "aeskeygenassist";
+    }
+
+    inline bool parse(string const& name, Engine& engine) {
+        if (name == "sweep") engine = Engine::SWEEP;
+        else if (name == "join") engine = Engine::JOIN;
+        else if (name == "range") engine = Engine::RANGE;
+        else return false;
+
+        return true;
+    }
+
+    inline bool parse(string const& name, Kernel& kernel) {
+        if (name == "scalar") kernel = Kernel::SCALAR;
+        else if (name == "interleaved") kernel = Kernel::INTERLEAVED;
+        else if (name == "vaes") kernel = Kernel::VAES;
+        else if (name == "column") kernel = Kernel::COLUMN;
+        else return false;
+
+        return true;
+    }
+
+    inline bool parse(string const& name, KeyInversion& inversion) {
+        if (name == "aeskeygenassist") inversion = KeyInversion::AESKEYGENASSIST;
+        else if (name == "aesenclast") inversion = KeyInversion::AESENCLAST;
+        else return false;
+
+        return true;
+    }
+
+    inline string cpu_model() {
+        ifstream cpuinfo("/proc/cpuinfo");
+        string line;
+
+        while (getline(cpuinfo, line))
+            if (line.rfind("model name", 0) == 0) {
+                size_t colon = line.find(':');
+                size_t start = (colon == string::npos) ? line.size() : line.find_first_not_of(' ', colon + 1);
+                return (start == string::npos) ? "" : line.substr(start);
+            }
+
+        return "unknown";
+    }
+
+    /**
+     * @brief Number of physical cores, hyperthreads of a core sharing its AES units.
+     */
+    inline int physical_cores() {
+        set<string> cores;
+
+        for (int cpu = 0; cpu < omp_get_num_procs(); ++cpu) {
+            ifstream siblings("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+            string list;
+            if (getline(siblings, list)) cores.insert(list);
+        }
+
+        return cores.empty() ? omp_get_num_procs() : (int) cores.size();
+    }
+
+    /**
+     * @brief `$XDG_CONFIG_HOME/aes-single-fault-attack/tuning`, `~/.config` standing for an unset `XDG_CONFIG_HOME`.
+     */
+    inline string profile_path() {
+        char const* config_home = getenv("XDG_CONFIG_HOME");
+        char const* home = getenv("HOME");
+
+        string directory = (config_home != nullptr && *config_home != '\0') ? string(config_home)
+                         : string(home != nullptr ? home : ".") + "/.config";
+
+        return directory + "/aes-single-fault-attack/tuning";
+    }
+
+    /**
+     * @brief Store `settings` at `path`, creating its directory if needed.
+     *
+     * @return false on failure, `error` telling why
+     */
+    inline bool save(string const& path, Settings const& settings, string& error) {
+        for (size_t slash = path.find('/', 1); slash != string::npos; slash = path.find('/', slash + 1))
+            if (mkdir(path.substr(0, slash).c_str(), 0755) != 0 && errno != EEXIST) {
+                error = path.substr(0, slash) + ": " + strerror(errno);
+                return false;
+            }
+
+        ofstream file(path, ios::trunc);
+        file << "# written by `aes-single-fault-attack tune`" << endl;
+        file << "cpu=" << cpu_model() << endl;
+        file << "engine=" << to_string(settings.engine) << endl;
+        file << "kernel=" << to_string(settings.kernel) << endl;
+        file << "inversion=" << to_string(settings.inversion) << endl;
+        file << "threads=" << settings.threads << endl;
+        file << "chunk=" << settings.chunk << endl;
+
+        if (!file.flush()) {
+            error = path + ": write error";
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Load the settings stored at `path` into `settings`, left untouched on failure.
+     *
+     * @return false on failure, `error` telling why (empty if there is no profile at all)
+     */
+    inline bool load(string const& path, Settings& settings, string& error) {
+        ifstream file(path);
+        if (!file) return false;
+
+        Settings loaded;
+        string line, cpu;
+
+        while (getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+
+            size_t equal = line.find('=');
+            string name = line.substr(0, equal);
+            string value = (equal == string::npos) ? "" : line.substr(equal + 1);
+
+            bool valid = equal != string::npos;
+            if (name == "cpu") cpu = value;
+            else if (name == "engine") valid &= parse(value, loaded.engine);
+            else if (name == "kernel") valid &= parse(value, loaded.kernel) && second_stage::kernel_available(loaded.kernel);
+            else if (name == "inversion") valid &= parse(value, loaded.inversion);
+            else if (name == "threads") valid &= (istringstream(value) >> loaded.threads) && loaded.threads > 0;
+            else if (name == "chunk") valid &= (istringstream(value) >> loaded.chunk) && loaded.chunk >= 0;
+            else valid = false;
+
+            if (!valid) {
+                error = path + ": invalid line `" + line + "`";
+                return false;
+            }
+        }
+
+        if (cpu != cpu_model()) {
+            error = path + ": tuned for another CPU (" + cpu + "), run `aes-single-fault-attack tune` again";
+            return false;
+        }
+
+        settings = loaded;
+
+        return true;
+    }
+
+    /**
+     * @brief Tuned settings of this host, the defaults if there is no usable profile.
+     */
+    inline Settings load_or_default() {
+        Settings settings;
+        string error;
+        load(profile_path(), settings, error);
+
+        return settings;
+    }
+
+    /**
+     * @brief Best wall time of `repetitions` runs of `f`, in seconds.
+     */
+    template<typename F>
+    double best_time(F&& f, int repetitions) {
+        double best = 0;
+
+        for (int i = 0; i < repetitions; ++i) {
+            auto start = chrono::steady_clock::now();
+            f();
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (i == 0 || seconds < best) best = seconds;
+        }
+
+        return best;
+    }
+
+    /**
+     * @brief Benchmark the second stage configurations on this host and return the fastest, logging to `log`.
+     *
+     * The sweep configurations run on a 2^24 keys slice of a reference capture and are extrapolated to its
+     * whole key space, the join runs on the whole capture.
+     */
+    inline Settings tune(ostream& log) {
+        constexpr size_t SAMPLE_ROWS = 64;
+
+        // the first simulated capture of the default campaign, the same on every host
+        FlatState Y, Y_;
+        size_t fault_position;
+        campaign::Settings reference;
+        campaign::draw(reference, campaign::fault_differences(reference.model), 0, Y, Y_, fault_position);
+
+        auto stage1_results = first_stage::reduction(Y, Y_, fault_position);
+
+        auto sample = stage1_results;
+        double full_keys = 1, sample_keys = 1;
+        for (auto& rows : sample) {
+            full_keys *= rows.size();
+            rows.resize(min(rows.size(), SAMPLE_ROWS));
+            sample_keys *= rows.size();
+        }
+
+        set<int> thread_counts = {physical_cores(), omp_get_num_procs(), THREADS};
+        vector<Kernel> kernels = {Kernel::SCALAR, Kernel::INTERLEAVED, Kernel::COLUMN};
+        if (second_stage::kernel_available(Kernel::VAES)) kernels.push_back(Kernel::VAES);
+
+        log << "cpu: " << cpu_model() << " (" << physical_cores() << " cores, " << omp_get_num_procs() << " threads)" << endl;
+        log << "sweep, " << sample_keys << " keys slice:" << endl;
+
+        Settings best;
+        double best_seconds = -1;
+
+        for (Kernel kernel : kernels)
+            for (int threads : thread_counts)
+                for (int chunk : {0, 1, 4, 16}) {
+                    Settings settings;
+                    settings.kernel = kernel;
+                    settings.threads = threads;
+                    settings.chunk = chunk;
+
+                    double seconds = best_time([&] { second_stage::reduction(Y, Y_, fault_position, sample, settings); }, 2);
+                    seconds *= full_keys / sample_keys;
+
+                    log << "  " << left << setw(12) << to_string(kernel) << right << setw(4) << threads << " threads, chunk "
+                        << setw(2) << chunk << ": " << fixed << setprecision(2) << seconds << " s (estimated)" << defaultfloat << endl;
+
+                    if (best_seconds < 0 || seconds < best_seconds) {
+                        best = settings;
+                        best_seconds = seconds;
+                    }
+                }
+
+        log << "join, whole capture:" << endl;
+
+        for (int threads : thread_counts) {
+            Settings settings = best;
+            settings.engine = Engine::JOIN;
+            settings.threads = threads;
+
+            double seconds = best_time([&] { second_stage::run(Y, Y_, fault_position, stage1_results, settings); }, 1);
+
+            log << "  " << left << setw(12) << "join" << right << setw(4) << threads << " threads          : " << fixed << setprecision(2) << seconds << " s" << defaultfloat << endl;
+
+            if (seconds < best_seconds) {
+                best = settings;
+                best_seconds = seconds;
+            }
+        }
+
+        // then the key inversion of the third stage, on as many candidates as a few unknown-position captures leave
+        constexpr size_t CANDIDATES = 1 << 14;
+        vector<FlatState> candidates(CANDIDATES, Y);
+        for (size_t i = 0; i < CANDIDATES; ++i) {
+            candidates[i][0] ^= i;
+            candidates[i][1] ^= i >> 8;
+        }
+
+        log << "key schedules, " << CANDIDATES << " candidates:" << endl;
+
+        double best_inversion_seconds = -1;
+        for (KeyInversion inversion : {KeyInversion::AESKEYGENASSIST, KeyInversion::AESENCLAST}) {
+            double seconds = best_time([&] { third_stage::reduction(Y, Y_, candidates, inversion); }, 3);
+
+            log << "  " << left << setw(16) << to_string(inversion) << right << ": " << fixed << setprecision(2) << seconds * 1e3 << " ms" << defaultfloat << endl;
+
+            if (best_inversion_seconds < 0 || seconds < best_inversion_seconds) {
+                best.inversion = inversion;
+                best_inversion_seconds = seconds;
+            }
+        }
+
+        return best;
+    }
+}
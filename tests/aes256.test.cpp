@@ -0,0 +1,126 @@
+#include "aes256.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace aes256 {
+namespace test {
+    Key key = {0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+               0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4};
+
+    /**
+     * @brief Encryption of `P` under `K`, xoring `fault` into byte `fault_position` of the round `fault_round` entry state
+     * (no fault for a zero `fault_round`).
+     */
+    FlatState encrypt(FlatState const& P, Key const& K, size_t fault_round = 0, size_t fault_position = 0, u8 fault = 0) {
+        auto keys = key_schedule_256(_mm_loadu_si128((__m128i *) K.data()), _mm_loadu_si128((__m128i *) (K.data() + 16)));
+
+        __m128i x = _mm_xor_si128(load(P), keys[0]);
+        for (size_t round = 1; round < 14; ++round) {
+            if (round == fault_round) {
+                auto S = unload(x);
+                S[fault_position] ^= fault;
+                x = load(S);
+            }
+
+            x = _mm_aesenc_si128(x, keys[round]);
+        }
+
+        return unload(_mm_aesenclast_si128(x, keys[14]));
+    }
+
+    Capture capture(FlatState const& P, size_t fault_round, size_t fault_position, u8 fault) {
+        return {encrypt(P, key), encrypt(P, key, fault_round, fault_position, fault), fault_position};
+    }
+
+    void key_schedule() {
+        cout << "Testing the AES-256 key schedule..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // FIPS-197 appendix C.3
+        Key K;
+        for (int i = 0; i < 32; ++i) K[i] = i;
+        FlatState P = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+        FlatState Y = {0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89};
+
+        assert (encrypt(P, K) == Y);
+
+        auto [K13, K14] = get_last_round_keys(K);
+        assert (decrypt(Y, K13, K14) == P);
+        assert (get_initial_key(K13, K14) == K);
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // the inversion gives back every round key
+        auto keys = key_schedule_256(_mm_loadu_si128((__m128i *) key.data()), _mm_loadu_si128((__m128i *) (key.data() + 16)));
+        auto inverted = key_schedule_from_last_round_keys(keys[13], keys[14]);
+
+        for (size_t r = 0; r < 15; ++r)
+            assert (unload(inverted[r]) == unload(keys[r]));
+
+        cout << "passed !" << endl;
+    }
+
+    void attack() {
+        FlatState P1 = {0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a};
+        FlatState P2 = {0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51};
+        FlatState P3 = {0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef};
+
+        auto [K13, K14] = get_last_round_keys(key);
+        KeyHints no_hints;
+
+        cout << "Testing the AES-256 attack..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // a single round 12 fault leaves 2^32 round 14 keys
+        vector<Capture> round12 = {capture(P1, 12, 5, 0x3c)};
+        vector<FlatState> last_keys;
+        string error;
+
+        auto rows = last_round_key_rows(round12, no_hints);
+        for (size_t d = 0; d < 4; ++d) {
+            Row row = {K14[ANTIDIAGONALS[d][0]], K14[ANTIDIAGONALS[d][1]], K14[ANTIDIAGONALS[d][2]], K14[ANTIDIAGONALS[d][3]]};
+            assert (find(rows[d].begin(), rows[d].end(), row) != rows[d].end());
+        }
+
+        assert (!last_round_keys(round12, no_hints, last_keys, error));
+        assert (error != "");
+
+        // a second one pins it down
+        round12.push_back(capture(P2, 12, 10, 0x01));
+        assert (last_round_keys(round12, no_hints, last_keys, error));
+        assert (last_keys == vector<FlatState>({K14}));
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // the round 11 fault gives K13 once the last round peeled off
+        auto round11 = capture(P3, 11, 14, 0xa7);
+        auto penultimate_keys = penultimate_round_keys(round11, K14, second_stage::Settings());
+        assert (find(penultimate_keys.begin(), penultimate_keys.end(), K13) != penultimate_keys.end());
+        assert (penultimate_keys.size() < 4096);
+
+        // the plaintext leaves the right key only
+        vector<Key> keys;
+        assert (aes256::attack(round12, round11, &P3, no_hints, second_stage::Settings(), keys, error));
+        assert (keys == vector<Key>({key}));
+
+        cout << "passed !" << endl;
+    }
+}
+}
+
+int main() {
+    aes256::test::key_schedule();
+    aes256::test::attack();
+    return 0;
+}
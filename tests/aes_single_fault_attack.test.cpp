@@ -0,0 +1,83 @@
+// built along with src/aes_single_fault_attack.cpp, the library it drives through its C interface
+#include "aes_single_fault_attack.h"
+#include "aes_ni_utils.hpp"
+#include "test_vectors.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace c_api {
+namespace test {
+    using readme::Y, readme::Y_, readme::P, readme::K0, readme::fault_position;
+
+    vector<FlatState> keys_of(asfa_result const* result) {
+        vector<FlatState> keys(asfa_result_size(result));
+        for (size_t i = 0; i < keys.size(); ++i) assert (asfa_result_key(result, i, keys[i].data()) == ASFA_OK);
+
+        return keys;
+    }
+
+    void attack() {
+        asfa_options options;
+        asfa_init_options(&options);
+        options.engine = ASFA_ENGINE_JOIN;
+
+        cout << "Testing `asfa_attack`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // the plaintext leaves the initial key alone
+        options.plaintext = P.data();
+
+        asfa_result* result = nullptr;
+        assert (asfa_attack(Y.data(), Y_.data(), fault_position, &options, &result) == ASFA_OK);
+        assert (keys_of(result) == vector<FlatState> {K0});
+        asfa_free_result(result);
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // without it, every round 10 key candidate, copied back to back
+        options.plaintext = nullptr;
+        options.key_kind = ASFA_LAST_ROUND_KEY;
+
+        assert (asfa_attack(Y.data(), Y_.data(), fault_position, &options, &result) == ASFA_OK);
+        auto keys = keys_of(result);
+        assert (keys.size() > 1 && find(keys.begin(), keys.end(), get_last_round_key(K0)) != keys.end());
+
+        vector<FlatState> copied(keys.size() + 1);
+        assert (asfa_result_copy(result, copied[0].data(), copied.size()) == keys.size());
+        assert (equal(keys.begin(), keys.end(), copied.begin()));
+
+        FlatState key;
+        assert (asfa_result_key(result, keys.size(), key.data()) == ASFA_OUT_OF_RANGE);
+        asfa_free_result(result);
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 3... ";
+
+        // invalid arguments are reported, never thrown
+        assert (asfa_attack(Y.data(), Y_.data(), 16, &options, &result) == ASFA_OUT_OF_RANGE);
+        assert (asfa_attack(nullptr, Y_.data(), fault_position, &options, &result) == ASFA_INVALID_ARGUMENT);
+
+        options.threads = -1;
+        assert (asfa_attack(Y.data(), Y_.data(), fault_position, &options, &result) == ASFA_INVALID_ARGUMENT);
+        assert (string(asfa_status_string(ASFA_INTERNAL_ERROR)) == "internal error");
+
+        cout << "passed !" << endl;
+        cout << endl;
+    }
+}
+}
+
+int main() {
+    c_api::test::attack();
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "async_attack.hpp"
+#include "test_vectors.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace async_attack {
+namespace test {
+    // README example
+    Request readme_request() {
+        Request request;
+        request.regular = readme::Y;
+        request.faulted = readme::Y_;
+        request.fault_positions = {readme::fault_position};
+        request.has_plaintext = true;
+        request.plaintext = readme::P;
+
+        return request;
+    }
+
+    void attack() {
+        FlatState key = readme::K0;
+        ThreadPool pool(1);
+
+        cout << "Testing `async_attack::start`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        auto request = readme_request();
+        request.settings.engine = second_stage::Engine::JOIN;
+
+        auto attack = start(pool, request);
+        while (!attack.ready()) {
+            double progress = attack.progress();
+            assert (progress >= 0 && progress <= 1);
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+
+        auto result = attack.get();
+        assert (!result.cancelled);
+        assert (result.keys == vector<FlatState>({key}));
+        assert (attack.progress() == 1.0);
+
+        // the round 10 keys, when the third stage is left out
+        request.last_round_keys = true;
+        result = start(pool, request).get();
+        assert (result.keys.size() > 1 && find(result.keys.begin(), result.keys.end(), get_last_round_key(key)) != result.keys.end());
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // a cancelled sweep stops long before its end
+        request = readme_request();
+        request.settings.engine = second_stage::Engine::SWEEP;
+
+        auto begin = chrono::steady_clock::now();
+        auto cancelled = start(pool, request);
+        while (cancelled.progress() == 0) this_thread::sleep_for(chrono::milliseconds(10));
+
+        cancelled.cancel();
+        result = cancelled.get();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+        assert (result.cancelled && result.keys.empty());
+        assert (seconds < 10);
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 3... ";
+
+        // a request without fault position fails through its future, never reaching the pool
+        request = readme_request();
+        request.fault_positions.clear();
+
+        auto rejected = start(pool, request);
+        assert (rejected.ready() && rejected.progress() == 1.0);
+
+        bool thrown = false;
+        try {
+            rejected.get();
+        } catch (invalid_argument const&) {
+            thrown = true;
+        }
+        assert (thrown);
+
+        cout << "passed !" << endl;
+    }
+
+    void thread_pool() {
+        cout << "Testing `async_attack::ThreadPool`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // queued tasks run by decreasing priority, in submission order within a priority
+        vector<int> order;
+        {
+            ThreadPool pool(1);
+            mutex order_mutex;
+            atomic<bool> released {false};
+
+            pool.submit([&] { while (!released) this_thread::sleep_for(chrono::milliseconds(1)); });
+
+            int id = 0;
+            for (Priority priority : {Priority::LOW, Priority::NORMAL, Priority::HIGH, Priority::NORMAL, Priority::LOW})
+                pool.submit([&, id = id++] { lock_guard<mutex> lock(order_mutex); order.push_back(id); }, priority);
+
+            released = true;
+        }
+        assert (order == vector<int>({2, 1, 3, 0, 4}));
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // an attack cancelled while still queued never runs
+        {
+            ThreadPool pool(1);
+            atomic<bool> released {false};
+
+            pool.submit([&] { while (!released) this_thread::sleep_for(chrono::milliseconds(1)); });
+
+            auto attack = start(pool, readme_request(), Priority::LOW);
+            assert (attack.priority() == Priority::LOW);
+            attack.cancel();
+            released = true;
+
+            auto result = attack.get();
+            assert (result.cancelled && result.keys.empty());
+        }
+
+        cout << "passed !" << endl;
+    }
+}
+}
+
+int main() {
+    async_attack::test::thread_pool();
+    async_attack::test::attack();
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "campaign.hpp"
+
+#include <cassert>
+#include <iostream>
+
+using namespace std;
+
+namespace campaign {
+namespace test {
+    void histogram() {
+        cout << "Testing `campaign::Histogram`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        Histogram histogram;
+        for (double x : {0.0, 0.5, 1.0, 3.0, 4.0, 1e30}) histogram.add(x);
+
+        assert (histogram.buckets[0] == 2 && histogram.buckets[1] == 1 && histogram.buckets[2] == 1 && histogram.buckets[3] == 1);
+        assert (histogram.buckets.back() == 1);
+        assert (histogram.count == 6 && histogram.min == 0.0 && histogram.max == 1e30);
+        assert (Histogram::label(0) == "0" && Histogram::label(3) == "[4, 8)");
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        LinearHistogram sizes;
+        for (size_t x : {3, 0, 3, 7}) sizes.add(x);
+
+        assert (sizes.buckets.size() == 8 && sizes.buckets[0] == 1 && sizes.buckets[3] == 2 && sizes.buckets[7] == 1);
+        assert (sizes.count == 4 && sizes.mean() == 3.25 && LinearHistogram::label(7) == "7");
+
+        cout << "passed !" << endl;
+    }
+
+    void simulations() {
+        cout << "Testing `campaign::run`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // the count-only second stage counts what `run` returns
+        Settings settings;
+        settings.stage2.engine = second_stage::Engine::JOIN;
+        settings.stage2.threads = 1;
+
+        FlatState Y, Y_;
+        size_t fault_position;
+        draw(settings, fault_differences(settings.model), 0, Y, Y_, fault_position);
+
+        auto stage1_results = first_stage::reduction(Y, Y_, fault_position);
+        auto keys = second_stage::run(Y, Y_, fault_position, stage1_results, settings.stage2);
+        assert (!keys.empty() && second_stage::count(Y, Y_, fault_position, stage1_results, settings.stage2) == keys.size());
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // the same figures whatever the thread count, at the requested positions only
+        settings.simulations = 2;
+        settings.fault_positions = {3, 12};
+
+        auto one = run(settings);
+        settings.stage2.threads = 2;
+        auto two = run(settings);
+
+        assert (one.size() == 2 && two.size() == 2);
+        for (size_t i = 0; i < 2; ++i) {
+            assert (one[i].fault_position == 3 || one[i].fault_position == 12);
+            assert (one[i].fault_position == two[i].fault_position && one[i].stage1_sizes == two[i].stage1_sizes);
+            assert (one[i].survivors > 0 && one[i].survivors == two[i].survivors);
+        }
+
+        auto summaries = summarize(one);
+        assert (summaries[16].simulations == 2 && summaries[3].simulations + summaries[12].simulations == 2);
+
+        // every antidiagonal of every simulation in the stage 1 histograms
+        auto const& sizes = summaries[16].stage1_sizes;
+        assert (sizes.count == 8);
+        for (auto const& simulation : one)
+            for (auto size : simulation.stage1_sizes) assert (size < sizes.buckets.size() && sizes.buckets[size] > 0);
+        assert (summaries[one[0].fault_position].stage1_sizes.count >= 4);
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 3... ";
+
+        // restricted fault models are simulated as such: the right key always survives, so never 0 survivors
+        for (auto model : {FaultModel::bit_flip(), FaultModel::stuck_at(0x00)}) {
+            settings.model = model;
+            settings.simulations = 1;
+
+            // ineffective stuck-at faults drawn again
+            auto differences = fault_differences(model);
+            assert (model.stuck_value >= 0 || differences.size() == 8);
+            for (size_t i = 0; i < 64; ++i) {
+                draw(settings, differences, i, Y, Y_, fault_position);
+                assert (Y != Y_);
+            }
+
+            assert (run(settings)[0].survivors > 0);
+        }
+
+        cout << "passed !" << endl;
+    }
+}
+}
+
+int main() {
+    campaign::test::histogram();
+    campaign::test::simulations();
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "capture_file.hpp"
+#include "test_vectors.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+
+using namespace std;
+
+namespace capture_file {
+namespace test {
+    void round_trip() {
+        string path = "capture_file.test.bin";
+
+        Record first {}, second {};
+        first.regular  = readme::Y;
+        first.faulted  = readme::Y_;
+        first.fault = 8;
+        second = first;
+        second.plaintext = readme::P;
+        second.fault = 2;
+        second.flags = HAS_PLAINTEXT | COLUMN_ONLY;
+
+        cout << "Testing capture file round trip..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        Writer writer;
+        assert (writer.open(path));
+        writer.append(first);
+        writer.append(second);
+        assert (writer.close());
+
+        {
+            Reader reader;
+            assert (reader.open(path));
+            assert (reader.size() == 2);
+
+            assert (reader[0].regular == first.regular && reader[0].faulted == first.faulted);
+            assert (reader[0].fault == 8 && !reader[0].has_plaintext() && !reader[0].column_only());
+
+            assert (reader[1].plaintext == second.plaintext);
+            assert (reader[1].fault == 2 && reader[1].has_plaintext() && reader[1].column_only());
+        }
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        {
+            FILE* f = fopen(path.c_str(), "r+b");
+            fputc('X', f);
+            fclose(f);
+
+            Reader reader;
+            assert (!reader.open(path));
+            assert (reader.size() == 0);
+        }
+
+        remove(path.c_str());
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+    }
+}
+}
+
+int main() {
+    capture_file::test::round_trip();
+    return 0;
+}
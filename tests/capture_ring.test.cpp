@@ -0,0 +1,146 @@
+#include "capture_ring.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace capture_ring {
+namespace test {
+    string segment(string const& ring) {
+        return segment_name("capture_ring.test." + to_string(getpid()), ring);
+    }
+
+    capture_file::Record record(uint64_t i) {
+        capture_file::Record r {};
+        for (size_t j = 0; j < 16; ++j) {
+            r.regular[j] = i + j;
+            r.faulted[j] = i * 3 + j;
+        }
+        r.fault = i % 16;
+
+        return r;
+    }
+
+    void ring() {
+        cout << "Testing `capture_ring::Ring`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // power of 2 capacities only, and nothing to attach to before `create`
+        {
+            Ring<capture_file::Record> ring;
+            assert (!ring.create(segment("captures"), 0));
+            assert (!ring.create(segment("captures"), 12));
+            assert (!ring.attach(segment("captures")));
+        }
+
+        // a second creator, or a side of another record size, is refused
+        {
+            struct Small { u8 bytes[32]; };
+
+            Ring<capture_file::Record> created, twice;
+            Ring<Small> mistyped;
+            assert (created.create(segment("captures"), 4));
+            assert (!twice.create(segment("captures"), 4));
+            assert (!mistyped.attach(segment("captures")));
+            assert (mistyped.error().find("record size") != string::npos);
+        }
+
+        // the creator removed the segment
+        {
+            Ring<capture_file::Record> ring;
+            assert (!ring.attach(segment("captures")));
+        }
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // full and empty rings
+        {
+            Ring<capture_file::Record> consumer, producer;
+            assert (consumer.create(segment("captures"), 4));
+            assert (producer.attach(segment("captures")));
+
+            assert (consumer.front() == nullptr);
+            for (uint64_t i = 0; i < 4; ++i) {
+                auto* slot = producer.claim();
+                assert (slot != nullptr);
+                *slot = record(i);
+                producer.publish();
+            }
+            assert (producer.claim() == nullptr);
+
+            assert (consumer.position() == 0 && consumer.front()->fault == 0);
+            consumer.release();
+            assert (producer.claim() != nullptr);
+
+            assert (!consumer.drained());
+            producer.close();
+            for (uint64_t i = 1; i < 4; ++i) {
+                assert (consumer.position() == i && consumer.front()->regular == record(i).regular);
+                consumer.release();
+            }
+            assert (consumer.drained());
+        }
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 3... ";
+
+        // records stream across threads in order, through a ring much smaller than the stream
+        {
+            constexpr uint64_t COUNT = 100000;
+
+            Ring<capture_file::Record> consumer;
+            assert (consumer.create(segment("captures"), 8));
+
+            thread producer_thread([] {
+                Ring<capture_file::Record> producer;
+                assert (producer.attach(segment("captures")));
+
+                Backoff backoff;
+                for (uint64_t i = 0; i < COUNT; ++i) {
+                    capture_file::Record* slot;
+                    while ((slot = producer.claim()) == nullptr) backoff.wait();
+                    backoff.reset();
+
+                    *slot = record(i);
+                    producer.publish();
+                }
+                producer.close();
+            });
+
+            Backoff backoff;
+            uint64_t received = 0;
+            while (!consumer.drained()) {
+                auto const* r = consumer.front();
+                if (r == nullptr) {
+                    backoff.wait();
+                    continue;
+                }
+                backoff.reset();
+
+                auto expected = record(received);
+                assert (r->regular == expected.regular && r->faulted == expected.faulted && r->fault == expected.fault);
+                consumer.release();
+                ++received;
+            }
+
+            producer_thread.join();
+            assert (received == COUNT);
+        }
+
+        cout << "passed !" << endl;
+    }
+}
+}
+
+int main() {
+    capture_ring::test::ring();
+    return 0;
+}
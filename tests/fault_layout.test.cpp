@@ -0,0 +1,114 @@
+#include "fault_layout.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <type_traits>
+
+using namespace std;
+
+namespace test {
+    void layouts() {
+        cout << "Testing `make_layout`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        assert ((ANTIDIAGONALS == array<array<size_t, 4>, 4> {{{0, 13, 10, 7}, {4, 1, 14, 11}, {8, 5, 2, 15}, {12, 9, 6, 3}}}));
+
+        // differential column and mask, as tabulated by hand
+        constexpr size_t DIFF_COLUMNS[16] = {0, 3, 2, 1, 1, 0, 3, 2, 2, 1, 0, 3, 3, 2, 1, 0};
+        for (size_t position = 0; position < 16; ++position) {
+            auto const& layout = SINGLE_BYTE_LAYOUTS[position];
+            assert (layout.diff_column == DIFF_COLUMNS[position]);
+            assert (layout.fault_mask == (0xffff & ~(1 << shift_rows(position))));
+            assert (shift_rows(position) / 4 == layout.diff_column && shift_rows(position) % 4 == position % 4);
+        }
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // first stage factors of column 0, the other columns rotating them
+        constexpr array<array<size_t, 4>, 4> FACTORS {{{2, 1, 1, 3}, {1, 1, 3, 2}, {1, 3, 2, 1}, {3, 2, 1, 1}}};
+        for (size_t position = 0; position < 16; ++position) {
+            auto const& layout = SINGLE_BYTE_LAYOUTS[position];
+            for (size_t j = 0; j < 4; ++j) {
+                assert (layout.factors[j] == FACTORS[(j + 4 - layout.diff_column) % 4]);
+                assert (layout.propagation[j] == MIX_COLUMNS[(layout.diff_column + 4 - j) % 4][position % 4]);
+            }
+        }
+
+        // a fault at (0, 0): eps goes through MixColumns column 0, (2, 1, 1, 3) by row, antidiagonal j getting row -j
+        assert ((SingleByteFault<0>::LAYOUT.propagation == array<u8, 4> {2, 3, 1, 1}));
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 3... ";
+
+        // multi-byte faults: the bytes of each row set land in their column, whose factors they share
+        for (size_t column = 0; column < 4; ++column)
+            for (unsigned rows = 1; rows < 16; ++rows) {
+                FaultDescriptor fault {8, column_fault_bytes(column, rows)};
+                assert (is_supported(fault));
+
+                int fault_mask = 0xffff;
+                for (size_t r = 0; r < 4; ++r)
+                    if (rows >> r & 1) fault_mask &= ~(1 << (4 * column + r));
+
+                auto layout = make_layout(fault);
+                assert (layout.diff_column == column && layout.fault_mask == fault_mask);
+                assert (layout.single_byte == ((rows & (rows - 1)) == 0));
+                assert (layout.checked_mask == (layout.single_byte ? 0xffff : fault_mask));
+                assert (layout.factors == SINGLE_BYTE_LAYOUTS[4 * column].factors);
+            }
+
+        // bytes 12 and 1 of the entry state, shifted to rows 0 and 1 of column 3
+        assert ((ColumnFault<3, 0b0011>::DESCRIPTOR.bytes == (1 << 12 | 1 << 1)));
+        assert ((ColumnFault<3, 0b0011>::LAYOUT.fault_mask == 0xcfff));
+
+        cout << "passed !" << endl;
+    }
+
+    void dispatch() {
+        cout << "Testing `dispatch_fault`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        for (size_t position = 0; position < 16; ++position) {
+            int mask = dispatch_fault(position, [](auto fault) {
+                using Fault = decltype(fault);
+                static_assert(is_supported(Fault::DESCRIPTOR), "supported");
+                return Fault::LAYOUT.fault_mask;
+            });
+            assert (mask == get_fault_mask(position));
+        }
+
+        static_assert(!is_supported({9, 1}) && !is_supported({8, 0}) && !is_supported({8, 3}), "unsupported faults");
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        for (size_t column = 0; column < 4; ++column)
+            for (unsigned rows = 1; rows < 16; ++rows) {
+                FaultDescriptor fault {8, column_fault_bytes(column, rows)};
+                auto bytes = dispatch_fault(fault, [](auto type) { return decltype(type)::DESCRIPTOR.bytes; });
+                assert (bytes == fault.bytes);
+            }
+
+        // single byte descriptors get the instantiations of their position
+        for (size_t position = 0; position < 16; ++position) {
+            bool same = dispatch_fault(single_byte_fault(position), [&](auto type) {
+                return dispatch_fault(position, [&](auto other) { return is_same<decltype(type), decltype(other)>::value; });
+            });
+            assert (same);
+        }
+
+        cout << "passed !" << endl;
+    }
+}
+
+int main() {
+    test::layouts();
+    test::dispatch();
+    return 0;
+}
@@ -0,0 +1,174 @@
+#include "key_set.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace key_set {
+namespace test {
+    uint64_t state = 0x9e3779b97f4a7c15;
+
+    uint64_t random() {
+        state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+        return state;
+    }
+
+    // random keys, with runs of keys sharing long prefixes
+    vector<FlatState> keys(size_t count) {
+        vector<FlatState> keys(count);
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t j = 0; j < 16; j += 8) {
+                uint64_t r = random();
+                memcpy(keys[i].data() + j, &r, 8);
+            }
+
+            if (i % 7 == 1) {
+                size_t prefix = random() % 17;
+                copy(keys[i - 1].begin(), keys[i - 1].begin() + prefix, keys[i].begin());
+            }
+        }
+
+        return keys;
+    }
+
+    string path(string const& name) {
+        return "/tmp/key_set.test." + to_string(getpid()) + "." + name;
+    }
+
+    vector<FlatState> read(string const& path) {
+        Reader reader;
+        assert (reader.open(path));
+
+        vector<FlatState> keys;
+        for (FlatState key; reader.next(key);) keys.push_back(key);
+        assert (reader.error() == "" && keys.size() == reader.size());
+
+        return keys;
+    }
+
+    void sort() {
+        cout << "Testing `key_set::sort`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        for (size_t count : {0, 1, 2, 1000, 200000}) {
+            auto sorted = keys(count);
+            sorted.insert(sorted.end(), sorted.begin(), sorted.begin() + count / 3);    // duplicates
+
+            auto expected = sorted;
+            std::sort(expected.begin(), expected.end());
+            expected.erase(unique(expected.begin(), expected.end()), expected.end());
+
+            key_set::sort(sorted);
+            assert (sorted == expected);
+        }
+
+        FlatState a {}, b {};
+        b[15] = 1;
+        assert (compare(a, b) < 0 && compare(b, a) > 0 && compare(a, a) == 0);
+        assert (shared_prefix(a, b) == 15 && shared_prefix(a, a) == 16);
+
+        cout << "passed !" << endl;
+    }
+
+    void files() {
+        string error;
+
+        cout << "Testing `key_set::Reader` and `key_set::Writer`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // round trip across many buffer refills, every shared prefix length
+        auto set = keys(100000);
+        assert (write(path("a"), set, error));
+        key_set::sort(set);
+        assert (read(path("a")) == set);
+
+        // front coding pays
+        FILE* file = fopen(path("a").c_str(), "rb");
+        fseek(file, 0, SEEK_END);
+        assert ((size_t) ftell(file) < sizeof(Header) + set.size() * 16);
+        fclose(file);
+
+        assert (write(path("empty"), {}, error));
+        assert (read(path("empty")).empty());
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // keys have to come in order
+        Writer writer;
+        assert (writer.open(path("b")));
+        assert (writer.append(set[1]) && writer.append(set[1]) && !writer.append(set[0]));
+        assert (writer.size() == 1 && writer.close());
+
+        // corrupt and truncated files
+        assert (!Reader().open(path("missing")));
+
+        file = fopen(path("b").c_str(), "r+b");
+        fseek(file, sizeof(Header), SEEK_SET);
+        fputc(16, file);
+        fclose(file);
+
+        Reader reader;
+        FlatState key;
+        assert (reader.open(path("b")) && !reader.next(key) && reader.error().find("corrupt") != string::npos);
+
+        assert (truncate(path("a").c_str(), sizeof(Header) + 1000) == 0);
+        assert (reader.open(path("a")));
+        while (reader.next(key));
+        assert (reader.error().find("truncated") != string::npos);
+
+        for (auto const& name : {"a", "b", "empty"}) remove(path(name).c_str());
+        cout << "passed !" << endl;
+    }
+
+    void merge() {
+        string error;
+
+        cout << "Testing `key_set::merge`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        auto a = keys(50000), b = keys(50000);
+        b.insert(b.end(), a.begin(), a.begin() + 20000);
+        key_set::sort(a);
+        key_set::sort(b);
+
+        assert (write(path("a"), a, error) && write(path("b"), b, error));
+
+        using Merge = vector<FlatState>::iterator (*)(vector<FlatState>::iterator, vector<FlatState>::iterator, vector<FlatState>::iterator, vector<FlatState>::iterator, vector<FlatState>::iterator);
+        for (auto [operation, expected_merge] : {pair<Operation, Merge> {Operation::INTERSECTION, set_intersection},
+                                                 pair<Operation, Merge> {Operation::UNION, set_union},
+                                                 pair<Operation, Merge> {Operation::DIFFERENCE, set_difference}}) {
+            vector<FlatState> expected(a.size() + b.size());
+            expected.erase(expected_merge(a.begin(), a.end(), b.begin(), b.end(), expected.begin()), expected.end());
+
+            Reader x, y;
+            Writer out;
+            assert (x.open(path("a")) && y.open(path("b")) && out.open(path("out")));
+            assert (key_set::merge(x, y, operation, out, error) && out.close());
+            assert (out.size() == expected.size() && read(path("out")) == expected);
+        }
+
+        for (auto const& name : {"a", "b", "out"}) remove(path(name).c_str());
+        cout << "passed !" << endl;
+    }
+}
+}
+
+int main() {
+    key_set::test::sort();
+    key_set::test::files();
+    key_set::test::merge();
+    return 0;
+}
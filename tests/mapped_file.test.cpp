@@ -0,0 +1,54 @@
+#include "mapped_file.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace mapped_file {
+namespace test {
+    void open() {
+        string first = "mapped_file.test.first", second = "mapped_file.test.second", empty = "mapped_file.test.empty";
+        ofstream(first, ios::binary) << "0123456789abcdef";
+        ofstream(second, ios::binary) << "fedcba9876543210fedcba9876543210";
+        ofstream(empty, ios::binary);
+
+        cout << "Testing `MappedFile::open`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        MappedFile file;
+        assert (file.open(first));
+        assert (file.size() == 16 && string(file.data(), file.size()) == "0123456789abcdef");
+
+        // opened again, the mapping is replaced
+        assert (file.open(second));
+        assert (file.size() == 32 && string(file.data(), 4) == "fedc");
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        assert (file.open(empty));
+        assert (file.size() == 0 && file.error() == "");
+
+        // a failure leaves nothing mapped
+        assert (!file.open("mapped_file.test.missing"));
+        assert (file.size() == 0 && file.data() == nullptr && file.error() != "");
+
+        remove(first.c_str());
+        remove(second.c_str());
+        remove(empty.c_str());
+
+        cout << "passed !" << endl;
+        cout << endl;
+    }
+}
+}
+
+int main() {
+    mapped_file::test::open();
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "oracle.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace oracle {
+namespace test {
+    FlatState K0 = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+
+    vector<FlatState> encrypt(vector<FlatState> const& plaintexts) {
+        auto keys = key_schedule_from_last_round_key(load(get_last_round_key(K0)));
+
+        vector<FlatState> ciphertexts;
+        for (auto const& P : plaintexts) {
+            __m128i x = _mm_xor_si128(load(P), keys[0]);
+            for (int round = 1; round < 10; ++round) x = _mm_aesenc_si128(x, keys[round]);
+            ciphertexts.push_back(unload(_mm_aesenclast_si128(x, keys[10])));
+        }
+
+        return ciphertexts;
+    }
+
+    vector<FlatState> blocks(string const& text) {
+        vector<FlatState> plaintexts((text.size() + 15) / 16);
+        for (size_t i = 0; i < text.size(); ++i) plaintexts[i / 16][i % 16] = text[i];
+
+        return plaintexts;
+    }
+
+    // the right round 10 key among 255 random ones
+    vector<FlatState> candidates() {
+        uint64_t state = 0x9e3779b97f4a7c15;
+        auto random = [&] {
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+            return state;
+        };
+
+        vector<FlatState> keys;
+        for (int i = 0; i < 255; ++i) keys.push_back(unload(_mm_set_epi64x(random(), random())));
+        keys.insert(keys.begin() + 100, get_last_round_key(K0));
+
+        return keys;
+    }
+
+    vector<FlatState> last_round_keys(vector<Candidate> const& shortlist) {
+        vector<FlatState> keys;
+        for (auto const& candidate : shortlist) keys.push_back(candidate.K10);
+
+        return keys;
+    }
+
+    void rank() {
+        using Kind = Structure::Kind;
+        auto K10 = get_last_round_key(K0);
+        auto keys = candidates();
+
+        cout << "Testing `oracle::rank`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // batched decryption, interleaved blocks and tail
+        auto plaintexts = blocks("The quick brown fox jumps over the lazy dog, then over the lazy cat, then over the fence and far away. ");
+        auto ciphertexts = encrypt(plaintexts);
+        assert (ciphertexts.size() == 7);
+
+        vector<FlatState> out(ciphertexts.size());
+        decrypt(ciphertexts.data(), out.data(), ciphertexts.size(), key_schedule_from_last_round_key(load(K10)).data());
+
+        for (size_t i = 0; i < ciphertexts.size(); ++i) {
+            assert (out[i] == plaintexts[i]);
+            assert (out[i] == ::decrypt(ciphertexts[i], K10));
+        }
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // printable text
+        Structure printable;
+        ciphertexts = encrypt(blocks("Attack at dawn! Retreat at dusk."));
+        assert (last_round_keys(oracle::rank(keys, ciphertexts, {printable})) == vector<FlatState>({K10}));
+        assert (last_round_keys(oracle::rank(keys, ciphertexts, {printable}, 1)) == vector<FlatState>({K10}));
+
+        // zero padded
+        ciphertexts = encrypt(blocks("Meet me at the usual place."));
+        assert (last_round_keys(oracle::rank(keys, ciphertexts, {printable})) == vector<FlatState>({K10}));
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 3... ";
+
+        // header magic and zero padding
+        Structure magic;
+        magic.kind = Kind::MAGIC;
+        magic.magic = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+        Structure padding;
+        padding.kind = Kind::ZERO_PADDING;
+        padding.padding = 6;
+
+        plaintexts = {{0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n', 0, 0, 0, 0x0d, 'I', 'H', 'D', 'R'},
+                      {0x13, 0x37, 0xc0, 0xde, 0x42, 0x24, 0x99, 0x11, 0x01, 0x02, 0, 0, 0, 0, 0, 0}};
+        ciphertexts = encrypt(plaintexts);
+
+        assert (last_round_keys(oracle::rank(keys, ciphertexts, {magic})) == vector<FlatState>({K10}));
+        assert (last_round_keys(oracle::rank(keys, ciphertexts, {padding})) == vector<FlatState>({K10}));
+        assert (last_round_keys(oracle::rank(keys, ciphertexts, {magic, padding})) == vector<FlatState>({K10}));
+
+        // every structure has to fit
+        assert (oracle::rank(keys, ciphertexts, {magic, printable}).empty());
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 4... ";
+
+        // low entropy, bytes of 2 bits
+        Structure entropy;
+        entropy.kind = Kind::ENTROPY;
+        entropy.max_entropy = 3;
+
+        plaintexts.assign(4, FlatState {});
+        for (size_t i = 0; i < 64; ++i) plaintexts[i / 16][i % 16] = (i * 7 + i / 5) % 4;
+        ciphertexts = encrypt(plaintexts);
+
+        auto shortlist = oracle::rank(keys, ciphertexts, {entropy});
+        assert (last_round_keys(shortlist) == vector<FlatState>({K10}));
+        assert (shortlist[0].score >= 6);
+
+        cout << "passed !" << endl;
+    }
+}
+}
+
+int main() {
+    oracle::test::rank();
+    return 0;
+}
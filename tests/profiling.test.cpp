@@ -0,0 +1,76 @@
+#include "profiling.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+namespace profiling {
+namespace test {
+    // some work the counters can see
+    uint64_t spin(uint64_t n) {
+        volatile uint64_t x = 1;
+        for (uint64_t i = 0; i < n; ++i) x = x * 6364136223846793005 + 1442695040888963407;
+        return x;
+    }
+
+    void scopes() {
+        Profiler profiler;
+
+        cout << "Testing `profiling::Scope`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        {
+            Scope scope(&profiler, "first");
+            spin(1 << 20);
+        }
+        {
+            Scope scope(&profiler, "second");
+            spin(1 << 16);
+        }
+        {
+            // a phase run again adds up
+            Scope scope(&profiler, "first");
+            spin(1 << 20);
+        }
+
+        auto const& phases = profiler.phases();
+        assert (phases.size() == 2);
+        assert (phases[0].name == "first" && phases[1].name == "second");
+        for (auto const& phase : phases) assert (phase.seconds >= 0);
+
+        if (profiler.counters_available()) {
+            assert (phases[0].counts[INSTRUCTIONS] > phases[1].counts[INSTRUCTIONS]);
+            assert (phases[0].counts[CYCLES] > 0);
+        } else {
+            assert (profiler.reason() != "");
+        }
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // a null profiler is a no-op
+        {
+            Scope scope(nullptr, "ignored");
+        }
+        assert (profiler.phases().size() == 2);
+
+        ostringstream table, json;
+        print_table(table, profiler);
+        print_json(json, profiler);
+        assert (table.str().find("second") != string::npos);
+        assert (json.str().find("\"name\": \"first\"") != string::npos);
+
+        cout << "passed !" << endl;
+        cout << endl;
+    }
+}
+}
+
+int main() {
+    profiling::test::scopes();
+    return 0;
+}
@@ -1,138 +1,445 @@
-#include "reductions.hpp"
-
-#include <cassert>
-#include <algorithm>
-#include <iostream>
-#include <iomanip>
-
-using namespace std;
-
-namespace second_stage {
-namespace test {
-    namespace single_case {
-        void reduction(FlatState const& Y, FlatState const& Y_, size_t fault_position, array<vector<Row>, 4> const& stage1_results, FlatState const& K10)
-        {
-            auto keys = second_stage::reduction(Y, Y_, fault_position, stage1_results);
-            auto it = find(keys.begin(), keys.end(), K10);
-            assert (it != keys.end());
-        }
-    }
-
-    void reduction() {
-        array tests = {
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0xbc, 0x3e, 0x68, 0x8f, 0x08, 0xe3, 0xfc, 0x21, 0x69, 0xfd, 0x5b, 0xbe, 0x91, 0x4e, 0xd9, 0x32},
-                {0x5e, 0x28, 0x21, 0x2d, 0xb6, 0x8c, 0xab, 0x31, 0x12, 0xf2, 0x1c, 0x8d, 0x47, 0x4f, 0xf0, 0xcf},
-                {0xe9, 0x32, 0xe8, 0x9a, 0x18, 0xcc, 0xda, 0xaa, 0x6a, 0x14, 0x0b, 0x6c, 0xd3, 0x74, 0x3a, 0x5e},
-                0,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0x77, 0x41, 0x2e, 0x88, 0x3d, 0xb6, 0x82, 0xd6, 0x1d, 0x6d, 0x8d, 0x2f, 0x37, 0x07, 0x79, 0x18},
-                {0x87, 0x1f, 0xe2, 0x39, 0x4b, 0x13, 0xb7, 0xc2, 0x0b, 0x37, 0x07, 0xa5, 0x58, 0xe5, 0x05, 0x1f},
-                {0x7c, 0xb4, 0x15, 0xa2, 0x09, 0x44, 0x0e, 0x66, 0xdf, 0x5c, 0xf2, 0x8b, 0xfb, 0x5b, 0x13, 0x35},
-                1,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0x45, 0xb5, 0x7c, 0x09, 0xd7, 0xee, 0x65, 0x79, 0x4b, 0x42, 0xd5, 0x8f, 0x27, 0x96, 0xc3, 0x67},
-                {0xca, 0x25, 0xa6, 0xe4, 0x3e, 0x1d, 0x51, 0x7d, 0x9c, 0xa4, 0xa1, 0x20, 0x02, 0xbe, 0xed, 0x65},
-                {0x77, 0xe1, 0x20, 0x9e, 0x7b, 0x53, 0xae, 0x42, 0xfb, 0x60, 0x53, 0x21, 0x6e, 0x2c, 0x1e, 0xe0},
-                2,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0x96, 0x5b, 0xde, 0x2d, 0x71, 0x0e, 0x4a, 0xf8, 0xd7, 0x76, 0x36, 0x05, 0x15, 0x2a, 0x20, 0x99},
-                {0x98, 0x1b, 0x47, 0x36, 0xf3, 0x28, 0xda, 0xe2, 0xb6, 0x84, 0xdc, 0x2a, 0x38, 0xf3, 0x1f, 0x12},
-                {0x27, 0xd3, 0x4d, 0x27, 0x19, 0x45, 0x86, 0xcd, 0x0e, 0xec, 0xc8, 0xe6, 0x54, 0xdf, 0x7d, 0x91},
-                3,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {        
-                {0x99, 0x08, 0x45, 0x0c, 0xaa, 0xb6, 0x47, 0x75, 0x64, 0x56, 0xcc, 0xd0, 0x86, 0x1a, 0x6f, 0x7b},
-                {0xa9, 0x1a, 0x9d, 0x67, 0x45, 0xe3, 0x53, 0x93, 0x9d, 0x52, 0x79, 0x52, 0xc5, 0xe5, 0x0e, 0xb1},
-                {0x71, 0x93, 0x78, 0x5c, 0x5f, 0x94, 0x4d, 0x83, 0x2a, 0x94, 0xbb, 0x41, 0x14, 0xf2, 0xcb, 0xe8},
-                4,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0x35, 0x6e, 0x64, 0xfd, 0x0a, 0x66, 0x42, 0x10, 0xa6, 0xdd, 0x55, 0x21, 0xbb, 0xda, 0xae, 0xfd},
-                {0x9a, 0x01, 0x1b, 0xff, 0x50, 0x3b, 0x8d, 0x33, 0xad, 0x1f, 0x2f, 0xbe, 0x87, 0x15, 0xd8, 0x2f},
-                {0x41, 0x02, 0x25, 0xae, 0x64, 0x83, 0x1b, 0xf6, 0x31, 0x31, 0x81, 0x26, 0xa1, 0x9f, 0x2f, 0xdb},
-                5,        
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0x98, 0xde, 0x47, 0x5e, 0x13, 0x90, 0x53, 0x2c, 0x2b, 0x40, 0x6d, 0x20, 0x14, 0x20, 0x4e, 0x4a},
-                {0xd4, 0xb5, 0xcf, 0x71, 0x02, 0x97, 0x40, 0xde, 0xba, 0x62, 0xb8, 0xaa, 0x02, 0x0d, 0x0e, 0x14},
-                {0x86, 0x72, 0x3b, 0x05, 0x87, 0x47, 0xb5, 0xb0, 0x93, 0xb1, 0xee, 0x7d, 0xcf, 0xee, 0x88, 0x1a},
-                6,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {           
-                {0xe3, 0x06, 0x03, 0xa6, 0x39, 0xfb, 0x19, 0x86, 0x35, 0x33, 0x6c, 0x83, 0xf5, 0x78, 0x7d, 0x8c},
-                {0x74, 0xdb, 0xdc, 0xd9, 0xc8, 0xdc, 0xe5, 0xea, 0x52, 0x47, 0xb3, 0x5b, 0x35, 0xc8, 0x91, 0x16},
-                {0xde, 0xab, 0x45, 0x35, 0x04, 0x0a, 0xb8, 0x95, 0x76, 0xca, 0xea, 0x03, 0xcb, 0x57, 0x5a, 0xf1},
-                7,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0xe5, 0xc4, 0x6e, 0x1d, 0xfb, 0x26, 0x4c, 0x7f, 0x21, 0xfa, 0x3e, 0x87, 0x29, 0x3a, 0x0d, 0xed},
-                {0x36, 0xa5, 0x51, 0xed, 0x94, 0x1f, 0x78, 0x91, 0x75, 0x91, 0xdc, 0x11, 0x87, 0x54, 0x79, 0xd3},
-                {0x3d, 0x1b, 0x0a, 0x64, 0x08, 0x12, 0xa3, 0xb3, 0xbd, 0x0c, 0xa1, 0xdc, 0xdb, 0xaf, 0x7a, 0xbc},
-                8,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0x71, 0x37, 0x53, 0x7f, 0x4c, 0x18, 0x21, 0x7c, 0x0b, 0x4c, 0x45, 0xbf, 0xe8, 0xa0, 0xe0, 0xc6},
-                {0xe2, 0x79, 0x30, 0xde, 0xe4, 0xce, 0x9a, 0x1b, 0x39, 0x6c, 0xf0, 0x9d, 0x37, 0xad, 0x67, 0x5b},
-                {0xd2, 0x54, 0xf9, 0x3f, 0x47, 0xd1, 0xaf, 0x2c, 0xe0, 0xc6, 0x14, 0xa3, 0x46, 0x23, 0x91, 0x41},
-                9,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0x44, 0xea, 0x69, 0x6d, 0xd7, 0xbc, 0xf0, 0xbe, 0x66, 0x28, 0x5d, 0xfb, 0x8c, 0x08, 0xdc, 0x2f},
-                {0xe8, 0x94, 0x0b, 0xba, 0x46, 0x18, 0x14, 0x47, 0x63, 0xaf, 0xf0, 0xb2, 0x57, 0x36, 0xc6, 0x71},
-                {0xe1, 0x49, 0xc6, 0x53, 0x3d, 0xfb, 0x1e, 0xcc, 0x9e, 0x81, 0x6e, 0xb7, 0xfd, 0x4f, 0x70, 0xb1},
-                10,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0x69, 0x51, 0x64, 0x80, 0xe3, 0xf2, 0xe5, 0x76, 0x02, 0xa2, 0x3a, 0xe6, 0x8f, 0xd9, 0x2f, 0xaf},
-                {0x77, 0xee, 0x57, 0xa9, 0xba, 0x30, 0x9f, 0x1f, 0x5a, 0x1c, 0xe5, 0xa8, 0x5f, 0xba, 0x6c, 0x5b},
-                {0x05, 0x74, 0xe8, 0xaa, 0xa5, 0x33, 0x76, 0xc8, 0x5a, 0xc1, 0x70, 0xc8, 0x05, 0xf7, 0x20, 0x6e},
-                11,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0x69, 0xb5, 0x2f, 0xd0, 0x20, 0x5a, 0x18, 0xf2, 0x2a, 0x3d, 0xd0, 0x67, 0x4d, 0xc7, 0x9b, 0x77},
-                {0xba, 0x01, 0xd9, 0x95, 0xd2, 0x3d, 0xb2, 0x4b, 0x10, 0xe7, 0x83, 0x62, 0xda, 0x1f, 0x01, 0xf5},
-                {0xfd, 0x6b, 0xe5, 0x70, 0xe5, 0x14, 0xbd, 0xcd, 0x4d, 0xb9, 0x58, 0xac, 0x95, 0xd6, 0x6e, 0x93},
-                12,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0xfe, 0x85, 0xfb, 0x65, 0x8a, 0x5c, 0x5d, 0xf8, 0x1f, 0x56, 0xf1, 0xc1, 0x18, 0x65, 0x77, 0xc4},
-                {0xf5, 0x1e, 0xfd, 0xde, 0x86, 0xce, 0x0c, 0x69, 0x46, 0x1d, 0xb3, 0x88, 0x83, 0x51, 0xfd, 0xff},
-                {0xeb, 0x31, 0xe1, 0x5f, 0xc3, 0xa7, 0x36, 0xe0, 0x34, 0xf8, 0x4a, 0xd9, 0xfa, 0x3e, 0x63, 0x78},
-                13,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0x75, 0xaf, 0x6b, 0x76, 0x1f, 0xae, 0x52, 0xb6, 0x08, 0x81, 0xbb, 0x3f, 0x53, 0x8e, 0x2a, 0x13},
-                {0xf0, 0x4d, 0x79, 0x02, 0xbf, 0xdf, 0x8a, 0x67, 0x01, 0x70, 0xb3, 0x1c, 0xbc, 0xc9, 0x5b, 0x29},
-                {0x79, 0x02, 0x4e, 0x7d, 0xc8, 0xaf, 0x9b, 0xf8, 0x7c, 0xc0, 0x2e, 0x43, 0x8f, 0x72, 0xf3, 0xa1},
-                14,
-            },
-            tuple<FlatState, FlatState, FlatState, size_t> {
-                {0xd8, 0x45, 0x80, 0xe1, 0x3c, 0x63, 0xf3, 0x7d, 0x5f, 0x50, 0x19, 0xcd, 0x72, 0x4d, 0x6d, 0x58},
-                {0xcf, 0xd8, 0x84, 0xf4, 0xd8, 0xd9, 0x04, 0xd6, 0x44, 0x24, 0xde, 0x2c, 0x3c, 0x3e, 0x90, 0x42},
-                {0x94, 0x19, 0x4c, 0x23, 0x63, 0x65, 0xbe, 0x2d, 0xca, 0x95, 0x91, 0x3d, 0xeb, 0x4e, 0x56, 0x16},
-                15,
-            },
-        };
-
-        cout << "Testing `second_stage::reduction`..." << endl;
-        unsigned int test_num = 0;
-        for (auto [Y, Y_, K10, fault_position] : tests) {
-            cout << "\tTest " << setw(2) << ++test_num << "... ";
-
-            auto stage1_results = first_stage::reduction(Y, Y_, fault_position);
-            single_case::reduction(Y, Y_, fault_position, stage1_results, K10);
-            
-            cout << "passed !" << endl;
-        }
-    }
-}
-}
-
-int main() {
-    second_stage::test::reduction();
-    return 0;
+#include "reductions.hpp"
+#include "../test_vectors.hpp"
+
+#include <cassert>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <tuple>
+
+using namespace std;
+
+namespace second_stage {
+namespace test {
+    namespace single_case {
+        void reduction(FlatState const& Y, FlatState const& Y_, size_t fault_position, array<vector<Row>, 4> const& stage1_results, FlatState const& K10)
+        {
+            auto keys = second_stage::reduction(Y, Y_, fault_position, stage1_results);
+            auto it = find(keys.begin(), keys.end(), K10);
+            assert (it != keys.end());
+        }
+
+        void join_reduction(FlatState const& Y, FlatState const& Y_, size_t fault_position, array<vector<Row>, 4> const& stage1_results, FlatState const& K10)
+        {
+            auto keys = second_stage::join_reduction(Y, Y_, fault_position, stage1_results);
+            assert (find(keys.begin(), keys.end(), K10) != keys.end());
+
+            // every candidate must pass the full round 8 check
+            for (auto const& key : keys)
+                assert (check_partial_decryption(Y, Y_, key, get_fault_mask(fault_position)));
+        }
+    }
+
+    void fault_models() {
+        FlatState K0 = {0xbb, 0x0f, 0x8a, 0xbe, 0x9d, 0xfc, 0x50, 0x5e, 0xdf, 0x8f, 0xbc, 0xca, 0xd4, 0x83, 0x27, 0xf2};
+        FlatState P  = readme::P;
+        FlatState K10 = get_last_round_key(K0);
+        size_t fault_position = 6;
+
+        Settings settings;
+        settings.engine = Engine::JOIN;
+
+        cout << "Testing fault models..." << endl;
+        unsigned int test_num = 0;
+        for (bool at_sbox_output : {false, true}) {
+            cout << "\tTest " << setw(2) << ++test_num << "... ";
+
+            auto Y  = encrypt_with_fault(P, K0, fault_position, 0x00, false);
+            auto Y_ = encrypt_with_fault(P, K0, fault_position, 0x10, at_sbox_output);
+
+            auto stage1_results = first_stage::reduction(Y, Y_, fault_position);
+            auto any = run(Y, Y_, fault_position, stage1_results, settings);
+
+            for (auto model : {FaultModel::bit_flip(), FaultModel::known_difference(0x10)}) {
+                model.at_sbox_output = at_sbox_output;
+
+                auto restricted_stage1 = first_stage::reduction(Y, Y_, fault_position, model);
+                for (size_t d = 0; d < 4; ++d) assert (restricted_stage1[d].size() <= stage1_results[d].size());
+
+                auto keys = run(Y, Y_, fault_position, restricted_stage1, settings, model);
+                assert (find(keys.begin(), keys.end(), K10) != keys.end());
+                assert (keys.size() < any.size());
+
+                // same candidates as filtering the unrestricted ones
+                for (auto const& key : keys) assert (find(any.begin(), any.end(), key) != any.end());
+                for (auto const& key : any) assert (model.admits(Y, Y_, key, fault_position) == (find(keys.begin(), keys.end(), key) != keys.end()));
+            }
+
+            // a wrong model rejects the key
+            auto wrong = FaultModel::known_difference(0x20);
+            wrong.at_sbox_output = at_sbox_output;
+            assert (!wrong.admits(Y, Y_, K10, fault_position));
+
+            cout << "passed !" << endl;
+        }
+        cout << endl;
+    }
+
+    void anytime() {
+        FlatState K0 = {0xbb, 0x0f, 0x8a, 0xbe, 0x9d, 0xfc, 0x50, 0x5e, 0xdf, 0x8f, 0xbc, 0xca, 0xd4, 0x83, 0x27, 0xf2};
+        FlatState P  = readme::P;
+        FlatState K10 = get_last_round_key(K0);
+        size_t fault_position = 6;
+
+        auto Y  = encrypt_with_fault(P, K0, fault_position, 0x00, false);
+        auto Y_ = encrypt_with_fault(P, K0, fault_position, 0x10, false);
+        auto stage1_results = first_stage::reduction(Y, Y_, fault_position);
+
+        Settings settings;
+        settings.engine = Engine::JOIN;
+        auto all = run(Y, Y_, fault_position, stage1_results, settings);
+        sort(all.begin(), all.end());
+
+        cout << "Testing the anytime second stage..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "	Test  1... ";
+
+        // past the deadline, nothing is searched
+        {
+            Control control;
+            control.deadline = chrono::steady_clock::now();
+            assert (run(Y, Y_, fault_position, stage1_results, settings, {}, &control).empty());
+            assert (control.cancelled && count(control.covered.begin(), control.covered.end(), 1) == 0);
+        }
+
+        // two runs, the second skipping what the first covered, find every key
+        {
+            Control first;
+            first.skip.assign(256, 0);
+            for (size_t eps = 0; eps < 256; eps += 2) first.skip[eps] = 1;
+            auto keys = run(Y, Y_, fault_position, stage1_results, settings, {}, &first);
+
+            Control second;
+            second.skip.assign(256, 0);
+            for (size_t eps = 1; eps < 256; eps += 2) second.skip[eps] = 1;
+            auto rest = run(Y, Y_, fault_position, stage1_results, settings, {}, &second);
+
+            assert (!first.cancelled && !second.cancelled && first.progress() == 1.0);
+            assert (count(first.covered.begin() + 1, first.covered.end(), 1) == 255);
+
+            keys.insert(keys.end(), rest.begin(), rest.end());
+            sort(keys.begin(), keys.end());
+            assert (keys == all);
+        }
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "	Test  2... ";
+
+        // the search stops on the key passing `accept`...
+        for (Engine engine : {Engine::JOIN, Engine::SWEEP, Engine::RANGE}) {
+            settings.engine = engine;
+
+            Control control;
+            control.accept = [&](FlatState const& key) { return key == K10; };
+            auto keys = run(Y, Y_, fault_position, stage1_results, settings, {}, &control);
+
+            assert (control.accepted && control.cancelled);
+            assert (find(keys.begin(), keys.end(), K10) != keys.end());
+        }
+
+        // ... and on the budget
+        settings.engine = Engine::JOIN;
+        Control control;
+        control.max_keys = 1;
+        auto keys = run(Y, Y_, fault_position, stage1_results, settings, {}, &control);
+
+        assert (control.cancelled && !control.accepted && !keys.empty() && keys.size() < all.size());
+        assert (count(control.covered.begin(), control.covered.end(), 1) < 255);
+
+        cout << "passed !" << endl;
+        cout << endl;
+    }
+
+    /**
+     * @brief Ciphertext of `P` under `K0`, with the round 8 entry state xored with `E`.
+     */
+    FlatState encrypt_with_faults(FlatState const& P, FlatState const& K0, FlatState const& E) {
+        auto keys = key_schedule_from_last_round_key(load(get_last_round_key(K0)));
+
+        __m128i s = _mm_xor_si128(load(P), keys[0]);
+        for (int round = 1; round < 8; ++round) s = _mm_aesenc_si128(s, keys[round]);
+
+        s = _mm_aesenc_si128(_mm_xor_si128(s, load(E)), keys[8]);
+        s = _mm_aesenc_si128(s, keys[9]);
+
+        return unload(_mm_aesenclast_si128(s, keys[10]));
+    }
+
+    void multi_byte_faults() {
+        FlatState K0 = {0xbb, 0x0f, 0x8a, 0xbe, 0x9d, 0xfc, 0x50, 0x5e, 0xdf, 0x8f, 0xbc, 0xca, 0xd4, 0x83, 0x27, 0xf2};
+        FlatState P  = readme::P;
+        FlatState K10 = get_last_round_key(K0);
+
+        // bytes 1 and 6 land in column 3 of the round 8 MixColumns input
+        FaultDescriptor fault {8, 1 << 1 | 1 << 6};
+        auto layout = make_layout(fault);
+
+        FlatState E {};
+        E[1] = 0x10;
+        E[6] = 0x3c;
+        auto Y  = encrypt_with_faults(P, K0, FlatState {});
+        auto Y_ = encrypt_with_faults(P, K0, E);
+
+        // the first antidiagonal known, 2^24 candidates are left
+        KeyHints hints;
+        for (size_t i : ANTIDIAGONALS[0]) {
+            hints.allowed_bytes[i].reset();
+            hints.allowed_bytes[i].set(K10[i]);
+        }
+
+        auto stage1_results = first_stage::reduction(Y, Y_, fault, hints);
+
+        Settings settings;
+        settings.engine = Engine::RANGE;
+        settings.kernel = Kernel::INTERLEAVED;
+
+        cout << "Testing multi-byte faults..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        for (size_t d = 0; d < 4; ++d) {
+            auto const& ind = ANTIDIAGONALS[d];
+            Row row {K10[ind[0]], K10[ind[1]], K10[ind[2]], K10[ind[3]]};
+            assert (find(stage1_results[d].begin(), stage1_results[d].end(), row) != stage1_results[d].end());
+        }
+
+        auto keys = run(Y, Y_, fault, stage1_results, settings);
+        assert (find(keys.begin(), keys.end(), K10) != keys.end());
+
+        // the faulted bytes may or may not change, the others must not
+        for (auto const& key : keys) assert (check_partial_decryption(Y, Y_, key, layout.fault_mask, layout.checked_mask));
+        assert (!check_partial_decryption(Y, Y_, K10, get_fault_mask(1)));
+
+        // 2 bytes of the column free, ~2^24 / 2^16 survivors, whatever the kernel or engine
+        assert (keys.size() > 1 && keys.size() < 4096);
+        for (Kernel kernel : {Kernel::SCALAR, Kernel::VAES, Kernel::COLUMN})
+            for (Engine engine : {Engine::SWEEP, Engine::JOIN}) {
+                Settings other = settings;
+                other.kernel = kernel;
+                other.engine = engine;
+
+                auto same = run(Y, Y_, fault, stage1_results, other);
+                assert (is_permutation(same.begin(), same.end(), keys.begin(), keys.end()));
+            }
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // shards split the key blocks, together covering each of them once
+        vector<u8> covered;
+        vector<FlatState> sharded;
+        for (size_t shard = 0; shard < 3; ++shard) {
+            Control control;
+            control.shard = shard;
+            control.shards = 3;
+
+            auto part = run(Y, Y_, fault, stage1_results, settings, {}, &control);
+            sharded.insert(sharded.end(), part.begin(), part.end());
+
+            assert (control.progress() == 1.0 && count(control.covered.begin(), control.covered.end(), 1) > 0);
+            if (covered.empty()) covered.assign(control.covered.size(), 0);
+            for (size_t block = 0; block < covered.size(); ++block) covered[block] += control.covered[block];
+        }
+
+        assert (covered.size() > 3 && count(covered.begin(), covered.end(), 1) == (ptrdiff_t) covered.size());
+        assert (is_permutation(sharded.begin(), sharded.end(), keys.begin(), keys.end()));
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 3... ";
+
+        // a single byte fault: the range sweep finds the keys of the sweep
+        auto Y1_ = encrypt_with_fault(P, K0, 6, 0x10, false);
+        auto single = first_stage::reduction(Y, Y1_, 6, hints);
+
+        Settings sweep_settings = settings;
+        sweep_settings.engine = Engine::SWEEP;
+
+        auto swept = run(Y, Y1_, 6, single, sweep_settings);
+        auto ranged = run(Y, Y1_, single_byte_fault(6), single, settings);
+        assert (find(ranged.begin(), ranged.end(), K10) != ranged.end());
+        assert (is_permutation(swept.begin(), swept.end(), ranged.begin(), ranged.end()));
+
+        // the column filter keeps the same keys, 64 at a time or not
+        for (Engine engine : {Engine::SWEEP, Engine::RANGE}) {
+            Settings column_settings = settings;
+            column_settings.engine = engine;
+            column_settings.kernel = Kernel::COLUMN;
+
+            auto filtered = run(Y, Y1_, 6, single, column_settings);
+            assert (is_permutation(filtered.begin(), filtered.end(), swept.begin(), swept.end()));
+        }
+
+        // and every engine shards
+        for (Engine engine : {Engine::SWEEP, Engine::JOIN, Engine::RANGE}) {
+            Settings sharded_settings = settings;
+            sharded_settings.engine = engine;
+
+            vector<FlatState> parts;
+            for (size_t shard = 0; shard < 2; ++shard) {
+                Control control;
+                control.shard = shard;
+                control.shards = 2;
+
+                auto part = run(Y, Y1_, 6, single, sharded_settings, {}, &control);
+                parts.insert(parts.end(), part.begin(), part.end());
+                assert (control.done == control.total);
+            }
+
+            assert (is_permutation(parts.begin(), parts.end(), swept.begin(), swept.end()));
+        }
+
+        cout << "passed !" << endl;
+        cout << endl;
+    }
+
+    void key_contributions() {
+        cout << "Testing `second_stage::get_key_contribution`..." << endl;
+        cout << "\tTest 1... ";
+
+        FlatState K10 = {0xb6, 0x14, 0xf1, 0x11, 0x74, 0x52, 0xa4, 0x58, 0x3d, 0x28, 0x7a, 0x2f, 0x61, 0x07, 0x43, 0xb6};
+
+        for (int i = 0; i < 1000; ++i) {
+            KeyContribution key {_mm_setzero_si128(), _mm_setzero_si128(), 0};
+            for (size_t d = 0; d < 4; ++d) {
+                auto const& ind = ANTIDIAGONALS[d];
+                key = key ^ get_key_contribution({K10[ind[0]], K10[ind[1]], K10[ind[2]], K10[ind[3]]}, d);
+            }
+            add_subword_rotword(key.x, key.k9imc);
+
+            __m128i k9 = single_step_key_inversion<0x36>(load(K10));
+            assert (unload(key.k10) == K10);
+            assert (unload(key.k9imc) == unload(_mm_aesimc_si128(k9)));
+
+            K10 = unload(k9); // next key...
+        }
+
+        cout << "passed !" << endl;
+        cout << endl;
+    }
+
+    void reduction() {
+        array tests = {
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0xbc, 0x3e, 0x68, 0x8f, 0x08, 0xe3, 0xfc, 0x21, 0x69, 0xfd, 0x5b, 0xbe, 0x91, 0x4e, 0xd9, 0x32},
+                {0x5e, 0x28, 0x21, 0x2d, 0xb6, 0x8c, 0xab, 0x31, 0x12, 0xf2, 0x1c, 0x8d, 0x47, 0x4f, 0xf0, 0xcf},
+                {0xe9, 0x32, 0xe8, 0x9a, 0x18, 0xcc, 0xda, 0xaa, 0x6a, 0x14, 0x0b, 0x6c, 0xd3, 0x74, 0x3a, 0x5e},
+                0,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0x77, 0x41, 0x2e, 0x88, 0x3d, 0xb6, 0x82, 0xd6, 0x1d, 0x6d, 0x8d, 0x2f, 0x37, 0x07, 0x79, 0x18},
+                {0x87, 0x1f, 0xe2, 0x39, 0x4b, 0x13, 0xb7, 0xc2, 0x0b, 0x37, 0x07, 0xa5, 0x58, 0xe5, 0x05, 0x1f},
+                {0x7c, 0xb4, 0x15, 0xa2, 0x09, 0x44, 0x0e, 0x66, 0xdf, 0x5c, 0xf2, 0x8b, 0xfb, 0x5b, 0x13, 0x35},
+                1,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0x45, 0xb5, 0x7c, 0x09, 0xd7, 0xee, 0x65, 0x79, 0x4b, 0x42, 0xd5, 0x8f, 0x27, 0x96, 0xc3, 0x67},
+                {0xca, 0x25, 0xa6, 0xe4, 0x3e, 0x1d, 0x51, 0x7d, 0x9c, 0xa4, 0xa1, 0x20, 0x02, 0xbe, 0xed, 0x65},
+                {0x77, 0xe1, 0x20, 0x9e, 0x7b, 0x53, 0xae, 0x42, 0xfb, 0x60, 0x53, 0x21, 0x6e, 0x2c, 0x1e, 0xe0},
+                2,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0x96, 0x5b, 0xde, 0x2d, 0x71, 0x0e, 0x4a, 0xf8, 0xd7, 0x76, 0x36, 0x05, 0x15, 0x2a, 0x20, 0x99},
+                {0x98, 0x1b, 0x47, 0x36, 0xf3, 0x28, 0xda, 0xe2, 0xb6, 0x84, 0xdc, 0x2a, 0x38, 0xf3, 0x1f, 0x12},
+                {0x27, 0xd3, 0x4d, 0x27, 0x19, 0x45, 0x86, 0xcd, 0x0e, 0xec, 0xc8, 0xe6, 0x54, 0xdf, 0x7d, 0x91},
+                3,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {        
+                {0x99, 0x08, 0x45, 0x0c, 0xaa, 0xb6, 0x47, 0x75, 0x64, 0x56, 0xcc, 0xd0, 0x86, 0x1a, 0x6f, 0x7b},
+                {0xa9, 0x1a, 0x9d, 0x67, 0x45, 0xe3, 0x53, 0x93, 0x9d, 0x52, 0x79, 0x52, 0xc5, 0xe5, 0x0e, 0xb1},
+                {0x71, 0x93, 0x78, 0x5c, 0x5f, 0x94, 0x4d, 0x83, 0x2a, 0x94, 0xbb, 0x41, 0x14, 0xf2, 0xcb, 0xe8},
+                4,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0x35, 0x6e, 0x64, 0xfd, 0x0a, 0x66, 0x42, 0x10, 0xa6, 0xdd, 0x55, 0x21, 0xbb, 0xda, 0xae, 0xfd},
+                {0x9a, 0x01, 0x1b, 0xff, 0x50, 0x3b, 0x8d, 0x33, 0xad, 0x1f, 0x2f, 0xbe, 0x87, 0x15, 0xd8, 0x2f},
+                {0x41, 0x02, 0x25, 0xae, 0x64, 0x83, 0x1b, 0xf6, 0x31, 0x31, 0x81, 0x26, 0xa1, 0x9f, 0x2f, 0xdb},
+                5,        
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0x98, 0xde, 0x47, 0x5e, 0x13, 0x90, 0x53, 0x2c, 0x2b, 0x40, 0x6d, 0x20, 0x14, 0x20, 0x4e, 0x4a},
+                {0xd4, 0xb5, 0xcf, 0x71, 0x02, 0x97, 0x40, 0xde, 0xba, 0x62, 0xb8, 0xaa, 0x02, 0x0d, 0x0e, 0x14},
+                {0x86, 0x72, 0x3b, 0x05, 0x87, 0x47, 0xb5, 0xb0, 0x93, 0xb1, 0xee, 0x7d, 0xcf, 0xee, 0x88, 0x1a},
+                6,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {           
+                {0xe3, 0x06, 0x03, 0xa6, 0x39, 0xfb, 0x19, 0x86, 0x35, 0x33, 0x6c, 0x83, 0xf5, 0x78, 0x7d, 0x8c},
+                {0x74, 0xdb, 0xdc, 0xd9, 0xc8, 0xdc, 0xe5, 0xea, 0x52, 0x47, 0xb3, 0x5b, 0x35, 0xc8, 0x91, 0x16},
+                {0xde, 0xab, 0x45, 0x35, 0x04, 0x0a, 0xb8, 0x95, 0x76, 0xca, 0xea, 0x03, 0xcb, 0x57, 0x5a, 0xf1},
+                7,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0xe5, 0xc4, 0x6e, 0x1d, 0xfb, 0x26, 0x4c, 0x7f, 0x21, 0xfa, 0x3e, 0x87, 0x29, 0x3a, 0x0d, 0xed},
+                {0x36, 0xa5, 0x51, 0xed, 0x94, 0x1f, 0x78, 0x91, 0x75, 0x91, 0xdc, 0x11, 0x87, 0x54, 0x79, 0xd3},
+                {0x3d, 0x1b, 0x0a, 0x64, 0x08, 0x12, 0xa3, 0xb3, 0xbd, 0x0c, 0xa1, 0xdc, 0xdb, 0xaf, 0x7a, 0xbc},
+                8,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0x71, 0x37, 0x53, 0x7f, 0x4c, 0x18, 0x21, 0x7c, 0x0b, 0x4c, 0x45, 0xbf, 0xe8, 0xa0, 0xe0, 0xc6},
+                {0xe2, 0x79, 0x30, 0xde, 0xe4, 0xce, 0x9a, 0x1b, 0x39, 0x6c, 0xf0, 0x9d, 0x37, 0xad, 0x67, 0x5b},
+                {0xd2, 0x54, 0xf9, 0x3f, 0x47, 0xd1, 0xaf, 0x2c, 0xe0, 0xc6, 0x14, 0xa3, 0x46, 0x23, 0x91, 0x41},
+                9,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0x44, 0xea, 0x69, 0x6d, 0xd7, 0xbc, 0xf0, 0xbe, 0x66, 0x28, 0x5d, 0xfb, 0x8c, 0x08, 0xdc, 0x2f},
+                {0xe8, 0x94, 0x0b, 0xba, 0x46, 0x18, 0x14, 0x47, 0x63, 0xaf, 0xf0, 0xb2, 0x57, 0x36, 0xc6, 0x71},
+                {0xe1, 0x49, 0xc6, 0x53, 0x3d, 0xfb, 0x1e, 0xcc, 0x9e, 0x81, 0x6e, 0xb7, 0xfd, 0x4f, 0x70, 0xb1},
+                10,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0x69, 0x51, 0x64, 0x80, 0xe3, 0xf2, 0xe5, 0x76, 0x02, 0xa2, 0x3a, 0xe6, 0x8f, 0xd9, 0x2f, 0xaf},
+                {0x77, 0xee, 0x57, 0xa9, 0xba, 0x30, 0x9f, 0x1f, 0x5a, 0x1c, 0xe5, 0xa8, 0x5f, 0xba, 0x6c, 0x5b},
+                {0x05, 0x74, 0xe8, 0xaa, 0xa5, 0x33, 0x76, 0xc8, 0x5a, 0xc1, 0x70, 0xc8, 0x05, 0xf7, 0x20, 0x6e},
+                11,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0x69, 0xb5, 0x2f, 0xd0, 0x20, 0x5a, 0x18, 0xf2, 0x2a, 0x3d, 0xd0, 0x67, 0x4d, 0xc7, 0x9b, 0x77},
+                {0xba, 0x01, 0xd9, 0x95, 0xd2, 0x3d, 0xb2, 0x4b, 0x10, 0xe7, 0x83, 0x62, 0xda, 0x1f, 0x01, 0xf5},
+                {0xfd, 0x6b, 0xe5, 0x70, 0xe5, 0x14, 0xbd, 0xcd, 0x4d, 0xb9, 0x58, 0xac, 0x95, 0xd6, 0x6e, 0x93},
+                12,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0xfe, 0x85, 0xfb, 0x65, 0x8a, 0x5c, 0x5d, 0xf8, 0x1f, 0x56, 0xf1, 0xc1, 0x18, 0x65, 0x77, 0xc4},
+                {0xf5, 0x1e, 0xfd, 0xde, 0x86, 0xce, 0x0c, 0x69, 0x46, 0x1d, 0xb3, 0x88, 0x83, 0x51, 0xfd, 0xff},
+                {0xeb, 0x31, 0xe1, 0x5f, 0xc3, 0xa7, 0x36, 0xe0, 0x34, 0xf8, 0x4a, 0xd9, 0xfa, 0x3e, 0x63, 0x78},
+                13,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0x75, 0xaf, 0x6b, 0x76, 0x1f, 0xae, 0x52, 0xb6, 0x08, 0x81, 0xbb, 0x3f, 0x53, 0x8e, 0x2a, 0x13},
+                {0xf0, 0x4d, 0x79, 0x02, 0xbf, 0xdf, 0x8a, 0x67, 0x01, 0x70, 0xb3, 0x1c, 0xbc, 0xc9, 0x5b, 0x29},
+                {0x79, 0x02, 0x4e, 0x7d, 0xc8, 0xaf, 0x9b, 0xf8, 0x7c, 0xc0, 0x2e, 0x43, 0x8f, 0x72, 0xf3, 0xa1},
+                14,
+            },
+            tuple<FlatState, FlatState, FlatState, size_t> {
+                {0xd8, 0x45, 0x80, 0xe1, 0x3c, 0x63, 0xf3, 0x7d, 0x5f, 0x50, 0x19, 0xcd, 0x72, 0x4d, 0x6d, 0x58},
+                {0xcf, 0xd8, 0x84, 0xf4, 0xd8, 0xd9, 0x04, 0xd6, 0x44, 0x24, 0xde, 0x2c, 0x3c, 0x3e, 0x90, 0x42},
+                {0x94, 0x19, 0x4c, 0x23, 0x63, 0x65, 0xbe, 0x2d, 0xca, 0x95, 0x91, 0x3d, 0xeb, 0x4e, 0x56, 0x16},
+                15,
+            },
+        };
+
+        cout << "Testing `second_stage::reduction`..." << endl;
+        unsigned int test_num = 0;
+        for (auto [Y, Y_, K10, fault_position] : tests) {
+            cout << "\tTest " << setw(2) << ++test_num << "... ";
+
+            auto stage1_results = first_stage::reduction(Y, Y_, fault_position);
+            single_case::join_reduction(Y, Y_, fault_position, stage1_results, K10);
+            single_case::reduction(Y, Y_, fault_position, stage1_results, K10);
+            
+            cout << "passed !" << endl;
+        }
+    }
+}
+}
+
+int main() {
+    second_stage::test::key_contributions();
+    second_stage::test::fault_models();
+    second_stage::test::anytime();
+    second_stage::test::multi_byte_faults();
+    second_stage::test::reduction();
+    return 0;
 }
\ No newline at end of file
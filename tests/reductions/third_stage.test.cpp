@@ -1,250 +1,254 @@
-#include "reductions.hpp"
-
-#include <cassert>
-#include <algorithm>
-#include <iostream>
-#include <iomanip>
-
-namespace third_stage {
-namespace test {
-    namespace single_case {
-        void reduction(FlatState const& ciphertext, FlatState const& plaintext, vector<FlatState> const& stage2_results, FlatState key) {
-            auto valid_keys = third_stage::reduction(ciphertext, plaintext, stage2_results);
-            auto it = find(valid_keys.begin(), valid_keys.end(), key);
-            assert (it != valid_keys.end());
-        }
-    }
-
-    void reduction() {
-        array tests = {
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xac, 0x6f, 0xfb, 0xe0, 0x4f, 0x7b, 0x90, 0xca, 0xdb, 0xc4, 0x68, 0x97, 0x19, 0xd7, 0x90, 0xcf},
-                {0x3a, 0x42, 0x6c, 0x56, 0x0e, 0x87, 0x10, 0x17, 0xfa, 0x92, 0x3b, 0x9d, 0x12, 0xe1, 0xa5, 0xd4},
-                {0x2d, 0xca, 0x20, 0x3a, 0xff, 0x81, 0x1d, 0xd1, 0x34, 0x49, 0x26, 0xd9, 0x84, 0xb3, 0x7f, 0x80},
-                {0x56, 0xad, 0x28, 0x3a, 0xbb, 0x34, 0x2f, 0xc8, 0x43, 0x22, 0xa3, 0xe1, 0x54, 0x4c, 0x24, 0xfc},
-                6
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x48, 0x3f, 0x73, 0x49, 0x3b, 0x7c, 0xa4, 0x1c, 0x26, 0x76, 0x41, 0x51, 0x33, 0x91, 0xfa, 0xd5},
-                {0xab, 0x71, 0x52, 0xc4, 0x5e, 0xb2, 0xb1, 0xf2, 0xce, 0xbd, 0xf5, 0x18, 0x4b, 0xc2, 0x4e, 0x90},
-                {0x54, 0xdc, 0x47, 0xe0, 0x5d, 0x62, 0x0b, 0x7b, 0x0b, 0x8a, 0x96, 0xde, 0xb5, 0x54, 0x16, 0xb1},
-                {0x23, 0x0d, 0xb5, 0x03, 0xa5, 0xc9, 0xee, 0x9c, 0x5e, 0x4f, 0x5f, 0xd7, 0x4a, 0xc4, 0x42, 0x3e},
-                7
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xed, 0xd0, 0x34, 0x61, 0x87, 0xee, 0x70, 0x84, 0x60, 0x5c, 0x7f, 0x5b, 0x98, 0xfe, 0xe9, 0x0b},
-                {0x63, 0xfe, 0x5d, 0x01, 0x2f, 0x13, 0x58, 0x02, 0x20, 0xf5, 0x42, 0xe3, 0x30, 0x5a, 0xce, 0xa3},
-                {0x6d, 0x47, 0x6f, 0xec, 0x06, 0xad, 0x78, 0xe1, 0xc1, 0xf3, 0xc2, 0x52, 0x7b, 0x72, 0x28, 0x64},
-                {0xcb, 0xf1, 0xc9, 0x58, 0xfe, 0x2a, 0x02, 0x49, 0xdd, 0xce, 0xfa, 0x9e, 0x46, 0x75, 0x45, 0xdf},
-                8
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x1a, 0x9a, 0x4f, 0x2b, 0x8b, 0x6b, 0xe1, 0xff, 0xd3, 0xda, 0x55, 0x2b, 0xb2, 0x1d, 0xc7, 0x20},
-                {0x7f, 0x4e, 0x55, 0x53, 0xde, 0x89, 0x1d, 0x8a, 0x0f, 0xf6, 0x94, 0x92, 0x98, 0x28, 0x05, 0x0f},
-                {0x5d, 0x8d, 0x39, 0x9c, 0x46, 0xb0, 0x15, 0x85, 0x35, 0xc3, 0x13, 0x4a, 0xd1, 0x2f, 0xba, 0x80},
-                {0x92, 0x40, 0xb1, 0x03, 0x02, 0x7d, 0x79, 0x3d, 0x8b, 0x66, 0xca, 0x95, 0x92, 0x7d, 0xcc, 0xe0},
-                12
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xa6, 0xb4, 0x09, 0x2a, 0x55, 0x22, 0x51, 0x7a, 0x98, 0xfa, 0x98, 0x43, 0xa5, 0x6b, 0x97, 0xe4},
-                {0x27, 0xc5, 0x69, 0xcf, 0xab, 0xa0, 0x3e, 0x2b, 0xb1, 0x63, 0xe6, 0x63, 0x85, 0xb2, 0x73, 0xfe},
-                {0xe5, 0xcb, 0x99, 0xd6, 0x70, 0x91, 0x6b, 0x9f, 0x4c, 0x1e, 0x90, 0x6c, 0x50, 0xe7, 0xde, 0x28},
-                {0x60, 0xa7, 0x41, 0x57, 0xf5, 0xb2, 0xfc, 0x7f, 0x80, 0x55, 0x74, 0x6a, 0x84, 0xe6, 0x2c, 0xa5},
-                11
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x9a, 0x01, 0xdc, 0x1b, 0x71, 0x24, 0x33, 0x54, 0x09, 0x7b, 0x62, 0xfe, 0xdb, 0x36, 0xbe, 0x36},
-                {0x60, 0xe7, 0x5c, 0x84, 0x6a, 0x1e, 0x79, 0x16, 0xab, 0x9d, 0x59, 0x1f, 0x27, 0xee, 0x62, 0x1d},
-                {0x46, 0xe3, 0x48, 0xc4, 0x20, 0x2d, 0xe8, 0x6c, 0x28, 0x4f, 0x3e, 0xc8, 0xca, 0x94, 0x2f, 0xc5},
-                {0x9c, 0xce, 0xdf, 0x67, 0xdb, 0xe2, 0x8f, 0x35, 0x23, 0xa8, 0x5a, 0x63, 0xb7, 0x82, 0x14, 0x9e},
-                5
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xbf, 0x06, 0x3b, 0xa6, 0xf3, 0x93, 0xce, 0x8f, 0x09, 0x7d, 0xac, 0x05, 0x70, 0x57, 0xbc, 0x8c},
-                {0x47, 0x61, 0x70, 0xba, 0x75, 0x5b, 0x57, 0xc2, 0x34, 0xb5, 0x58, 0x80, 0x3e, 0x7e, 0x45, 0x70},
-                {0x68, 0x3c, 0xc8, 0x02, 0xcf, 0xd5, 0x34, 0x1c, 0xc8, 0x12, 0x6b, 0xf2, 0x40, 0xc1, 0x5c, 0xae},
-                {0x44, 0x3a, 0x88, 0x37, 0x67, 0x9d, 0x6c, 0x2b, 0x60, 0x6a, 0x24, 0x27, 0x4b, 0xaa, 0xf6, 0xb9},
-                1
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xf1, 0x03, 0x62, 0x60, 0x47, 0x2b, 0x75, 0x4b, 0xf4, 0x7a, 0x72, 0xa7, 0xe5, 0x2c, 0x36, 0x3b},
-                {0xd4, 0xf9, 0xb7, 0x6e, 0xff, 0x71, 0x4a, 0xe8, 0xe2, 0x18, 0xed, 0x17, 0x5d, 0xab, 0xbe, 0x4e},
-                {0x99, 0xd6, 0x9a, 0x2a, 0x1f, 0xa3, 0x5c, 0xea, 0xfa, 0x4c, 0x59, 0xf3, 0xca, 0xea, 0x5e, 0x96},
-                {0x67, 0x6c, 0x0f, 0xa3, 0x50, 0x88, 0x38, 0x2f, 0xbf, 0x8d, 0xc3, 0xc7, 0x4c, 0x1a, 0xee, 0x3b},
-                2
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xa7, 0xbf, 0x09, 0x98, 0x3b, 0x13, 0x86, 0xf0, 0x77, 0xa0, 0x94, 0xda, 0x4a, 0x6d, 0x6e, 0x9b},
-                {0x94, 0x4a, 0x86, 0x0b, 0x37, 0x5e, 0x46, 0x69, 0x11, 0x9e, 0xaa, 0x3c, 0x43, 0x5e, 0x57, 0xa6},
-                {0xab, 0x1d, 0xd9, 0x53, 0x6e, 0x08, 0x51, 0x68, 0x0c, 0x97, 0xa9, 0x43, 0x33, 0xa2, 0x35, 0xdb},
-                {0x88, 0xec, 0x36, 0x37, 0x41, 0x88, 0xb9, 0xa4, 0x91, 0xf1, 0x76, 0xcc, 0xfc, 0x18, 0x87, 0x72},
-                2
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x49, 0x1d, 0x52, 0x70, 0x80, 0xea, 0x66, 0x17, 0x5e, 0x0b, 0x4e, 0x51, 0xdf, 0xda, 0xaa, 0xa7},
-                {0x5f, 0x7f, 0x42, 0xa6, 0xb0, 0x7c, 0x60, 0x9a, 0xf3, 0x20, 0x98, 0x7b, 0xb2, 0xd8, 0x9a, 0x79},
-                {0x43, 0x16, 0xfe, 0xfc, 0x5d, 0x0c, 0x57, 0xb4, 0x6e, 0x4d, 0x86, 0xcd, 0xd2, 0x9e, 0x0f, 0xc6},
-                {0x66, 0x80, 0x05, 0x97, 0xcf, 0xdc, 0x5f, 0xc4, 0xbd, 0xdf, 0xe4, 0x1b, 0x5a, 0x51, 0x97, 0x0f},
-                14
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x05, 0xa5, 0x66, 0x9b, 0x2f, 0x3b, 0x46, 0xd6, 0xd3, 0x6c, 0x10, 0xf3, 0xcf, 0x85, 0x99, 0xce},
-                {0x0b, 0x13, 0x9b, 0xc7, 0x44, 0x4b, 0xf6, 0x2e, 0x5d, 0x14, 0xe7, 0x98, 0xd0, 0x49, 0xb5, 0x4f},
-                {0x75, 0x3d, 0xd7, 0x22, 0x82, 0x55, 0x9b, 0x91, 0xf1, 0x1b, 0xde, 0xac, 0x8a, 0x9f, 0x79, 0xac},
-                {0x18, 0x82, 0xa0, 0x79, 0x63, 0x75, 0x62, 0x0c, 0x46, 0x76, 0x71, 0x98, 0xc8, 0xe2, 0xd7, 0xd2},
-                8
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x6c, 0xab, 0xd7, 0xfc, 0x0a, 0xf7, 0xaa, 0xfd, 0xdc, 0xc2, 0x23, 0x27, 0x3d, 0x30, 0x90, 0x08},
-                {0xe1, 0x01, 0xc6, 0xb5, 0x5e, 0xd6, 0xea, 0x63, 0x23, 0x62, 0x61, 0x78, 0x23, 0xaa, 0x00, 0x1b},
-                {0x11, 0x08, 0x37, 0x2a, 0xc5, 0x3d, 0x55, 0xde, 0xf9, 0x72, 0xfc, 0xe6, 0xd6, 0x29, 0xa2, 0x91},
-                {0xde, 0xb0, 0x09, 0x49, 0x63, 0xe7, 0xb6, 0xb9, 0xd9, 0x59, 0x15, 0x60, 0xed, 0x81, 0x82, 0x3d},
-                4
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xc2, 0x78, 0xa8, 0xe4, 0xd9, 0xb4, 0xa1, 0x24, 0xc9, 0x6a, 0x2a, 0x59, 0xe2, 0xee, 0xe7, 0x19},
-                {0xa7, 0x7a, 0xc2, 0xe8, 0x1b, 0x38, 0x5c, 0x37, 0x00, 0x3b, 0x30, 0xa6, 0xfe, 0xef, 0x79, 0x73},
-                {0x7a, 0x75, 0x21, 0xa8, 0xf0, 0xfc, 0x10, 0x66, 0xcb, 0xb6, 0x08, 0xfd, 0x8d, 0x2c, 0x86, 0x8e},
-                {0x37, 0x51, 0x9f, 0xb3, 0x04, 0x0d, 0xfb, 0x58, 0x5b, 0xa6, 0x25, 0x70, 0x80, 0x45, 0x7c, 0xb8},
-                14
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xaa, 0xdb, 0x49, 0x12, 0xad, 0xb1, 0x5a, 0x31, 0x3a, 0x40, 0x51, 0xe2, 0xa1, 0x33, 0x5e, 0x77},
-                {0x7a, 0xbb, 0xec, 0x48, 0x70, 0x57, 0x6f, 0x60, 0x34, 0xf9, 0x45, 0x46, 0x17, 0xda, 0x72, 0x45},
-                {0x15, 0x6f, 0x37, 0xd4, 0xcb, 0xb5, 0x01, 0xd7, 0x48, 0x33, 0x0f, 0x80, 0x3b, 0x7a, 0x35, 0x9e},
-                {0xf2, 0x36, 0xeb, 0x9b, 0x5c, 0xd8, 0xd7, 0x08, 0x6f, 0x1d, 0xd5, 0x8b, 0x6d, 0x65, 0xb3, 0x9c},
-                3
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x1e, 0xe4, 0xce, 0x96, 0x27, 0xa1, 0x17, 0x1d, 0x3f, 0x8b, 0x8d, 0x6b, 0xdb, 0x05, 0x0c, 0xef},
-                {0x5c, 0xb0, 0x0d, 0xe4, 0xd4, 0xbc, 0x0d, 0x95, 0x34, 0x12, 0x9f, 0xc8, 0x65, 0xb4, 0x0a, 0x4b},
-                {0xd6, 0xff, 0x63, 0x2d, 0x6f, 0x78, 0x30, 0x70, 0xff, 0xbb, 0xc8, 0xef, 0x5c, 0xbe, 0x66, 0x9f},
-                {0xdf, 0xb5, 0x4d, 0xab, 0x31, 0x5f, 0xe6, 0x6b, 0x5d, 0x5b, 0xe0, 0xc4, 0x7b, 0x8b, 0xce, 0x96},
-                2
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xa0, 0x1b, 0xb4, 0xca, 0x64, 0xa5, 0x5f, 0xc7, 0x09, 0xd2, 0x46, 0x72, 0xf9, 0x3a, 0x96, 0x51},
-                {0x4b, 0x5a, 0xbd, 0x04, 0xc9, 0xf9, 0xf0, 0x01, 0x44, 0xa3, 0xae, 0x2b, 0xc9, 0x81, 0x8f, 0xa0},
-                {0xa5, 0x8b, 0xf7, 0xd2, 0x5b, 0x1e, 0x6b, 0x73, 0xfc, 0xef, 0x0c, 0x41, 0xec, 0x7f, 0x78, 0x28},
-                {0x53, 0x4e, 0x1d, 0x8a, 0xd0, 0xa0, 0xb8, 0x7b, 0xc1, 0xcf, 0xa9, 0x35, 0xb1, 0xcf, 0xf1, 0x06},
-                7
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xac, 0x11, 0x42, 0xb7, 0xb5, 0x2b, 0x0a, 0xf2, 0x32, 0x6b, 0x32, 0xa1, 0xb9, 0x0c, 0xd9, 0xc6},
-                {0xce, 0x53, 0xe5, 0x34, 0x25, 0x74, 0x64, 0x52, 0x55, 0x29, 0x5b, 0x24, 0x93, 0xc1, 0xa5, 0xf5},
-                {0x67, 0x20, 0xc8, 0xa3, 0x8c, 0xf5, 0xd8, 0x0f, 0x5b, 0x32, 0xe1, 0x33, 0x31, 0x07, 0xee, 0x7c},
-                {0x5a, 0x07, 0x0b, 0xae, 0xc4, 0xf7, 0xdc, 0x13, 0x3f, 0x6e, 0x33, 0x53, 0x55, 0xaf, 0x73, 0x89},
-                13
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x9c, 0x98, 0xfb, 0x48, 0x43, 0xb5, 0x5a, 0xff, 0x6c, 0x23, 0x9c, 0x08, 0x2d, 0x62, 0xe0, 0x6e},
-                {0xdd, 0x3c, 0x22, 0x0e, 0x4d, 0x57, 0x9a, 0x68, 0xa3, 0x10, 0x37, 0x3a, 0x17, 0x04, 0x23, 0x02},
-                {0x92, 0x1f, 0xe7, 0x9c, 0xee, 0xec, 0xcc, 0x26, 0x73, 0xfa, 0x2a, 0x12, 0x78, 0xf0, 0xc7, 0xf2},
-                {0x9a, 0xc9, 0x8e, 0xd3, 0x3f, 0x99, 0xc3, 0x25, 0x4f, 0x1c, 0xe2, 0xa3, 0x7f, 0x3f, 0x9c, 0x98},
-                3
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x2f, 0x3e, 0x53, 0xba, 0x67, 0xc3, 0x01, 0x93, 0xe1, 0x72, 0x39, 0x56, 0x2b, 0x69, 0x9e, 0x56},
-                {0xe5, 0xfe, 0xef, 0x5d, 0x45, 0x5b, 0x89, 0xc3, 0x0e, 0x89, 0x1e, 0xc7, 0xdd, 0x49, 0x16, 0xdb},
-                {0xab, 0x6b, 0x32, 0x74, 0x5e, 0x5a, 0xe5, 0xbf, 0xa7, 0xcb, 0xc9, 0xb3, 0x3a, 0x35, 0xd7, 0x82},
-                {0x8b, 0xc3, 0x3d, 0xf4, 0xde, 0xee, 0x3a, 0x86, 0x38, 0xb1, 0xe8, 0x25, 0xf3, 0xff, 0xf3, 0x40},
-                1
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x12, 0x1a, 0x76, 0x06, 0x54, 0x42, 0x55, 0x0e, 0x08, 0x84, 0x3e, 0x3b, 0x01, 0x95, 0x8c, 0x3c},
-                {0xd1, 0xa7, 0x7a, 0x7b, 0x1e, 0xc3, 0xc0, 0x84, 0xed, 0xac, 0xfa, 0x73, 0x9c, 0xf3, 0xca, 0xbd},
-                {0x99, 0xf2, 0x7c, 0xa5, 0xb4, 0xd2, 0xca, 0x6d, 0x6e, 0x7c, 0xea, 0x0b, 0x65, 0xc9, 0xd8, 0x6b},
-                {0x8e, 0x89, 0x4e, 0xa6, 0xef, 0xa4, 0x9f, 0xac, 0x0e, 0x31, 0x3c, 0x7d, 0x05, 0x76, 0x4b, 0x96},
-                15
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x47, 0x90, 0xa4, 0x73, 0x50, 0x56, 0xaf, 0xdc, 0xeb, 0x49, 0x2b, 0x51, 0x6d, 0xb9, 0xda, 0xc2},
-                {0x65, 0xef, 0x23, 0xb6, 0x10, 0xd4, 0xee, 0xf9, 0xfe, 0xec, 0x98, 0x55, 0xc4, 0x10, 0x4d, 0x30},
-                {0x7e, 0xb1, 0xbe, 0x9c, 0x19, 0x3d, 0xd1, 0xf5, 0xd5, 0xbb, 0x4f, 0x23, 0x09, 0x88, 0xf6, 0xc5},
-                {0xe2, 0x8b, 0x7d, 0x25, 0x8b, 0x69, 0xf0, 0x70, 0x7e, 0xe7, 0xf5, 0x64, 0xaa, 0x17, 0x05, 0x63},
-                5
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xec, 0xdb, 0x17, 0x1d, 0x18, 0x5f, 0x2c, 0x1e, 0x4e, 0x22, 0x66, 0xd6, 0x20, 0xe7, 0x8f, 0x6a},
-                {0x4e, 0xc7, 0x7d, 0xf9, 0x08, 0x35, 0x79, 0x81, 0xb5, 0x2a, 0x13, 0x4d, 0x0a, 0x4b, 0x5c, 0xfb},
-                {0x9f, 0xfe, 0x49, 0xeb, 0x49, 0x03, 0x50, 0x50, 0x49, 0x4f, 0x6c, 0x0b, 0x3f, 0xc3, 0x42, 0x3d},
-                {0xcc, 0xc1, 0x0d, 0xb6, 0xe9, 0x64, 0xe8, 0xa4, 0x80, 0x56, 0xaf, 0x25, 0x68, 0x6d, 0x16, 0xca},
-                13
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xda, 0x2d, 0x49, 0x79, 0xc3, 0x68, 0xbe, 0xfd, 0x8f, 0x12, 0x0d, 0xd8, 0x45, 0x2e, 0x35, 0x37},
-                {0xb9, 0xff, 0x49, 0x6c, 0x7b, 0x08, 0x56, 0x12, 0x1d, 0x83, 0x42, 0x6b, 0x2b, 0x14, 0x20, 0x6e},
-                {0x59, 0x3a, 0xfe, 0xb9, 0x6f, 0x90, 0x15, 0xa3, 0xc1, 0x1f, 0xc7, 0x99, 0x73, 0xe7, 0x83, 0x5c},
-                {0xf9, 0xb5, 0x66, 0x40, 0x01, 0xbe, 0xf2, 0x5f, 0x59, 0x63, 0x65, 0x3f, 0x0e, 0x66, 0x5a, 0x5d},
-                8
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x8f, 0xdd, 0x57, 0x54, 0xf5, 0x72, 0x22, 0x28, 0xce, 0xa4, 0xd5, 0x31, 0x8c, 0x2a, 0xff, 0x10},
-                {0x45, 0x96, 0xcc, 0xa8, 0x66, 0x86, 0x65, 0xe0, 0x52, 0x6c, 0x7e, 0xf0, 0xd0, 0x5a, 0x66, 0x58},
-                {0xb1, 0xab, 0x6c, 0x8c, 0x99, 0x41, 0x82, 0x3d, 0x2b, 0xcd, 0x5d, 0xfa, 0xa4, 0x32, 0x4d, 0x97},
-                {0x6f, 0xba, 0x76, 0x29, 0x83, 0x4f, 0x90, 0xe3, 0x1b, 0xe1, 0x5d, 0xc5, 0x68, 0xf6, 0xa0, 0xb5},
-                10
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x9d, 0xd1, 0x88, 0xf3, 0xfe, 0x36, 0xbb, 0xa3, 0xa8, 0x07, 0xd1, 0xdb, 0x3e, 0xd1, 0x00, 0xed},
-                {0x57, 0x80, 0xb7, 0x92, 0x12, 0x16, 0xb1, 0x1c, 0x83, 0xec, 0x1d, 0xf7, 0xd2, 0xbc, 0x21, 0x4b},
-                {0xd5, 0x55, 0xe0, 0xfc, 0x78, 0x37, 0x14, 0x03, 0x15, 0x3c, 0x74, 0x9a, 0x3a, 0xaa, 0xc7, 0x88},
-                {0xa8, 0x47, 0x3d, 0xb2, 0xb2, 0x03, 0x35, 0x91, 0x35, 0xc3, 0x50, 0x0c, 0xc3, 0xcb, 0x5d, 0x77},
-                10
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x55, 0x36, 0xd9, 0x0c, 0x76, 0x83, 0xe7, 0x08, 0xcc, 0x45, 0x53, 0x94, 0x7e, 0x95, 0x43, 0x5d},
-                {0x97, 0xf4, 0x8a, 0xa2, 0x00, 0x83, 0xdd, 0xae, 0xda, 0xbe, 0xd6, 0xc0, 0x64, 0x98, 0x13, 0x59},
-                {0x74, 0x58, 0x10, 0xb3, 0xfa, 0xaf, 0x36, 0x20, 0x25, 0xe6, 0xc1, 0x42, 0x76, 0xc1, 0x17, 0x6c},
-                {0xe8, 0xe4, 0xc4, 0xd9, 0x81, 0x3a, 0x72, 0xef, 0x68, 0xae, 0x5f, 0xc7, 0xe0, 0x1f, 0xba, 0x29},
-                13
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x3c, 0x73, 0x46, 0xf0, 0x74, 0xf7, 0xba, 0x0e, 0x90, 0x5b, 0xe3, 0xd6, 0x0a, 0x9f, 0xe0, 0x26},
-                {0x4d, 0xe1, 0xf9, 0x8c, 0xf3, 0x19, 0xfa, 0x42, 0xdd, 0xa2, 0x94, 0xd8, 0x15, 0x57, 0x10, 0xd5},
-                {0xe0, 0x06, 0xcb, 0xcc, 0xf4, 0xdc, 0x65, 0xa7, 0xab, 0x71, 0xe2, 0xc8, 0xc9, 0xf6, 0x48, 0xd2},
-                {0x80, 0xaa, 0x35, 0x4e, 0x7f, 0x19, 0x74, 0xae, 0x82, 0x1d, 0xe3, 0xf5, 0x48, 0xae, 0xb5, 0xa2},
-                1
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xf4, 0xd8, 0x96, 0xae, 0x62, 0xbc, 0x98, 0x7e, 0x1f, 0x20, 0xad, 0xe5, 0xa7, 0xcf, 0x9d, 0x07},
-                {0x97, 0x6f, 0x89, 0x9a, 0xe3, 0xd9, 0x3c, 0x9c, 0xe8, 0x29, 0x6e, 0x42, 0x61, 0x14, 0x0d, 0x83},
-                {0x6b, 0x26, 0xc6, 0x2f, 0x4f, 0xcd, 0x4f, 0x93, 0xc3, 0x7c, 0x10, 0xcc, 0x33, 0xd1, 0x40, 0xe6},
-                {0x69, 0xda, 0x66, 0x9a, 0x2b, 0x76, 0x0d, 0xa2, 0x54, 0x54, 0xe4, 0xc7, 0x15, 0x14, 0x57, 0x57},
-                12
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0xdb, 0xa3, 0x87, 0x9c, 0xa7, 0x0f, 0x5d, 0xb7, 0x23, 0xa9, 0x9e, 0x04, 0xdf, 0xf0, 0xa6, 0x87},
-                {0x0a, 0x9e, 0xf4, 0x67, 0xf8, 0x54, 0xac, 0xcd, 0x99, 0xa5, 0xb5, 0x1e, 0xd0, 0x45, 0x22, 0xdc},
-                {0x6a, 0x46, 0xd7, 0x53, 0x88, 0x5e, 0x20, 0x52, 0xb1, 0x88, 0xfd, 0x7c, 0xb6, 0x10, 0xd8, 0xbf},
-                {0x61, 0xae, 0xea, 0xd3, 0x22, 0xfd, 0x92, 0x63, 0x17, 0x20, 0xcd, 0x42, 0xc9, 0x52, 0x7f, 0xfe},
-                11
-            },
-            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
-                {0x1b, 0x30, 0x64, 0x26, 0xab, 0xb2, 0x3a, 0x18, 0x97, 0x84, 0x2d, 0xe3, 0xff, 0x08, 0x42, 0x4f},
-                {0xa4, 0xf2, 0x63, 0x79, 0xde, 0xe8, 0x8a, 0x8e, 0x7b, 0xef, 0x1f, 0xdb, 0xfb, 0x3f, 0xff, 0xd4},
-                {0xe2, 0x27, 0x50, 0x38, 0x3c, 0x08, 0x56, 0x75, 0x7e, 0xd9, 0x0b, 0x53, 0x7d, 0x84, 0x92, 0xc0},
-                {0x72, 0x0e, 0x15, 0x0e, 0xfe, 0x88, 0x75, 0xd8, 0x35, 0xd9, 0x3b, 0x7c, 0x01, 0x8c, 0x8c, 0x2e},
-                11
-            },
-        };
-
-        cout << "Testing `third_stage::reduction`..." << endl;
-        unsigned int test_num = 0;
-        for (auto& [X, Y, Y_, K, fault_position] : tests) {
-            cout << "\tTest " << setw(2) << ++test_num << "... ";
-
-            auto stage1_results = first_stage::reduction(Y, Y_, fault_position);
-            auto stage2_results = second_stage::reduction(Y, Y_, fault_position, stage1_results);
-            single_case::reduction(Y, X, stage2_results, K);
-
-            cout << "passed !" << endl;
-        }
-    }
-}
-}
-
-int main() {
-    third_stage::test::reduction();
-    return 0;
+#include "reductions.hpp"
+
+#include <cassert>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <tuple>
+
+namespace third_stage {
+namespace test {
+    namespace single_case {
+        void reduction(FlatState const& ciphertext, FlatState const& plaintext, vector<FlatState> const& stage2_results, FlatState key) {
+            auto valid_keys = third_stage::reduction(ciphertext, plaintext, stage2_results);
+            auto it = find(valid_keys.begin(), valid_keys.end(), key);
+            assert (it != valid_keys.end());
+
+            // both round key inversions keep the same keys, in the same order
+            assert (third_stage::reduction(ciphertext, plaintext, stage2_results, KeyInversion::AESENCLAST) == valid_keys);
+        }
+    }
+
+    void reduction() {
+        array tests = {
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xac, 0x6f, 0xfb, 0xe0, 0x4f, 0x7b, 0x90, 0xca, 0xdb, 0xc4, 0x68, 0x97, 0x19, 0xd7, 0x90, 0xcf},
+                {0x3a, 0x42, 0x6c, 0x56, 0x0e, 0x87, 0x10, 0x17, 0xfa, 0x92, 0x3b, 0x9d, 0x12, 0xe1, 0xa5, 0xd4},
+                {0x2d, 0xca, 0x20, 0x3a, 0xff, 0x81, 0x1d, 0xd1, 0x34, 0x49, 0x26, 0xd9, 0x84, 0xb3, 0x7f, 0x80},
+                {0x56, 0xad, 0x28, 0x3a, 0xbb, 0x34, 0x2f, 0xc8, 0x43, 0x22, 0xa3, 0xe1, 0x54, 0x4c, 0x24, 0xfc},
+                6
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x48, 0x3f, 0x73, 0x49, 0x3b, 0x7c, 0xa4, 0x1c, 0x26, 0x76, 0x41, 0x51, 0x33, 0x91, 0xfa, 0xd5},
+                {0xab, 0x71, 0x52, 0xc4, 0x5e, 0xb2, 0xb1, 0xf2, 0xce, 0xbd, 0xf5, 0x18, 0x4b, 0xc2, 0x4e, 0x90},
+                {0x54, 0xdc, 0x47, 0xe0, 0x5d, 0x62, 0x0b, 0x7b, 0x0b, 0x8a, 0x96, 0xde, 0xb5, 0x54, 0x16, 0xb1},
+                {0x23, 0x0d, 0xb5, 0x03, 0xa5, 0xc9, 0xee, 0x9c, 0x5e, 0x4f, 0x5f, 0xd7, 0x4a, 0xc4, 0x42, 0x3e},
+                7
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xed, 0xd0, 0x34, 0x61, 0x87, 0xee, 0x70, 0x84, 0x60, 0x5c, 0x7f, 0x5b, 0x98, 0xfe, 0xe9, 0x0b},
+                {0x63, 0xfe, 0x5d, 0x01, 0x2f, 0x13, 0x58, 0x02, 0x20, 0xf5, 0x42, 0xe3, 0x30, 0x5a, 0xce, 0xa3},
+                {0x6d, 0x47, 0x6f, 0xec, 0x06, 0xad, 0x78, 0xe1, 0xc1, 0xf3, 0xc2, 0x52, 0x7b, 0x72, 0x28, 0x64},
+                {0xcb, 0xf1, 0xc9, 0x58, 0xfe, 0x2a, 0x02, 0x49, 0xdd, 0xce, 0xfa, 0x9e, 0x46, 0x75, 0x45, 0xdf},
+                8
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x1a, 0x9a, 0x4f, 0x2b, 0x8b, 0x6b, 0xe1, 0xff, 0xd3, 0xda, 0x55, 0x2b, 0xb2, 0x1d, 0xc7, 0x20},
+                {0x7f, 0x4e, 0x55, 0x53, 0xde, 0x89, 0x1d, 0x8a, 0x0f, 0xf6, 0x94, 0x92, 0x98, 0x28, 0x05, 0x0f},
+                {0x5d, 0x8d, 0x39, 0x9c, 0x46, 0xb0, 0x15, 0x85, 0x35, 0xc3, 0x13, 0x4a, 0xd1, 0x2f, 0xba, 0x80},
+                {0x92, 0x40, 0xb1, 0x03, 0x02, 0x7d, 0x79, 0x3d, 0x8b, 0x66, 0xca, 0x95, 0x92, 0x7d, 0xcc, 0xe0},
+                12
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xa6, 0xb4, 0x09, 0x2a, 0x55, 0x22, 0x51, 0x7a, 0x98, 0xfa, 0x98, 0x43, 0xa5, 0x6b, 0x97, 0xe4},
+                {0x27, 0xc5, 0x69, 0xcf, 0xab, 0xa0, 0x3e, 0x2b, 0xb1, 0x63, 0xe6, 0x63, 0x85, 0xb2, 0x73, 0xfe},
+                {0xe5, 0xcb, 0x99, 0xd6, 0x70, 0x91, 0x6b, 0x9f, 0x4c, 0x1e, 0x90, 0x6c, 0x50, 0xe7, 0xde, 0x28},
+                {0x60, 0xa7, 0x41, 0x57, 0xf5, 0xb2, 0xfc, 0x7f, 0x80, 0x55, 0x74, 0x6a, 0x84, 0xe6, 0x2c, 0xa5},
+                11
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x9a, 0x01, 0xdc, 0x1b, 0x71, 0x24, 0x33, 0x54, 0x09, 0x7b, 0x62, 0xfe, 0xdb, 0x36, 0xbe, 0x36},
+                {0x60, 0xe7, 0x5c, 0x84, 0x6a, 0x1e, 0x79, 0x16, 0xab, 0x9d, 0x59, 0x1f, 0x27, 0xee, 0x62, 0x1d},
+                {0x46, 0xe3, 0x48, 0xc4, 0x20, 0x2d, 0xe8, 0x6c, 0x28, 0x4f, 0x3e, 0xc8, 0xca, 0x94, 0x2f, 0xc5},
+                {0x9c, 0xce, 0xdf, 0x67, 0xdb, 0xe2, 0x8f, 0x35, 0x23, 0xa8, 0x5a, 0x63, 0xb7, 0x82, 0x14, 0x9e},
+                5
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xbf, 0x06, 0x3b, 0xa6, 0xf3, 0x93, 0xce, 0x8f, 0x09, 0x7d, 0xac, 0x05, 0x70, 0x57, 0xbc, 0x8c},
+                {0x47, 0x61, 0x70, 0xba, 0x75, 0x5b, 0x57, 0xc2, 0x34, 0xb5, 0x58, 0x80, 0x3e, 0x7e, 0x45, 0x70},
+                {0x68, 0x3c, 0xc8, 0x02, 0xcf, 0xd5, 0x34, 0x1c, 0xc8, 0x12, 0x6b, 0xf2, 0x40, 0xc1, 0x5c, 0xae},
+                {0x44, 0x3a, 0x88, 0x37, 0x67, 0x9d, 0x6c, 0x2b, 0x60, 0x6a, 0x24, 0x27, 0x4b, 0xaa, 0xf6, 0xb9},
+                1
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xf1, 0x03, 0x62, 0x60, 0x47, 0x2b, 0x75, 0x4b, 0xf4, 0x7a, 0x72, 0xa7, 0xe5, 0x2c, 0x36, 0x3b},
+                {0xd4, 0xf9, 0xb7, 0x6e, 0xff, 0x71, 0x4a, 0xe8, 0xe2, 0x18, 0xed, 0x17, 0x5d, 0xab, 0xbe, 0x4e},
+                {0x99, 0xd6, 0x9a, 0x2a, 0x1f, 0xa3, 0x5c, 0xea, 0xfa, 0x4c, 0x59, 0xf3, 0xca, 0xea, 0x5e, 0x96},
+                {0x67, 0x6c, 0x0f, 0xa3, 0x50, 0x88, 0x38, 0x2f, 0xbf, 0x8d, 0xc3, 0xc7, 0x4c, 0x1a, 0xee, 0x3b},
+                2
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xa7, 0xbf, 0x09, 0x98, 0x3b, 0x13, 0x86, 0xf0, 0x77, 0xa0, 0x94, 0xda, 0x4a, 0x6d, 0x6e, 0x9b},
+                {0x94, 0x4a, 0x86, 0x0b, 0x37, 0x5e, 0x46, 0x69, 0x11, 0x9e, 0xaa, 0x3c, 0x43, 0x5e, 0x57, 0xa6},
+                {0xab, 0x1d, 0xd9, 0x53, 0x6e, 0x08, 0x51, 0x68, 0x0c, 0x97, 0xa9, 0x43, 0x33, 0xa2, 0x35, 0xdb},
+                {0x88, 0xec, 0x36, 0x37, 0x41, 0x88, 0xb9, 0xa4, 0x91, 0xf1, 0x76, 0xcc, 0xfc, 0x18, 0x87, 0x72},
+                2
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x49, 0x1d, 0x52, 0x70, 0x80, 0xea, 0x66, 0x17, 0x5e, 0x0b, 0x4e, 0x51, 0xdf, 0xda, 0xaa, 0xa7},
+                {0x5f, 0x7f, 0x42, 0xa6, 0xb0, 0x7c, 0x60, 0x9a, 0xf3, 0x20, 0x98, 0x7b, 0xb2, 0xd8, 0x9a, 0x79},
+                {0x43, 0x16, 0xfe, 0xfc, 0x5d, 0x0c, 0x57, 0xb4, 0x6e, 0x4d, 0x86, 0xcd, 0xd2, 0x9e, 0x0f, 0xc6},
+                {0x66, 0x80, 0x05, 0x97, 0xcf, 0xdc, 0x5f, 0xc4, 0xbd, 0xdf, 0xe4, 0x1b, 0x5a, 0x51, 0x97, 0x0f},
+                14
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x05, 0xa5, 0x66, 0x9b, 0x2f, 0x3b, 0x46, 0xd6, 0xd3, 0x6c, 0x10, 0xf3, 0xcf, 0x85, 0x99, 0xce},
+                {0x0b, 0x13, 0x9b, 0xc7, 0x44, 0x4b, 0xf6, 0x2e, 0x5d, 0x14, 0xe7, 0x98, 0xd0, 0x49, 0xb5, 0x4f},
+                {0x75, 0x3d, 0xd7, 0x22, 0x82, 0x55, 0x9b, 0x91, 0xf1, 0x1b, 0xde, 0xac, 0x8a, 0x9f, 0x79, 0xac},
+                {0x18, 0x82, 0xa0, 0x79, 0x63, 0x75, 0x62, 0x0c, 0x46, 0x76, 0x71, 0x98, 0xc8, 0xe2, 0xd7, 0xd2},
+                8
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x6c, 0xab, 0xd7, 0xfc, 0x0a, 0xf7, 0xaa, 0xfd, 0xdc, 0xc2, 0x23, 0x27, 0x3d, 0x30, 0x90, 0x08},
+                {0xe1, 0x01, 0xc6, 0xb5, 0x5e, 0xd6, 0xea, 0x63, 0x23, 0x62, 0x61, 0x78, 0x23, 0xaa, 0x00, 0x1b},
+                {0x11, 0x08, 0x37, 0x2a, 0xc5, 0x3d, 0x55, 0xde, 0xf9, 0x72, 0xfc, 0xe6, 0xd6, 0x29, 0xa2, 0x91},
+                {0xde, 0xb0, 0x09, 0x49, 0x63, 0xe7, 0xb6, 0xb9, 0xd9, 0x59, 0x15, 0x60, 0xed, 0x81, 0x82, 0x3d},
+                4
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xc2, 0x78, 0xa8, 0xe4, 0xd9, 0xb4, 0xa1, 0x24, 0xc9, 0x6a, 0x2a, 0x59, 0xe2, 0xee, 0xe7, 0x19},
+                {0xa7, 0x7a, 0xc2, 0xe8, 0x1b, 0x38, 0x5c, 0x37, 0x00, 0x3b, 0x30, 0xa6, 0xfe, 0xef, 0x79, 0x73},
+                {0x7a, 0x75, 0x21, 0xa8, 0xf0, 0xfc, 0x10, 0x66, 0xcb, 0xb6, 0x08, 0xfd, 0x8d, 0x2c, 0x86, 0x8e},
+                {0x37, 0x51, 0x9f, 0xb3, 0x04, 0x0d, 0xfb, 0x58, 0x5b, 0xa6, 0x25, 0x70, 0x80, 0x45, 0x7c, 0xb8},
+                14
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xaa, 0xdb, 0x49, 0x12, 0xad, 0xb1, 0x5a, 0x31, 0x3a, 0x40, 0x51, 0xe2, 0xa1, 0x33, 0x5e, 0x77},
+                {0x7a, 0xbb, 0xec, 0x48, 0x70, 0x57, 0x6f, 0x60, 0x34, 0xf9, 0x45, 0x46, 0x17, 0xda, 0x72, 0x45},
+                {0x15, 0x6f, 0x37, 0xd4, 0xcb, 0xb5, 0x01, 0xd7, 0x48, 0x33, 0x0f, 0x80, 0x3b, 0x7a, 0x35, 0x9e},
+                {0xf2, 0x36, 0xeb, 0x9b, 0x5c, 0xd8, 0xd7, 0x08, 0x6f, 0x1d, 0xd5, 0x8b, 0x6d, 0x65, 0xb3, 0x9c},
+                3
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x1e, 0xe4, 0xce, 0x96, 0x27, 0xa1, 0x17, 0x1d, 0x3f, 0x8b, 0x8d, 0x6b, 0xdb, 0x05, 0x0c, 0xef},
+                {0x5c, 0xb0, 0x0d, 0xe4, 0xd4, 0xbc, 0x0d, 0x95, 0x34, 0x12, 0x9f, 0xc8, 0x65, 0xb4, 0x0a, 0x4b},
+                {0xd6, 0xff, 0x63, 0x2d, 0x6f, 0x78, 0x30, 0x70, 0xff, 0xbb, 0xc8, 0xef, 0x5c, 0xbe, 0x66, 0x9f},
+                {0xdf, 0xb5, 0x4d, 0xab, 0x31, 0x5f, 0xe6, 0x6b, 0x5d, 0x5b, 0xe0, 0xc4, 0x7b, 0x8b, 0xce, 0x96},
+                2
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xa0, 0x1b, 0xb4, 0xca, 0x64, 0xa5, 0x5f, 0xc7, 0x09, 0xd2, 0x46, 0x72, 0xf9, 0x3a, 0x96, 0x51},
+                {0x4b, 0x5a, 0xbd, 0x04, 0xc9, 0xf9, 0xf0, 0x01, 0x44, 0xa3, 0xae, 0x2b, 0xc9, 0x81, 0x8f, 0xa0},
+                {0xa5, 0x8b, 0xf7, 0xd2, 0x5b, 0x1e, 0x6b, 0x73, 0xfc, 0xef, 0x0c, 0x41, 0xec, 0x7f, 0x78, 0x28},
+                {0x53, 0x4e, 0x1d, 0x8a, 0xd0, 0xa0, 0xb8, 0x7b, 0xc1, 0xcf, 0xa9, 0x35, 0xb1, 0xcf, 0xf1, 0x06},
+                7
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xac, 0x11, 0x42, 0xb7, 0xb5, 0x2b, 0x0a, 0xf2, 0x32, 0x6b, 0x32, 0xa1, 0xb9, 0x0c, 0xd9, 0xc6},
+                {0xce, 0x53, 0xe5, 0x34, 0x25, 0x74, 0x64, 0x52, 0x55, 0x29, 0x5b, 0x24, 0x93, 0xc1, 0xa5, 0xf5},
+                {0x67, 0x20, 0xc8, 0xa3, 0x8c, 0xf5, 0xd8, 0x0f, 0x5b, 0x32, 0xe1, 0x33, 0x31, 0x07, 0xee, 0x7c},
+                {0x5a, 0x07, 0x0b, 0xae, 0xc4, 0xf7, 0xdc, 0x13, 0x3f, 0x6e, 0x33, 0x53, 0x55, 0xaf, 0x73, 0x89},
+                13
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x9c, 0x98, 0xfb, 0x48, 0x43, 0xb5, 0x5a, 0xff, 0x6c, 0x23, 0x9c, 0x08, 0x2d, 0x62, 0xe0, 0x6e},
+                {0xdd, 0x3c, 0x22, 0x0e, 0x4d, 0x57, 0x9a, 0x68, 0xa3, 0x10, 0x37, 0x3a, 0x17, 0x04, 0x23, 0x02},
+                {0x92, 0x1f, 0xe7, 0x9c, 0xee, 0xec, 0xcc, 0x26, 0x73, 0xfa, 0x2a, 0x12, 0x78, 0xf0, 0xc7, 0xf2},
+                {0x9a, 0xc9, 0x8e, 0xd3, 0x3f, 0x99, 0xc3, 0x25, 0x4f, 0x1c, 0xe2, 0xa3, 0x7f, 0x3f, 0x9c, 0x98},
+                3
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x2f, 0x3e, 0x53, 0xba, 0x67, 0xc3, 0x01, 0x93, 0xe1, 0x72, 0x39, 0x56, 0x2b, 0x69, 0x9e, 0x56},
+                {0xe5, 0xfe, 0xef, 0x5d, 0x45, 0x5b, 0x89, 0xc3, 0x0e, 0x89, 0x1e, 0xc7, 0xdd, 0x49, 0x16, 0xdb},
+                {0xab, 0x6b, 0x32, 0x74, 0x5e, 0x5a, 0xe5, 0xbf, 0xa7, 0xcb, 0xc9, 0xb3, 0x3a, 0x35, 0xd7, 0x82},
+                {0x8b, 0xc3, 0x3d, 0xf4, 0xde, 0xee, 0x3a, 0x86, 0x38, 0xb1, 0xe8, 0x25, 0xf3, 0xff, 0xf3, 0x40},
+                1
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x12, 0x1a, 0x76, 0x06, 0x54, 0x42, 0x55, 0x0e, 0x08, 0x84, 0x3e, 0x3b, 0x01, 0x95, 0x8c, 0x3c},
+                {0xd1, 0xa7, 0x7a, 0x7b, 0x1e, 0xc3, 0xc0, 0x84, 0xed, 0xac, 0xfa, 0x73, 0x9c, 0xf3, 0xca, 0xbd},
+                {0x99, 0xf2, 0x7c, 0xa5, 0xb4, 0xd2, 0xca, 0x6d, 0x6e, 0x7c, 0xea, 0x0b, 0x65, 0xc9, 0xd8, 0x6b},
+                {0x8e, 0x89, 0x4e, 0xa6, 0xef, 0xa4, 0x9f, 0xac, 0x0e, 0x31, 0x3c, 0x7d, 0x05, 0x76, 0x4b, 0x96},
+                15
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x47, 0x90, 0xa4, 0x73, 0x50, 0x56, 0xaf, 0xdc, 0xeb, 0x49, 0x2b, 0x51, 0x6d, 0xb9, 0xda, 0xc2},
+                {0x65, 0xef, 0x23, 0xb6, 0x10, 0xd4, 0xee, 0xf9, 0xfe, 0xec, 0x98, 0x55, 0xc4, 0x10, 0x4d, 0x30},
+                {0x7e, 0xb1, 0xbe, 0x9c, 0x19, 0x3d, 0xd1, 0xf5, 0xd5, 0xbb, 0x4f, 0x23, 0x09, 0x88, 0xf6, 0xc5},
+                {0xe2, 0x8b, 0x7d, 0x25, 0x8b, 0x69, 0xf0, 0x70, 0x7e, 0xe7, 0xf5, 0x64, 0xaa, 0x17, 0x05, 0x63},
+                5
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xec, 0xdb, 0x17, 0x1d, 0x18, 0x5f, 0x2c, 0x1e, 0x4e, 0x22, 0x66, 0xd6, 0x20, 0xe7, 0x8f, 0x6a},
+                {0x4e, 0xc7, 0x7d, 0xf9, 0x08, 0x35, 0x79, 0x81, 0xb5, 0x2a, 0x13, 0x4d, 0x0a, 0x4b, 0x5c, 0xfb},
+                {0x9f, 0xfe, 0x49, 0xeb, 0x49, 0x03, 0x50, 0x50, 0x49, 0x4f, 0x6c, 0x0b, 0x3f, 0xc3, 0x42, 0x3d},
+                {0xcc, 0xc1, 0x0d, 0xb6, 0xe9, 0x64, 0xe8, 0xa4, 0x80, 0x56, 0xaf, 0x25, 0x68, 0x6d, 0x16, 0xca},
+                13
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xda, 0x2d, 0x49, 0x79, 0xc3, 0x68, 0xbe, 0xfd, 0x8f, 0x12, 0x0d, 0xd8, 0x45, 0x2e, 0x35, 0x37},
+                {0xb9, 0xff, 0x49, 0x6c, 0x7b, 0x08, 0x56, 0x12, 0x1d, 0x83, 0x42, 0x6b, 0x2b, 0x14, 0x20, 0x6e},
+                {0x59, 0x3a, 0xfe, 0xb9, 0x6f, 0x90, 0x15, 0xa3, 0xc1, 0x1f, 0xc7, 0x99, 0x73, 0xe7, 0x83, 0x5c},
+                {0xf9, 0xb5, 0x66, 0x40, 0x01, 0xbe, 0xf2, 0x5f, 0x59, 0x63, 0x65, 0x3f, 0x0e, 0x66, 0x5a, 0x5d},
+                8
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x8f, 0xdd, 0x57, 0x54, 0xf5, 0x72, 0x22, 0x28, 0xce, 0xa4, 0xd5, 0x31, 0x8c, 0x2a, 0xff, 0x10},
+                {0x45, 0x96, 0xcc, 0xa8, 0x66, 0x86, 0x65, 0xe0, 0x52, 0x6c, 0x7e, 0xf0, 0xd0, 0x5a, 0x66, 0x58},
+                {0xb1, 0xab, 0x6c, 0x8c, 0x99, 0x41, 0x82, 0x3d, 0x2b, 0xcd, 0x5d, 0xfa, 0xa4, 0x32, 0x4d, 0x97},
+                {0x6f, 0xba, 0x76, 0x29, 0x83, 0x4f, 0x90, 0xe3, 0x1b, 0xe1, 0x5d, 0xc5, 0x68, 0xf6, 0xa0, 0xb5},
+                10
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x9d, 0xd1, 0x88, 0xf3, 0xfe, 0x36, 0xbb, 0xa3, 0xa8, 0x07, 0xd1, 0xdb, 0x3e, 0xd1, 0x00, 0xed},
+                {0x57, 0x80, 0xb7, 0x92, 0x12, 0x16, 0xb1, 0x1c, 0x83, 0xec, 0x1d, 0xf7, 0xd2, 0xbc, 0x21, 0x4b},
+                {0xd5, 0x55, 0xe0, 0xfc, 0x78, 0x37, 0x14, 0x03, 0x15, 0x3c, 0x74, 0x9a, 0x3a, 0xaa, 0xc7, 0x88},
+                {0xa8, 0x47, 0x3d, 0xb2, 0xb2, 0x03, 0x35, 0x91, 0x35, 0xc3, 0x50, 0x0c, 0xc3, 0xcb, 0x5d, 0x77},
+                10
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x55, 0x36, 0xd9, 0x0c, 0x76, 0x83, 0xe7, 0x08, 0xcc, 0x45, 0x53, 0x94, 0x7e, 0x95, 0x43, 0x5d},
+                {0x97, 0xf4, 0x8a, 0xa2, 0x00, 0x83, 0xdd, 0xae, 0xda, 0xbe, 0xd6, 0xc0, 0x64, 0x98, 0x13, 0x59},
+                {0x74, 0x58, 0x10, 0xb3, 0xfa, 0xaf, 0x36, 0x20, 0x25, 0xe6, 0xc1, 0x42, 0x76, 0xc1, 0x17, 0x6c},
+                {0xe8, 0xe4, 0xc4, 0xd9, 0x81, 0x3a, 0x72, 0xef, 0x68, 0xae, 0x5f, 0xc7, 0xe0, 0x1f, 0xba, 0x29},
+                13
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x3c, 0x73, 0x46, 0xf0, 0x74, 0xf7, 0xba, 0x0e, 0x90, 0x5b, 0xe3, 0xd6, 0x0a, 0x9f, 0xe0, 0x26},
+                {0x4d, 0xe1, 0xf9, 0x8c, 0xf3, 0x19, 0xfa, 0x42, 0xdd, 0xa2, 0x94, 0xd8, 0x15, 0x57, 0x10, 0xd5},
+                {0xe0, 0x06, 0xcb, 0xcc, 0xf4, 0xdc, 0x65, 0xa7, 0xab, 0x71, 0xe2, 0xc8, 0xc9, 0xf6, 0x48, 0xd2},
+                {0x80, 0xaa, 0x35, 0x4e, 0x7f, 0x19, 0x74, 0xae, 0x82, 0x1d, 0xe3, 0xf5, 0x48, 0xae, 0xb5, 0xa2},
+                1
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xf4, 0xd8, 0x96, 0xae, 0x62, 0xbc, 0x98, 0x7e, 0x1f, 0x20, 0xad, 0xe5, 0xa7, 0xcf, 0x9d, 0x07},
+                {0x97, 0x6f, 0x89, 0x9a, 0xe3, 0xd9, 0x3c, 0x9c, 0xe8, 0x29, 0x6e, 0x42, 0x61, 0x14, 0x0d, 0x83},
+                {0x6b, 0x26, 0xc6, 0x2f, 0x4f, 0xcd, 0x4f, 0x93, 0xc3, 0x7c, 0x10, 0xcc, 0x33, 0xd1, 0x40, 0xe6},
+                {0x69, 0xda, 0x66, 0x9a, 0x2b, 0x76, 0x0d, 0xa2, 0x54, 0x54, 0xe4, 0xc7, 0x15, 0x14, 0x57, 0x57},
+                12
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0xdb, 0xa3, 0x87, 0x9c, 0xa7, 0x0f, 0x5d, 0xb7, 0x23, 0xa9, 0x9e, 0x04, 0xdf, 0xf0, 0xa6, 0x87},
+                {0x0a, 0x9e, 0xf4, 0x67, 0xf8, 0x54, 0xac, 0xcd, 0x99, 0xa5, 0xb5, 0x1e, 0xd0, 0x45, 0x22, 0xdc},
+                {0x6a, 0x46, 0xd7, 0x53, 0x88, 0x5e, 0x20, 0x52, 0xb1, 0x88, 0xfd, 0x7c, 0xb6, 0x10, 0xd8, 0xbf},
+                {0x61, 0xae, 0xea, 0xd3, 0x22, 0xfd, 0x92, 0x63, 0x17, 0x20, 0xcd, 0x42, 0xc9, 0x52, 0x7f, 0xfe},
+                11
+            },
+            tuple<FlatState, FlatState, FlatState, FlatState, size_t> {
+                {0x1b, 0x30, 0x64, 0x26, 0xab, 0xb2, 0x3a, 0x18, 0x97, 0x84, 0x2d, 0xe3, 0xff, 0x08, 0x42, 0x4f},
+                {0xa4, 0xf2, 0x63, 0x79, 0xde, 0xe8, 0x8a, 0x8e, 0x7b, 0xef, 0x1f, 0xdb, 0xfb, 0x3f, 0xff, 0xd4},
+                {0xe2, 0x27, 0x50, 0x38, 0x3c, 0x08, 0x56, 0x75, 0x7e, 0xd9, 0x0b, 0x53, 0x7d, 0x84, 0x92, 0xc0},
+                {0x72, 0x0e, 0x15, 0x0e, 0xfe, 0x88, 0x75, 0xd8, 0x35, 0xd9, 0x3b, 0x7c, 0x01, 0x8c, 0x8c, 0x2e},
+                11
+            },
+        };
+
+        cout << "Testing `third_stage::reduction`..." << endl;
+        unsigned int test_num = 0;
+        for (auto& [X, Y, Y_, K, fault_position] : tests) {
+            cout << "\tTest " << setw(2) << ++test_num << "... ";
+
+            auto stage1_results = first_stage::reduction(Y, Y_, fault_position);
+            auto stage2_results = second_stage::reduction(Y, Y_, fault_position, stage1_results);
+            single_case::reduction(Y, X, stage2_results, K);
+
+            cout << "passed !" << endl;
+        }
+    }
+}
+}
+
+int main() {
+    third_stage::test::reduction();
+    return 0;
 }
\ No newline at end of file
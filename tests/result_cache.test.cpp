@@ -0,0 +1,137 @@
+#include "result_cache.hpp"
+#include "test_vectors.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace result_cache {
+namespace test {
+    using readme::Y, readme::Y_;
+
+    vector<FlatState> keys(size_t count, u8 seed) {
+        vector<FlatState> keys(count);
+        for (size_t i = 0; i < count; ++i)
+            for (size_t j = 0; j < 16; ++j) keys[i][j] = seed + i * 16 + j;
+
+        return keys;
+    }
+
+    void fingerprint() {
+        cout << "Testing `result_cache::fingerprint`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        auto reference = result_cache::fingerprint(Y, Y_, {8}, KeyHints(), FaultModel());
+
+        // every input of the second stage counts...
+        assert (result_cache::fingerprint(Y_, Y, {8}, KeyHints(), FaultModel()) != reference);
+        assert (result_cache::fingerprint(Y, Y_, {9}, KeyHints(), FaultModel()) != reference);
+        assert (result_cache::fingerprint(Y, Y_, {8}, KeyHints(), FaultModel::bit_flip()) != reference);
+        assert (result_cache::fingerprint(Y, Y_, {8}, KeyHints(), FaultModel::stuck_at(0)) != reference);
+
+        FaultModel at_sbox_output;
+        at_sbox_output.at_sbox_output = true;
+        assert (result_cache::fingerprint(Y, Y_, {8}, KeyHints(), at_sbox_output) != reference);
+
+        KeyHints hints;
+        hints.allowed_bytes[3].reset(0x1f);
+        assert (result_cache::fingerprint(Y, Y_, {8}, hints, FaultModel()) != reference);
+
+        // ... but not the order of the positions nor of the candidate keys
+        assert (result_cache::fingerprint(Y, Y_, {0, 5, 10, 15}, KeyHints(), FaultModel()) == result_cache::fingerprint(Y, Y_, {15, 10, 5, 0}, KeyHints(), FaultModel()));
+
+        KeyHints a, b;
+        a.last_round_keys = keys(2, 0);
+        b.last_round_keys = {a.last_round_keys[1], a.last_round_keys[0]};
+        assert (result_cache::fingerprint(Y, Y_, {8}, a, FaultModel()) == result_cache::fingerprint(Y, Y_, {8}, b, FaultModel()));
+
+        cout << "passed !" << endl;
+    }
+
+    void cache() {
+        char directory_template[] = "/tmp/result_cache.test.XXXXXX";
+        string directory = string(mkdtemp(directory_template)) + "/results";
+
+        auto entry_size = [](string const& fingerprint, size_t count) { return sizeof(Header) + fingerprint.size() + count * sizeof(FlatState); };
+
+        cout << "Testing `result_cache::Cache`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // round trip, through a directory created on the first store
+        auto fingerprint_a = result_cache::fingerprint(Y, Y_, {8}, KeyHints(), FaultModel());
+        auto fingerprint_b = result_cache::fingerprint(Y, Y_, {9}, KeyHints(), FaultModel());
+        auto fingerprint_c = result_cache::fingerprint(Y, Y_, {10}, KeyHints(), FaultModel());
+
+        Cache cache(directory, entry_size(fingerprint_a, 100) * 2);
+        vector<FlatState> found;
+        string error;
+
+        assert (!cache.lookup(fingerprint_a, found));
+        assert (cache.store(fingerprint_a, keys(100, 1), error));
+        assert (cache.lookup(fingerprint_a, found) && found == keys(100, 1));
+        assert (!cache.lookup(fingerprint_b, found));
+
+        // empty results are results too
+        assert (cache.store(fingerprint_b, {}, error));
+        assert (cache.lookup(fingerprint_b, found) && found.empty());
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // least recently used entry evicted first
+        assert (cache.store(fingerprint_b, keys(100, 2), error));
+        this_thread::sleep_for(chrono::milliseconds(20));
+        assert (cache.lookup(fingerprint_a, found));
+        this_thread::sleep_for(chrono::milliseconds(20));
+        assert (cache.store(fingerprint_c, keys(100, 3), error));
+
+        assert (cache.lookup(fingerprint_a, found) && found == keys(100, 1));
+        assert (!cache.lookup(fingerprint_b, found));
+        assert (cache.lookup(fingerprint_c, found) && found == keys(100, 3));
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 3... ";
+
+        // threads storing the same entry at the same time each write their own temporary file
+        {
+            vector<thread> threads;
+            vector<char> stored(8);
+            for (size_t t = 0; t < stored.size(); ++t)
+                threads.emplace_back([&, t] {
+                    string thread_error;
+                    stored[t] = cache.store(fingerprint_a, keys(100, 16 * t), thread_error);
+                });
+            for (auto& thread : threads) thread.join();
+
+            for (char ok : stored) assert (ok);
+        }
+
+        bool whole = false;
+        assert (cache.lookup(fingerprint_a, found));
+        for (size_t t = 0; t < 8; ++t) whole |= (found == keys(100, 16 * t));
+        assert (whole);
+
+        // nothing left but the entries, the directory being empty once they are evicted
+        Cache(directory, 1).evict();
+        assert (rmdir(directory.c_str()) == 0);
+        rmdir(directory_template);
+        cout << "passed !" << endl;
+    }
+}
+}
+
+int main() {
+    result_cache::test::fingerprint();
+    result_cache::test::cache();
+    return 0;
+}
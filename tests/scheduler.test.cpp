@@ -0,0 +1,187 @@
+#include "scheduler.hpp"
+#include "test_vectors.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace scheduler {
+namespace test {
+    // allocations to fail on the workers, making a job throw
+    atomic<int> worker_allocation_failures {0};
+    thread::id main_thread = this_thread::get_id();
+}
+}
+
+void* operator new(size_t size) {
+    using namespace scheduler::test;
+    if (worker_allocation_failures > 0 && this_thread::get_id() != main_thread && worker_allocation_failures-- > 0) throw bad_alloc();
+
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+namespace scheduler {
+namespace test {
+    FlatState key = readme::K0;
+
+    // README example, the round 10 key bytes of `known_antidiagonals` given as hints
+    Request readme_request(second_stage::Engine engine, initializer_list<size_t> known_antidiagonals, bool with_plaintext) {
+        Request request;
+        request.regular = readme::Y;
+        request.faulted = readme::Y_;
+        request.fault_positions = {readme::fault_position};
+        request.has_plaintext = with_plaintext;
+        request.plaintext = readme::P;
+        request.settings.engine = engine;
+
+        auto K10 = get_last_round_key(key);
+        for (size_t antidiagonal : known_antidiagonals)
+            for (size_t index : ANTIDIAGONALS[antidiagonal]) {
+                request.hints.allowed_bytes[index].reset();
+                request.hints.allowed_bytes[index].set(K10[index]);
+            }
+
+        return request;
+    }
+
+    // initial keys of the whole second stage run in one go
+    vector<FlatState> sequential_keys(Request const& request) {
+        auto stage1_results = first_stage::reduction(request.regular, request.faulted, request.fault_positions.front(), request.hints);
+
+        vector<FlatState> keys;
+        for (auto const& K10 : second_stage::run(request.regular, request.faulted, request.fault_positions.front(), stage1_results, request.settings))
+            keys.push_back(get_initial_key(K10));
+
+        sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+    void chunks() {
+        Scheduler scheduler(2);
+
+        cout << "Testing chunked second stages..." << endl;
+        unsigned int test_num = 0;
+        for (auto request : {readme_request(second_stage::Engine::JOIN, {}, false), readme_request(second_stage::Engine::SWEEP, {1, 2}, false)}) {
+            cout << "\tTest " << ++test_num << "... ";
+
+            // the chunks cover the second stage exactly once
+            auto result = scheduler.submit(request).get();
+            sort(result.keys.begin(), result.keys.end());
+
+            assert (!result.cancelled);
+            assert (result.keys == sequential_keys(request));
+            assert (find(result.keys.begin(), result.keys.end(), key) != result.keys.end());
+
+            request.has_plaintext = true;
+            result = scheduler.submit(request).get();
+            assert (result.keys == vector<FlatState>({key}));
+
+            // the round 10 keys, plaintext or not, when the third stage is left out
+            request.last_round_keys = true;
+            result = scheduler.submit(request).get();
+            for (auto& K10 : result.keys) K10 = get_initial_key(K10);
+            sort(result.keys.begin(), result.keys.end());
+            assert (result.keys == sequential_keys(request));
+
+            cout << "passed !" << endl;
+        }
+
+        cout << "\tTest " << ++test_num << "... ";
+
+        // a request without fault position is rejected, the workers going on
+        auto request = readme_request(second_stage::Engine::JOIN, {}, true);
+        request.fault_positions.clear();
+
+        auto rejected = scheduler.submit(request);
+        assert (rejected.ready());
+
+        bool thrown = false;
+        try {
+            rejected.get();
+        } catch (invalid_argument const&) {
+            thrown = true;
+        }
+        assert (thrown);
+
+        request.fault_positions = {8};
+        assert (scheduler.submit(request).get().keys == vector<FlatState>({key}));
+
+        cout << "passed !" << endl;
+        cout << "\tTest " << ++test_num << "... ";
+
+        // a job whose first stage throws fails through its future, the workers going on
+        worker_allocation_failures = 1;
+        auto failed = scheduler.submit(request);
+
+        thrown = false;
+        try {
+            failed.get();
+        } catch (bad_alloc const&) {
+            thrown = true;
+        }
+        assert (thrown && worker_allocation_failures == 0);
+
+        assert (scheduler.submit(request).get().keys == vector<FlatState>({key}));
+
+        cout << "passed !" << endl;
+    }
+
+    void sharing() {
+        Scheduler scheduler(1);
+
+        cout << "Testing worker sharing..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // a small job gets through while a long sweep runs
+        auto long_job = scheduler.submit(readme_request(second_stage::Engine::SWEEP, {}, true), Priority::LOW);
+        while (long_job.progress() == 0) this_thread::sleep_for(chrono::milliseconds(10));
+
+        auto start = chrono::steady_clock::now();
+        auto small_job = scheduler.submit(readme_request(second_stage::Engine::SWEEP, {1, 2, 3}, true));
+        auto result = small_job.get();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        assert (result.keys == vector<FlatState>({key}));
+        assert (seconds < 10);
+        assert (!long_job.ready());
+
+        long_job.cancel();
+        assert (long_job.get().cancelled);
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // a high priority job overtakes an earlier low priority one
+        auto low  = scheduler.submit(readme_request(second_stage::Engine::SWEEP, {2}, true), Priority::LOW);
+        auto high = scheduler.submit(readme_request(second_stage::Engine::SWEEP, {2}, true), Priority::HIGH);
+
+        assert (high.get().keys == vector<FlatState>({key}));
+        assert (!low.ready());
+        assert (low.get().keys == vector<FlatState>({key}));
+
+        cout << "passed !" << endl;
+    }
+}
+}
+
+int main() {
+    scheduler::test::chunks();
+    scheduler::test::sharing();
+    return 0;
+}
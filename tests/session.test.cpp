@@ -0,0 +1,153 @@
+#include "session.hpp"
+#include "test_vectors.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace session {
+namespace test {
+    using readme::K0, readme::P, readme::Y, readme::Y_;
+
+    void refine() {
+        FlatState K10 = get_last_round_key(K0);
+
+        second_stage::Settings settings;
+        settings.engine = second_stage::Engine::JOIN;
+
+        Session session;
+
+        cout << "Testing `session::add_capture` and `session::add_pair`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // a pair alone can't bound the key space
+        assert (!add_pair(session, P, Y));
+        assert (!session.initialized && session.pairs == 0);
+
+        add_capture(session, Y, Y_, {8}, {}, settings);
+        auto first = session.last_round_keys;
+        assert (session.initialized && session.captures == 1);
+        assert (first.size() > 1 && find(first.begin(), first.end(), K10) != first.end());
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // a second capture of another column only keeps the candidates fitting both
+        FlatState P2 = P;
+        P2[0] ^= 0xff;
+        auto Y2  = encrypt_with_fault(P2, K0, 3, 0);
+        auto Y2_ = encrypt_with_fault(P2, K0, 3, 0x5a);
+        add_capture(session, Y2, Y2_, {3}, {}, settings);
+
+        auto& kept = session.last_round_keys;
+        assert (session.captures == 2 && kept.size() < first.size());
+        assert (find(kept.begin(), kept.end(), K10) != kept.end());
+        for (auto const& key : kept) {
+            assert (find(first.begin(), first.end(), key) != first.end());
+            assert (check_partial_decryption(Y2, Y2_, key, get_fault_mask(3)));
+        }
+
+        // and the pair the right key alone
+        assert (add_pair(session, P, Y));
+        assert (session.pairs == 1 && session.last_round_keys == vector<FlatState> {K10});
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 3... ";
+
+        // several hinted keys: only they are kept, not the mixes of their antidiagonals the first stage lets through
+        KeyHints hints;
+        hints.last_round_keys = {first.front() == K10 ? first.back() : first.front(), K10};
+
+        Session hinted;
+        add_capture(hinted, Y, Y_, {8}, hints, settings);
+        assert (!hinted.last_round_keys.empty());
+        for (auto const& key : hinted.last_round_keys)
+            assert (find(hints.last_round_keys.begin(), hints.last_round_keys.end(), key) != hints.last_round_keys.end());
+        assert (find(hinted.last_round_keys.begin(), hinted.last_round_keys.end(), K10) != hinted.last_round_keys.end());
+
+        cout << "passed !" << endl;
+        cout << endl;
+    }
+
+    void persistence() {
+        char directory_template[] = "/tmp/session.test.XXXXXX";
+        string directory = mkdtemp(directory_template);
+        string path = directory + "/session";
+        string error;
+
+        Session session;
+        session.initialized = true;
+        session.captures = 3;
+        session.pairs = 1;
+        for (u8 i = 0; i < 5; ++i) session.last_round_keys.push_back({i, 1, 2, 3});
+
+        cout << "Testing `session::save` and `session::load`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // no file yet is a fresh session
+        Session loaded;
+        assert (load(path, loaded, error));
+        assert (!loaded.initialized && loaded.last_round_keys.empty());
+
+        assert (save(path, session, error));
+        assert (load(path, loaded, error));
+        assert (loaded.initialized && loaded.captures == 3 && loaded.pairs == 1);
+        assert (loaded.last_round_keys == session.last_round_keys);
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // a key count beyond the file is rejected before any allocation
+        {
+            fstream file(path, ios::binary | ios::in | ios::out);
+            uint64_t key_count = (uint64_t) 1 << 62;
+            file.seekp(offsetof(Header, key_count));
+            file.write((char const*) &key_count, sizeof(key_count));
+        }
+        error = "";
+        assert (!load(path, loaded, error));
+        assert (error.find("truncated") != string::npos);
+
+        // as are a missing key and a foreign file
+        assert (save(path, session, error));
+        {
+            ifstream in(path, ios::binary);
+            string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+            ofstream(path, ios::binary | ios::trunc) << bytes.substr(0, bytes.size() - 1);
+        }
+        assert (!load(path, loaded, error));
+
+        ofstream(path, ios::binary | ios::trunc) << "not a session file at all, long enough for a header";
+        error = "";
+        assert (!load(path, loaded, error));
+        assert (error.find("not a session file") != string::npos);
+
+        remove(path.c_str());
+        rmdir(directory.c_str());
+
+        cout << "passed !" << endl;
+        cout << endl;
+    }
+}
+}
+
+int main() {
+    session::test::refine();
+    session::test::persistence();
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "statistical.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+namespace statistical {
+namespace test {
+    /**
+     * @brief `count` ciphertexts of random plaintexts under `K0`, the byte `fault_position` of the round 10 `SubBytes`
+     * input replaced by `fault(value, random)`.
+     */
+    template<typename Fault>
+    vector<FlatState> faulted_ciphertexts(FlatState const& K0, size_t fault_position, size_t count, Fault fault) {
+        auto keys = key_schedule_from_last_round_key(load(get_last_round_key(K0)));
+
+        uint64_t state = 0x9e3779b97f4a7c15;
+        auto random = [&] {
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+            return state;
+        };
+
+        vector<FlatState> ciphertexts;
+        for (size_t i = 0; i < count; ++i) {
+            __m128i x = _mm_set_epi64x(random(), random());
+
+            x = _mm_xor_si128(x, keys[0]);
+            for (int round = 1; round < 10; ++round) x = _mm_aesenc_si128(x, keys[round]);
+
+            FlatState S = unload(x);
+            S[fault_position] = fault(S[fault_position], random());
+
+            ciphertexts.push_back(unload(_mm_aesenclast_si128(load(S), keys[10])));
+        }
+
+        return ciphertexts;
+    }
+
+    // ShiftRows destination of the round 10 state byte `position`
+    size_t ciphertext_byte(size_t position) {
+        size_t row = position % 4, column = position / 4;
+        return 4 * ((column + 4 - row) % 4) + row;
+    }
+
+    void rank() {
+        FlatState K0 = {0xbb, 0x0f, 0x8a, 0xbe, 0x9d, 0xfc, 0x50, 0x5e, 0xdf, 0x8f, 0xbc, 0xca, 0xd4, 0x83, 0x27, 0xf2};
+        FlatState K10 = get_last_round_key(K0);
+
+        cout << "Testing `statistical::rank`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // low nibble reset
+        for (size_t position : {0, 6, 13}) {
+            auto ciphertexts = faulted_ciphertexts(K0, position, 4000, [](u8 value, uint64_t) { return (u8) (value & 0xf0); });
+            auto counts = histograms(ciphertexts.data(), ciphertexts.size());
+            size_t j = ciphertext_byte(position);
+
+            auto rankings = statistical::rank(counts, Metric::LOW_WEIGHT);
+            assert (rankings[j].best == K10[j]);
+            // the scores being signed, the margin is their difference
+            assert (rankings[j].margin > 0.5);
+
+            // direction-agnostic, the right hypothesis may tie with the complementing one
+            rankings = statistical::rank(counts, Metric::SEI);
+            assert (rankings[j].best == K10[j] || rankings[j].second == K10[j]);
+        }
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // stuck at 0 one time out of 4
+        size_t j = ciphertext_byte(9);
+        auto ciphertexts = faulted_ciphertexts(K0, 9, 20000, [](u8 value, uint64_t r) { return (u8) ((r & 3) == 0 ? 0 : value); });
+        auto counts = histograms(ciphertexts.data(), ciphertexts.size(), 3);
+
+        assert (counts == histograms(ciphertexts.data(), ciphertexts.size(), 1));
+
+        // the runner-ups map 0 to a weight 1 value, scoring 3/4 of the right hypothesis
+        auto rankings = statistical::rank(counts, Metric::LOW_WEIGHT);
+        assert (rankings[j].best == K10[j]);
+        assert (rankings[j].margin > rankings[j].score / 5);
+
+        rankings = statistical::rank(counts, Metric::SEI);
+        assert (rankings[j].best == K10[j] || rankings[j].second == K10[j]);
+
+        // the other bytes were not faulted
+        rankings = statistical::rank(counts, Metric::LOW_WEIGHT);
+        for (size_t i = 0; i < 16; ++i)
+            if (i != j) assert (rankings[i].score < 0.1);
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 3... ";
+
+        // high bits set
+        ciphertexts = faulted_ciphertexts(K0, 4, 4000, [](u8 value, uint64_t) { return (u8) (value | 0xe0); });
+        counts = histograms(ciphertexts.data(), ciphertexts.size());
+        j = ciphertext_byte(4);
+
+        rankings = statistical::rank(counts, Metric::HIGH_WEIGHT);
+        assert (rankings[j].best == K10[j]);
+        assert (rankings[j].margin > 0.5);
+
+        cout << "passed !" << endl;
+    }
+}
+}
+
+int main() {
+    statistical::test::rank();
+    return 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "campaign.hpp"
+
+using namespace std;
+
+/**
+ * Captures shared by the tests.
+ */
+namespace readme {
+    // the README example: a fault at position 8 of the round 8 entry state
+    constexpr FlatState K0 = {0x1e, 0x42, 0x29, 0x78, 0x3f, 0x73, 0xe1, 0x09, 0x91, 0xfd, 0x40, 0xd0, 0x77, 0x9f, 0x98, 0xa6};
+    constexpr FlatState P  = {0x01, 0x75, 0x80, 0x06, 0xf6, 0xc5, 0x7e, 0xa3, 0x2b, 0x4e, 0x7d, 0x6d, 0x06, 0x5f, 0x86, 0xf1};
+    constexpr FlatState Y  = {0x37, 0xc0, 0x93, 0xea, 0x09, 0x42, 0x6c, 0xc9, 0x2d, 0x08, 0x35, 0xb8, 0x87, 0xde, 0x43, 0x06};
+    constexpr FlatState Y_ = {0x45, 0xd4, 0xcf, 0x7f, 0xaa, 0x60, 0xc6, 0x48, 0x97, 0x3f, 0xf0, 0x3e, 0xb1, 0x8a, 0xa2, 0xd3};
+    constexpr size_t fault_position = 8;
+}
+
+/**
+ * @brief Ciphertext of `P` under `K0`, with the byte `fault_position` of the round 8 entry state
+ * (or of its SubBytes output) xored with `e`.
+ */
+inline FlatState encrypt_with_fault(FlatState const& P, FlatState const& K0, size_t fault_position, u8 e, bool at_sbox_output = false) {
+    auto keys = key_schedule_from_last_round_key(load(get_last_round_key(K0)));
+    return campaign::encrypt(P, keys.data(), fault_position, at_sbox_output, [e](u8 byte) { return (u8) (byte ^ e); });
+}
@@ -0,0 +1,111 @@
+#include "tracing.hpp"
+
+#include <omp.h>
+
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace tracing {
+namespace test {
+    size_t occurrences(string const& text, string const& pattern) {
+        size_t count = 0;
+        for (size_t at = text.find(pattern); at != string::npos; at = text.find(pattern, at + 1)) ++count;
+
+        return count;
+    }
+
+    void spans() {
+        cout << "Testing `tracing::Span`..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        // nothing recorded while disabled
+        { Span span("disabled"); }
+        ostringstream os;
+        assert (write_chrome_trace(os) == 0);
+        assert (os.str().find("disabled") == string::npos);
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // one timeline per thread, nested spans within their parent
+        enable(16);
+
+        set<int> threads;
+        #pragma omp parallel num_threads(4)
+        {
+            Span outer("outer");
+            { Span inner("inner"); }
+
+            #pragma omp critical
+            threads.insert(omp_get_thread_num());
+        }
+
+        os.str("");
+        assert (write_chrome_trace(os) == 0);
+        string json = os.str();
+
+        assert (json.rfind("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [", 0) == 0);
+        assert (json.substr(json.size() - 4) == "\n]}\n");
+        assert (occurrences(json, "\"name\": \"outer\", \"ph\": \"X\"") == 4);
+        assert (occurrences(json, "\"name\": \"inner\", \"ph\": \"X\"") == 4);
+        assert (occurrences(json, "\"name\": \"thread_name\", \"ph\": \"M\"") == registry().buffers.size());
+        assert (registry().buffers.size() >= threads.size());
+
+        for (auto const& buffer : registry().buffers) {
+            if (buffer->count == 0) continue;
+
+            // the inner span ends first
+            auto const& inner = buffer->events[0];
+            auto const& outer = buffer->events[1];
+            assert (string(inner.name) == "inner" && string(outer.name) == "outer");
+            assert (outer.start <= inner.start && inner.start + inner.duration <= outer.start + outer.duration);
+        }
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 3... ";
+
+        // full buffers keep the latest spans
+        clear();
+        for (int i = 0; i < 20; ++i) Span span(i < 4 ? "early" : "late");
+
+        os.str("");
+        assert (write_chrome_trace(os) == 4);
+        assert (occurrences(os.str(), "\"name\": \"late\"") == 16);
+        assert (occurrences(os.str(), "\"name\": \"early\"") == 0);
+
+        // interned names outlive their string
+        clear();
+        { Span span(intern(string("phase ") + "io")); }
+        os.str("");
+        write_chrome_trace(os);
+        assert (occurrences(os.str(), "\"name\": \"phase io\"") == 1);
+
+        // spans late in a long run keep their nanoseconds, and the stream its format
+        clear();
+        thread_buffer().push({"late", 123456789012, 1500});
+        os.str("");
+        write_chrome_trace(os);
+        assert (occurrences(os.str(), "\"ts\": 123456789.012, \"dur\": 1.500}") == 1);
+
+        os.str("");
+        os << 1.0 / 3;
+        assert (os.str() == "0.333333");
+
+        disable();
+        cout << "passed !" << endl;
+    }
+}
+}
+
+int main() {
+    tracing::test::spans();
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "tuning.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace tuning {
+namespace test {
+    void round_trip() {
+        string path = "tuning.test.profile";
+        string error;
+
+        Settings settings;
+        settings.engine = Engine::JOIN;
+        settings.kernel = Kernel::INTERLEAVED;
+        settings.threads = 3;
+        settings.chunk = 4;
+        settings.inversion = KeyInversion::AESENCLAST;
+
+        cout << "Testing tuning profile round trip..." << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 1... ";
+
+        assert (save(path, settings, error));
+
+        Settings loaded;
+        assert (load(path, loaded, error));
+        assert (loaded.engine == Engine::JOIN && loaded.kernel == Kernel::INTERLEAVED);
+        assert (loaded.threads == 3 && loaded.chunk == 4);
+        assert (loaded.inversion == KeyInversion::AESENCLAST);
+
+        for (Engine engine : {Engine::SWEEP, Engine::JOIN, Engine::RANGE}) {
+            Engine parsed;
+            assert (parse(to_string(engine), parsed) && parsed == engine);
+        }
+
+        for (KeyInversion inversion : {KeyInversion::AESKEYGENASSIST, KeyInversion::AESENCLAST}) {
+            KeyInversion parsed;
+            assert (parse(to_string(inversion), parsed) && parsed == inversion);
+        }
+
+        for (Kernel kernel : {Kernel::SCALAR, Kernel::INTERLEAVED, Kernel::VAES, Kernel::COLUMN}) {
+            Kernel parsed;
+            assert (parse(to_string(kernel), parsed) && parsed == kernel);
+        }
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 2... ";
+
+        // a profile measured on another CPU is ignored
+        ofstream(path, ios::app) << "cpu=some other CPU" << endl;
+
+        Settings untouched;
+        assert (!load(path, untouched, error));
+        assert (error != "");
+        assert (untouched.engine == Engine::SWEEP && untouched.threads == THREADS);
+
+        cout << "passed !" << endl;
+        //----------------------------------------------------------------------------------------------------
+        cout << "\tTest 3... ";
+
+        // no profile at all is not an error
+        remove(path.c_str());
+        error = "";
+        assert (!load(path, untouched, error));
+        assert (error == "");
+
+        cout << "passed !" << endl;
+    }
+}
+}
+
+int main() {
+    tuning::test::round_trip();
+    return 0;
+}